@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON reports and fails on regressions.
+
+Usage:
+    rasterizer_benchmark --benchmark_out=current.json \\
+        --benchmark_out_format=json
+    compare.py baseline.json current.json [--threshold 0.1]
+
+Benchmarks are matched by name. When a report has repetitions, the median
+aggregate is compared. The exit status is 1 if any benchmark got slower than
+the baseline by more than the threshold, a fraction of the baseline time.
+"""
+
+import argparse
+import json
+import sys
+
+TIME_UNITS = {"ns": 1e-9, "us": 1e-6, "ms": 1e-3, "s": 1.0}
+
+
+def load_times(path, metric):
+    """Returns {name: seconds} of the benchmarks of a report."""
+    with open(path, encoding="utf-8") as file:
+        report = json.load(file)
+
+    times = {}
+    medians = {}
+    for benchmark in report["benchmarks"]:
+        seconds = benchmark[metric] * TIME_UNITS[benchmark["time_unit"]]
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[benchmark["run_name"]] = seconds
+        else:
+            times.setdefault(benchmark.get("run_name", benchmark["name"]),
+                             seconds)
+    times.update(medians)
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="JSON report of the reference build")
+    parser.add_argument("current", help="JSON report of the build to check")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="allowed slowdown, 0.1 is 10%% (default)")
+    parser.add_argument("--metric", choices=["real_time", "cpu_time"],
+                        default="real_time", help="time to compare")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline, args.metric)
+    current = load_times(args.current, args.metric)
+
+    regressions = []
+    name_width = max((len(name) for name in current), default=0)
+    print(f"{'Benchmark':<{name_width}}  {'Baseline':>12}  {'Current':>12}"
+          f"  {'Change':>8}")
+    for name, seconds in current.items():
+        if name not in baseline:
+            print(f"{name:<{name_width}}  {'-':>12}  {seconds * 1e6:>10.2f}us"
+                  f"  {'new':>8}")
+            continue
+        change = seconds / baseline[name] - 1
+        flag = ""
+        if change > args.threshold:
+            regressions.append(name)
+            flag = "  REGRESSION"
+        print(f"{name:<{name_width}}  {baseline[name] * 1e6:>10.2f}us"
+              f"  {seconds * 1e6:>10.2f}us  {change:>+8.1%}{flag}")
+    for name in baseline.keys() - current.keys():
+        print(f"{name}: missing from {args.current}")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) regressed by more than "
+              f"{args.threshold:.0%}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
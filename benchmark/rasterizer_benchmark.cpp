@@ -0,0 +1,433 @@
+#include <benchmark/benchmark.h>
+
+#include "framebuffer.hpp"
+#include "image_io.hpp"
+#include "mesh_cache.hpp"
+#include "rasterizer.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include "upload_ring.hpp"
+#include "vertex_processing.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <beyond/math/transform.hpp>
+
+namespace {
+
+constexpr const char* model_filename = "assets/model/african_head.obj";
+constexpr int width = 1200;
+constexpr int height = 800;
+constexpr yasr::Rect viewport{{0, 0}, {width, height}};
+
+enum class MeshKind : std::int64_t {
+  /// african_head.obj through the mesh cache
+  head,
+  /// A 256x256 quad grid facing the camera
+  grid,
+};
+
+auto mesh(MeshKind kind) -> const yasr::Mesh&
+{
+  static const yasr::Mesh head = [] {
+    const yasr::CachedMesh cached = yasr::load_cached_mesh(model_filename);
+    return yasr::Mesh{
+        .vertices = {cached.vertices().begin(), cached.vertices().end()},
+        .indices = {cached.indices().begin(), cached.indices().end()},
+    };
+  }();
+  static const yasr::Mesh grid = [] {
+    constexpr std::uint32_t n = 256;
+    yasr::Mesh result;
+    for (std::uint32_t y = 0; y <= n; ++y) {
+      for (std::uint32_t x = 0; x <= n; ++x) {
+        const float u = static_cast<float>(x) / n;
+        const float v = static_cast<float>(y) / n;
+        result.vertices.push_back(Vertex{.pos = {u * 2 - 1, v * 2 - 1, 0},
+                                         .normal = {0, 0, 1},
+                                         .texcoord = {u, v}});
+      }
+    }
+    for (std::uint32_t y = 0; y < n; ++y) {
+      for (std::uint32_t x = 0; x < n; ++x) {
+        const std::uint32_t i = y * (n + 1) + x;
+        result.indices.insert(result.indices.end(),
+                              {i, i + 1, i + n + 2, i, i + n + 2, i + n + 1});
+      }
+    }
+    return result;
+  }();
+  return kind == MeshKind::head ? head : grid;
+}
+
+auto view_projection() -> beyond::Mat4
+{
+  const yasr::Camera camera;
+  const auto view = beyond::look_at(camera.eye, camera.target, camera.up);
+  const auto proj = beyond::perspective(
+      camera.fov_y, static_cast<float>(width) / static_cast<float>(height),
+      camera.z_near, camera.z_far);
+  return proj * view;
+}
+
+/// A 1024x1024 checkerboard of 8x8 texel squares
+auto checker_desc() -> yasr::TextureDesc
+{
+  constexpr std::uint32_t size = 1024;
+  static const std::vector<std::byte> texels = [] {
+    std::vector<std::byte> result(std::size_t{size} * size * 4);
+    for (std::uint32_t y = 0; y < size; ++y) {
+      for (std::uint32_t x = 0; x < size; ++x) {
+        const auto value = ((x / 8 + y / 8) % 2) != 0 ? std::byte{255}
+                                                        : std::byte{32};
+        const std::size_t offset = (std::size_t{y} * size + x) * 4;
+        result[offset + 0] = value;
+        result[offset + 1] = value;
+        result[offset + 2] = value;
+        result[offset + 3] = std::byte{255};
+      }
+    }
+    return result;
+  }();
+  return yasr::TextureDesc{.width = size,
+                           .height = size,
+                           .format = yasr::TextureFormat::rgba8_srgb,
+                           .data = texels};
+}
+
+auto checker_texture() -> const yasr::TextureStorage&
+{
+  static const yasr::TextureStorage texture{checker_desc()};
+  return texture;
+}
+
+void BM_VertexTransform(benchmark::State& state)
+{
+  const yasr::Mesh& source = mesh(static_cast<MeshKind>(state.range(0)));
+  yasr::VertexCache cache;
+  cache.build(source.indices, source.vertices.size());
+  yasr::PostTransformVertices out;
+  yasr::ThreadPool thread_pool{1};
+  const beyond::Mat4 mvp = view_projection();
+
+  for (auto _ : state) {
+    yasr::transform_vertices(mvp, source.vertices, cache.unique_vertices(),
+                             viewport, out, thread_pool);
+    benchmark::DoNotOptimize(out.x.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(
+                              cache.unique_vertices().size()));
+}
+BENCHMARK(BM_VertexTransform)
+    ->ArgName("mesh")
+    ->Arg(static_cast<std::int64_t>(MeshKind::head))
+    ->Arg(static_cast<std::int64_t>(MeshKind::grid));
+
+void BM_TriangleSetup(benchmark::State& state)
+{
+  const yasr::Mesh& source = mesh(static_cast<MeshKind>(state.range(0)));
+  yasr::VertexCache cache;
+  cache.build(source.indices, source.vertices.size());
+  yasr::PostTransformVertices post;
+  yasr::ThreadPool thread_pool{1};
+  yasr::transform_vertices(view_projection(), source.vertices,
+                           cache.unique_vertices(), viewport, post,
+                           thread_pool);
+
+  const std::size_t triangle_count = source.indices.size() / 3;
+  std::vector<yasr::TriangleSetup> setups(triangle_count);
+  for (auto _ : state) {
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+      std::array<yasr::ScreenVertex, 3> vertices;
+      for (std::size_t j = 0; j < 3; ++j) {
+        const std::uint32_t index = source.indices[3 * t + j];
+        const std::uint32_t slot = cache.slot(index);
+        vertices[j] = yasr::ScreenVertex{
+            .pos = {post.x[slot], post.y[slot], post.z[slot]},
+            .inv_w = post.inv_w[slot],
+            .uv = source.vertices[index].texcoord,
+        };
+      }
+      setups[t] = yasr::setup_triangle(vertices, viewport, RGB(1, 1, 1))
+                      .value_or(yasr::TriangleSetup{});
+    }
+    benchmark::DoNotOptimize(setups.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(triangle_count));
+}
+BENCHMARK(BM_TriangleSetup)
+    ->ArgName("mesh")
+    ->Arg(static_cast<std::int64_t>(MeshKind::head))
+    ->Arg(static_cast<std::int64_t>(MeshKind::grid));
+
+/**
+ * Rasterizes and shades right triangles whose legs are `size` pixels long, or
+ * one triangle covering the whole screen for a size of 0. Every triangle is
+ * nearer than the previous one, so no fragment fails the depth test.
+ */
+void BM_Fill(benchmark::State& state)
+{
+  const auto size = static_cast<float>(state.range(0));
+  std::vector<yasr::TriangleSetup> setups;
+  if (size == 0) {
+    const float extent = 2.f * static_cast<float>(width + height);
+    setups.push_back(*yasr::setup_triangle(
+        {yasr::ScreenVertex{.pos = {0, 0, 0}, .uv = {0, 1}},
+         yasr::ScreenVertex{.pos = {extent, 0, 0}, .uv = {2, 1}},
+         yasr::ScreenVertex{.pos = {0, extent, 0}, .uv = {0, -1}}},
+        viewport, RGB(1, 1, 1)));
+  } else {
+    // A grid of triangles spread over the screen, offset from pixel centres
+    constexpr int triangle_count = 1024;
+    constexpr int columns = 32;
+    constexpr int rows = triangle_count / columns;
+    const float step_x = static_cast<float>(width) / columns;
+    const float step_y = static_cast<float>(height) / rows;
+    for (int i = 0; i < triangle_count; ++i) {
+      const float x = static_cast<float>(i % columns) * step_x + 0.25f;
+      const float y = static_cast<float>(i / columns) * step_y + 0.25f;
+      setups.push_back(*yasr::setup_triangle(
+          {yasr::ScreenVertex{.pos = {x, y, 0}, .uv = {0, 1}},
+           yasr::ScreenVertex{.pos = {x + size, y, 0}, .uv = {1, 1}},
+           yasr::ScreenVertex{.pos = {x, y + size, 0}, .uv = {0, 0}}},
+          viewport, RGB(1, 1, 1)));
+    }
+  }
+
+  yasr::FramebufferStorage framebuffer{width, height};
+  framebuffer.resolve_all_clears();
+  const yasr::TextureView texture =
+      checker_texture().view(yasr::TextureFilter::trilinear);
+  yasr::PipelineStats stats;
+  float depth = 0;
+
+  for (auto _ : state) {
+    for (yasr::TriangleSetup setup : setups) {
+      depth += 1;
+      setup.z0 = depth;
+      setup.max_z = depth;
+      const yasr::Rect& bounds = setup.bounds;
+      for (int tile_y = bounds.min.y / yasr::tile_size;
+           tile_y <= (bounds.max.y - 1) / yasr::tile_size; ++tile_y) {
+        for (int tile_x = bounds.min.x / yasr::tile_size;
+             tile_x <= (bounds.max.x - 1) / yasr::tile_size; ++tile_x) {
+          const std::size_t tile_index = static_cast<std::size_t>(
+              tile_y * framebuffer.tile_count_x() + tile_x);
+          yasr::rasterize_triangle(setup, framebuffer.tile_rect(tile_index),
+                                   framebuffer.depth(),
+                                   framebuffer.coarse_depth(),
+                                   framebuffer.color_target(), texture,
+                                   stats);
+        }
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(setups.size()));
+}
+BENCHMARK(BM_Fill)->ArgName("size")->Arg(1)->Arg(16)->Arg(0);
+
+void BM_TextureSample(benchmark::State& state)
+{
+  const yasr::TextureView texture = checker_texture().view(
+      static_cast<yasr::TextureFilter>(state.range(0)));
+
+  constexpr int sample_count = 4096;
+  std::vector<std::array<float, 3>> coordinates(sample_count);
+  std::uint32_t seed = 1;
+  const auto next = [&] {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+  };
+  for (auto& [u, v, lod] : coordinates) {
+    u = next();
+    v = next();
+    lod = next() * 4;
+  }
+
+  for (auto _ : state) {
+    float sum = 0;
+    for (const auto& [u, v, lod] : coordinates) {
+      sum += yasr::sample(texture, u, v, lod).r;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * sample_count);
+}
+BENCHMARK(BM_TextureSample)
+    ->ArgName("filter")
+    ->Arg(static_cast<std::int64_t>(yasr::TextureFilter::nearest))
+    ->Arg(static_cast<std::int64_t>(yasr::TextureFilter::bilinear))
+    ->Arg(static_cast<std::int64_t>(yasr::TextureFilter::trilinear));
+
+void BM_DepthClear(benchmark::State& state)
+{
+  yasr::FramebufferStorage framebuffer{width, height};
+  for (auto _ : state) {
+    framebuffer.clear(yasr::ClearValue{});
+    framebuffer.resolve_all_clears();
+    benchmark::DoNotOptimize(framebuffer.depth().data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_DepthClear);
+
+/// The copy of a frame into the window texture, from a float or a packed
+/// color attachment
+void BM_CopyToScreen(benchmark::State& state)
+{
+  yasr::FramebufferStorage framebuffer{
+      width, height, static_cast<yasr::ColorFormat>(state.range(0))};
+  framebuffer.resolve_all_clears();
+  std::vector<std::uint32_t> pixels(std::size_t{width} * height);
+  for (auto _ : state) {
+    yasr::encode_xrgb8(framebuffer.color_view(),
+                       std::as_writable_bytes(std::span(pixels)),
+                       std::size_t{width} * 4);
+    benchmark::DoNotOptimize(pixels.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * width * height);
+}
+BENCHMARK(BM_CopyToScreen)
+    ->ArgName("format")
+    ->Arg(static_cast<int>(yasr::ColorFormat::rgb32_float))
+    ->Arg(static_cast<int>(yasr::ColorFormat::bgra8_srgb));
+
+/// Draws whole frames of the sample scene, optionally with the edges of its
+/// triangles as lines on top, and reports the fragments shaded per frame
+void draw_frames(benchmark::State& state, std::uint32_t thread_count,
+                 yasr::ShadingMode shading_mode, bool wireframe = false)
+{
+  const auto device =
+      yasr::Device::create(yasr::DeviceDesc{.thread_count = thread_count});
+  const yasr::Mesh& head = mesh(MeshKind::head);
+  auto vertex_buffer = yasr::create_unique_buffer(
+      *device,
+      yasr::BufferDesc{.data = std::as_bytes(std::span(head.vertices))});
+  auto index_buffer = yasr::create_unique_buffer(
+      *device,
+      yasr::BufferDesc{.data = std::as_bytes(std::span(head.indices))});
+  const std::vector<std::uint32_t> edges =
+      yasr::wireframe_indices(head.indices);
+  auto edge_buffer = yasr::create_unique_buffer(
+      *device, yasr::BufferDesc{.data = std::as_bytes(std::span(edges))});
+  auto texture = yasr::create_unique_texture(*device, checker_desc());
+  auto framebuffer = yasr::create_unique_framebuffer(
+      *device, yasr::FramebufferDesc{.width = width, .height = height});
+  device->bind_framebuffer(framebuffer);
+  device->bind_vertex_buffer(vertex_buffer);
+  device->bind_texture(texture);
+  device->set_shading_mode(shading_mode);
+
+  for (auto _ : state) {
+    device->begin_frame();
+    device->clear(yasr::ClearValue{});
+    device->bind_index_buffer(index_buffer);
+    device->set_topology(yasr::Topology::triangles);
+    device->draw_indexed();
+    if (wireframe) {
+      device->bind_index_buffer(edge_buffer);
+      device->set_topology(yasr::Topology::lines);
+      device->draw_indexed();
+    }
+    benchmark::DoNotOptimize(device->framebuffer_color(framebuffer).pixels);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(head.indices.size() / 3));
+  state.counters["shaded"] =
+      static_cast<double>(device->pipeline_stats().fragments_shaded);
+}
+
+/// A whole frame of the sample scene, with 1 or all hardware threads
+void BM_DrawIndexed(benchmark::State& state)
+{
+  draw_frames(state, static_cast<std::uint32_t>(state.range(0)),
+              yasr::ShadingMode::immediate);
+}
+BENCHMARK(BM_DrawIndexed)
+    ->ArgName("threads")
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// The frame of BM_DrawIndexed with a depth and visibility pass before
+/// shading, on all hardware threads
+void BM_DrawIndexedVisibilityBuffer(benchmark::State& state)
+{
+  draw_frames(state, 0, yasr::ShadingMode::visibility_buffer);
+}
+BENCHMARK(BM_DrawIndexedVisibilityBuffer)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/// The frame of BM_DrawIndexed with its wireframe drawn over it, on all
+/// hardware threads
+void BM_Wireframe(benchmark::State& state)
+{
+  draw_frames(state, 0, yasr::ShadingMode::immediate, true);
+}
+BENCHMARK(BM_Wireframe)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/// The frame of BM_DrawIndexed with the mesh written into an upload ring every
+/// frame, as an animated mesh would be, and submitted without waiting
+void BM_StreamedDraw(benchmark::State& state)
+{
+  const auto device = yasr::Device::create();
+  const yasr::Mesh& head = mesh(MeshKind::head);
+  auto texture = yasr::create_unique_texture(*device, checker_desc());
+  auto framebuffer = yasr::create_unique_framebuffer(
+      *device, yasr::FramebufferDesc{.width = width, .height = height});
+  const std::size_t frame_bytes = head.vertices.size() * sizeof(Vertex) +
+                                  head.indices.size() * sizeof(std::uint32_t);
+  yasr::UploadRing ring{
+      *device,
+      {.frame_size = frame_bytes + 2 * yasr::UploadRing::alignment}};
+
+  yasr::Fence fence;
+  for (auto _ : state) {
+    ring.begin_frame();
+    const yasr::Upload<Vertex> vertices =
+        ring.allocate<Vertex>(head.vertices.size());
+    std::ranges::copy(head.vertices, vertices.data.begin());
+    const yasr::Upload<std::uint32_t> indices =
+        ring.allocate<std::uint32_t>(head.indices.size());
+    std::ranges::copy(head.indices, indices.data.begin());
+
+    yasr::CommandBuffer commands = device->acquire_command_buffer();
+    commands.bind_framebuffer(framebuffer);
+    commands.bind_vertex_buffer(vertices.buffer, vertices.offset,
+                                vertices.data.size_bytes());
+    commands.bind_index_buffer(indices.buffer, indices.offset,
+                               indices.data.size_bytes());
+    commands.bind_texture(texture);
+    commands.clear(yasr::ClearValue{});
+    commands.draw_indexed();
+    fence = device->submit(std::move(commands));
+    ring.end_frame(fence);
+  }
+  device->wait(fence);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(head.indices.size() / 3));
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<std::int64_t>(frame_bytes));
+}
+BENCHMARK(BM_StreamedDraw)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // anonymous namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,285 @@
+#include "app.hpp"
+#include "mesh_cache.hpp"
+#include "model.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include <beyond/math/function.hpp>
+#include <beyond/utils/bit_cast.hpp>
+#include <beyond/utils/panic.hpp>
+
+#include <SDL2/SDL_image.h>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+namespace {
+
+constexpr std::uint32_t initial_width = 1200;
+constexpr std::uint32_t initial_height = 800;
+
+void log_pipeline_stats(const yasr::PipelineStats& stats)
+{
+  spdlog::info("Vertices: {} input, {} processed ({:.1f}% reused)",
+               stats.input_vertices, stats.vertices_processed,
+               stats.vertex_reuse() * 100);
+  spdlog::info("Triangles: {} submitted, {} culled, {} culled by Hi-Z",
+               stats.triangles_submitted, stats.triangles_culled,
+               stats.hiz_triangles_culled);
+  spdlog::info("Fragments: {} tested, {} passed, {} texels fetched",
+               stats.fragments_tested, stats.fragments_passed,
+               stats.texels_fetched);
+}
+
+/// Logs the average frame time and the average time of every stage
+void log_frame_times(const yasr::Profiler& profiler, std::uint32_t frames,
+                     Milliseconds elapsed)
+{
+  const yasr::Profiler::StageTimes times = profiler.stage_times();
+  std::string stages;
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    stages += fmt::format(
+        ", {} {:.3f}",
+        yasr::stage_name(static_cast<yasr::PipelineStage>(i)),
+        Milliseconds{times[i]}.count() / frames);
+  }
+  spdlog::info("{:.2f} ms/frame{}", elapsed.count() / frames, stages);
+}
+
+/// A framebuffer laid out like the window texture
+auto create_window_framebuffer(yasr::Device& device, std::uint32_t width,
+                               std::uint32_t height) -> yasr::UniqueFramebuffer
+{
+  return yasr::create_unique_framebuffer(
+      device, yasr::FramebufferDesc{.width = width,
+                                    .height = height,
+                                    .format = yasr::ColorFormat::bgra8_srgb});
+}
+
+} // namespace
+
+App::App()
+    : device_{yasr::Device::create()},
+      width_{initial_width},
+      height_{initial_height},
+      framebuffers_{create_window_framebuffer(*device_, width_, height_),
+                    create_window_framebuffer(*device_, width_, height_)}
+{
+  if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
+    spdlog::critical("[SDL2] Unable to initialize SDL: {}", SDL_GetError());
+    std::exit(1);
+  }
+
+  if (SDL_CreateWindowAndRenderer(static_cast<int>(width_),
+                                  static_cast<int>(height_),
+                                  SDL_WINDOW_RESIZABLE, &window_,
+                                  &renderer_) != 0) {
+    spdlog::critical("[SDL2] Couldn't create window and renderer: {}",
+                     SDL_GetError());
+    std::exit(1);
+  }
+  SDL_SetWindowTitle(window_, "Yet Another Software Rasterizer");
+  create_window_texture();
+
+  constexpr const char* model_filename = "assets/model/african_head.obj";
+
+  const yasr::CachedMesh mesh = yasr::load_cached_mesh(model_filename);
+  spdlog::info("{}: {} vertices, {} indices, ACMR {:.3f}", model_filename,
+               mesh.vertices().size(), mesh.indices().size(),
+               yasr::average_cache_miss_ratio(mesh.indices(),
+                                              mesh.vertices().size()));
+
+  vertex_buffer_ = yasr::create_unique_buffer(
+      *device_, yasr::BufferDesc{.data = std::as_bytes(mesh.vertices())});
+  index_buffer_ = yasr::create_unique_buffer(
+      *device_, yasr::BufferDesc{.data = std::as_bytes(mesh.indices())});
+
+  constexpr const char* diffuse_texture_filename =
+      "assets/textures/african_head_diffuse.tga";
+  int texture_width = 0;
+  int texture_height = 0;
+  int texture_channels = 0;
+  stbi_uc* texels = stbi_load(diffuse_texture_filename, &texture_width,
+                              &texture_height, &texture_channels, 4);
+  if (texels == nullptr) {
+    beyond::panic(fmt::format("Cannot load texture {}: {}",
+                              diffuse_texture_filename,
+                              stbi_failure_reason()));
+  }
+  diffuse_texture_ = yasr::create_unique_texture(
+      *device_,
+      yasr::TextureDesc{
+          .width = static_cast<std::uint32_t>(texture_width),
+          .height = static_cast<std::uint32_t>(texture_height),
+          .format = yasr::TextureFormat::rgba8_srgb,
+          .data = std::span(beyond::bit_cast<std::byte*>(texels),
+                            static_cast<std::size_t>(texture_width) *
+                                texture_height * 4)});
+  stbi_image_free(texels);
+
+  // The first frame is rendered up front, so render() always has a finished
+  // frame to present
+  device_->begin_frame();
+  submit_frame();
+  device_->wait(fences_[0]);
+  log_pipeline_stats(device_->pipeline_stats());
+}
+
+App::~App()
+{
+  for (const yasr::Fence fence : fences_) { device_->wait(fence); }
+
+  SDL_DestroyTexture(window_texture_);
+
+  SDL_DestroyRenderer(renderer_);
+  SDL_DestroyWindow(window_);
+  SDL_Quit();
+}
+
+auto App::update(const Milliseconds& delta_time) -> void
+{
+  handle_input();
+  render(delta_time);
+
+  // Stage times accumulate until the next report, about once a second
+  ++frames_since_report_;
+  time_since_report_ += delta_time;
+  if (time_since_report_ >= std::chrono::seconds{1}) {
+    log_frame_times(device_->profiler(), frames_since_report_,
+                    time_since_report_);
+    if (dynamic_resolution_enabled_) {
+      spdlog::info("Internal resolution {}x{}",
+                   dynamic_resolution_.scaled(width_),
+                   dynamic_resolution_.scaled(height_));
+    }
+    device_->begin_frame();
+    frames_since_report_ = 0;
+    time_since_report_ = {};
+  }
+}
+
+auto App::render(const Milliseconds& delta_time) -> void
+{
+  if (dynamic_resolution_enabled_) { dynamic_resolution_.update(delta_time); }
+
+  // The previous frame is presented while the device renders this one
+  submit_frame();
+  const std::size_t previous = (frame_index_ - 2) % framebuffer_count;
+  device_->wait(fences_[previous]);
+  present(previous);
+}
+
+auto App::submit_frame() -> void
+{
+  const std::size_t index = frame_index_ % framebuffer_count;
+  viewports_[index] =
+      yasr::Region{.width = dynamic_resolution_.scaled(width_),
+                   .height = dynamic_resolution_.scaled(height_)};
+  yasr::CommandBuffer commands = device_->acquire_command_buffer();
+  commands.bind_framebuffer(framebuffers_[index]);
+  commands.set_viewport(viewports_[index]);
+  commands.bind_vertex_buffer(*vertex_buffer_);
+  commands.bind_index_buffer(*index_buffer_);
+  commands.bind_texture(*diffuse_texture_);
+  commands.clear(yasr::ClearValue{});
+  commands.draw_indexed();
+  fences_[index] = device_->submit(std::move(commands));
+  ++frame_index_;
+}
+
+auto App::present(std::size_t index) -> void
+{
+  const yasr::ColorView color =
+      device_->framebuffer_color(framebuffers_[index]);
+  const yasr::Region& viewport = viewports_[index];
+  const SDL_Rect rect{viewport.x, viewport.y,
+                      static_cast<int>(viewport.width),
+                      static_cast<int>(viewport.height)};
+
+  // The framebuffer is laid out like the window texture, so only the viewport
+  // is uploaded, without a conversion pass
+  const yasr::ScopedTimer timer{device_->profiler(),
+                                yasr::PipelineStage::present};
+  const std::size_t offset =
+      static_cast<std::size_t>(rect.y) * static_cast<std::size_t>(color.width) +
+      static_cast<std::size_t>(rect.x);
+  const std::byte* const pixels =
+      static_cast<const std::byte*>(color.pixels) + offset * 4;
+  if (SDL_UpdateTexture(window_texture_, &rect, pixels, color.width * 4) !=
+      0) {
+    spdlog::error("[SDL2] Couldn't update the screen texture: {}",
+                  SDL_GetError());
+  }
+  SDL_RenderClear(renderer_);
+  SDL_RenderCopy(renderer_, window_texture_, &rect, nullptr);
+  SDL_RenderPresent(renderer_);
+}
+
+auto App::create_window_texture() -> void
+{
+  window_texture_ = SDL_CreateTexture(
+      renderer_, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STREAMING,
+      static_cast<int>(width_), static_cast<int>(height_));
+  if (!window_texture_) {
+    spdlog::critical("[SDL2] Couldn't create texture: {}", SDL_GetError());
+    std::exit(1);
+  }
+}
+
+auto App::resize(std::uint32_t width, std::uint32_t height) -> void
+{
+  // Minimized windows have no area, and keep their framebuffers
+  if (width == 0 || height == 0 || (width == width_ && height == height_)) {
+    return;
+  }
+  // The frames in flight render to the old framebuffers
+  for (const yasr::Fence fence : fences_) { device_->wait(fence); }
+
+  width_ = width;
+  height_ = height;
+  for (auto& framebuffer : framebuffers_) {
+    framebuffer = create_window_framebuffer(*device_, width_, height_);
+  }
+  SDL_DestroyTexture(window_texture_);
+  create_window_texture();
+
+  // render() presents the frame before the one it submits, which has to be
+  // in the new framebuffers as well
+  submit_frame();
+}
+
+auto App::handle_input() -> void
+{
+  // Resizing by dragging sends many events, only the last size is rendered
+  std::optional<std::pair<int, int>> window_size;
+  SDL_Event sdl_event;
+  while (SDL_PollEvent(&sdl_event) != 0) {
+    switch (sdl_event.type) {
+    case SDL_KEYDOWN:
+      if (sdl_event.key.keysym.sym == SDLK_ESCAPE) { should_close_ = true; }
+      if (sdl_event.key.keysym.sym == SDLK_r) {
+        // Disabling goes back to the full resolution
+        dynamic_resolution_enabled_ = !dynamic_resolution_enabled_;
+        dynamic_resolution_ = yasr::DynamicResolution{};
+        spdlog::info("Dynamic resolution {}",
+                     dynamic_resolution_enabled_ ? "on" : "off");
+      }
+      break;
+    case SDL_WINDOWEVENT:
+      if (sdl_event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        window_size.emplace(sdl_event.window.data1, sdl_event.window.data2);
+      }
+      break;
+    case SDL_QUIT:
+      should_close_ = true;
+      break;
+    }
+  }
+  if (window_size) {
+    resize(static_cast<std::uint32_t>(std::max(window_size->first, 0)),
+           static_cast<std::uint32_t>(std::max(window_size->second, 0)));
+  }
+}
\ No newline at end of file
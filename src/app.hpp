@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef YASR_APP_HPP
+#define YASR_APP_HPP
+
+#include <SDL2/SDL.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "dynamic_resolution.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+class App {
+  SDL_Window* window_ = nullptr;
+  SDL_Renderer* renderer_ = nullptr;
+  SDL_Texture* window_texture_ = nullptr;
+  bool should_close_ = false;
+
+  // Resources must be destroyed before the device that owns them
+  std::unique_ptr<yasr::Device> device_;
+  std::optional<yasr::UniqueBuffer> vertex_buffer_;
+  std::optional<yasr::UniqueBuffer> index_buffer_;
+  std::optional<yasr::UniqueTexture> diffuse_texture_;
+
+  // Frames cycle through the framebuffers, which have the size of the
+  // window. The window shows one while the device renders the next.
+  static constexpr std::size_t framebuffer_count = 2;
+  std::uint32_t width_ = 0;
+  std::uint32_t height_ = 0;
+  std::array<yasr::UniqueFramebuffer, framebuffer_count> framebuffers_;
+  /// The part of each framebuffer its last frame was rendered to
+  std::array<yasr::Region, framebuffer_count> viewports_{};
+  std::array<yasr::Fence, framebuffer_count> fences_{};
+  std::uint64_t frame_index_ = 0;
+
+  // Frames render to a viewport scaled by the dynamic resolution, and the
+  // window stretches it to its size
+  yasr::DynamicResolution dynamic_resolution_;
+  bool dynamic_resolution_enabled_ = false;
+
+  std::uint32_t frames_since_report_ = 0;
+  Milliseconds time_since_report_{};
+
+  /// Records the next frame into the next framebuffer and submits it
+  auto submit_frame() -> void;
+  /// Shows the viewport of the framebuffer `index`, scaled to the window
+  auto present(std::size_t index) -> void;
+  auto create_window_texture() -> void;
+  /// Replaces the framebuffers and the window texture after the window
+  /// changed size
+  auto resize(std::uint32_t width, std::uint32_t height) -> void;
+
+public:
+  App();
+  ~App();
+
+  App(const App&) = delete;
+  auto operator=(const App&) & noexcept = delete;
+  App(App&&) noexcept = delete;
+  auto operator=(App&&) & noexcept = delete;
+
+  auto update(const Milliseconds& delta_time) -> void;
+  auto render(const Milliseconds& delta_time) -> void;
+  auto handle_input() -> void;
+
+  [[nodiscard]] auto should_close() const -> bool
+  {
+    return should_close_;
+  }
+};
+
+#endif // YASR_APP_HPP
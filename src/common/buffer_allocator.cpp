@@ -0,0 +1,75 @@
+#include "buffer_allocator.hpp"
+
+#include <bit>
+#include <utility>
+
+namespace yasr {
+
+auto BufferAllocator::size_class(std::size_t size) noexcept -> std::size_t
+{
+  const std::size_t block_size = std::bit_ceil(size);
+  if (block_size <= min_block_size) { return 0; }
+  return static_cast<std::size_t>(std::countr_zero(block_size) -
+                                  std::countr_zero(min_block_size));
+}
+
+auto BufferAllocator::allocate_aligned(std::size_t size) -> std::byte*
+{
+  return static_cast<std::byte*>(
+      ::operator new[](size, std::align_val_t{alignment}));
+}
+
+auto BufferAllocator::allocate(std::size_t size) -> std::span<std::byte>
+{
+  if (size == 0) { return {}; }
+  if (size > max_block_size) {
+    std::byte* const memory = allocate_aligned(size);
+    reserved_bytes_ += size;
+    return {memory, size};
+  }
+
+  const std::size_t block_class = size_class(size);
+  auto& free_blocks = free_blocks_[block_class];
+  if (free_blocks.empty()) { return {carve(block_class), size}; }
+  std::byte* const memory = free_blocks.back();
+  free_blocks.pop_back();
+  return {memory, size};
+}
+
+void BufferAllocator::deallocate(std::span<std::byte> block)
+{
+  if (block.empty()) { return; }
+  if (block.size() > max_block_size) {
+    reserved_bytes_ -= block.size();
+    AlignedDelete{}(block.data());
+    return;
+  }
+  free_blocks_[size_class(block.size())].push_back(block.data());
+}
+
+auto BufferAllocator::carve(std::size_t block_class) -> std::byte*
+{
+  const std::size_t block_size = min_block_size << block_class;
+  if (arena_remaining_ < block_size) {
+    // The tail of the old arena is split into the largest blocks that fit,
+    // which keep the 64-byte alignment since every size is a multiple of it
+    while (arena_remaining_ != 0) {
+      const std::size_t tail_size = std::bit_floor(arena_remaining_);
+      free_blocks_[size_class(tail_size)].push_back(arena_cursor_);
+      arena_cursor_ += tail_size;
+      arena_remaining_ -= tail_size;
+    }
+    AlignedMemory arena{allocate_aligned(arena_size)};
+    arenas_.push_back(std::move(arena));
+    arena_cursor_ = arenas_.back().get();
+    arena_remaining_ = arena_size;
+    reserved_bytes_ += arena_size;
+  }
+
+  std::byte* const memory = arena_cursor_;
+  arena_cursor_ += block_size;
+  arena_remaining_ -= block_size;
+  return memory;
+}
+
+} // namespace yasr
@@ -0,0 +1,80 @@
+#ifndef YASR_BUFFER_ALLOCATOR_HPP
+#define YASR_BUFFER_ALLOCATOR_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace yasr {
+
+/**
+ * \brief Pools 64-byte aligned blocks for buffer storage
+ *
+ * Blocks come in power-of-two size classes from 64 bytes to 1 MiB and are
+ * carved out of 4 MiB arenas. Freed blocks return to the free list of their
+ * class for the next allocation of that class to reuse, so recreating
+ * buffers of similar sizes, such as per-frame constants, reaches the heap
+ * only while the pools warm up. Larger blocks get an allocation of their
+ * own.
+ *
+ * Not thread-safe; the device allocates under its resource lock.
+ */
+class BufferAllocator {
+public:
+  static constexpr std::size_t alignment = 64;
+  static constexpr std::size_t min_block_size = alignment;
+  static constexpr std::size_t max_block_size = std::size_t{1} << 20;
+  static constexpr std::size_t arena_size = std::size_t{4} << 20;
+
+  BufferAllocator() = default;
+  ~BufferAllocator() = default;
+
+  BufferAllocator(const BufferAllocator&) = delete;
+  auto operator=(const BufferAllocator&) & -> BufferAllocator& = delete;
+  BufferAllocator(BufferAllocator&&) noexcept = delete;
+  auto operator=(BufferAllocator&&) & noexcept -> BufferAllocator& = delete;
+
+  /// A block of `size` bytes aligned to `alignment`, empty if `size` is 0
+  [[nodiscard]] auto allocate(std::size_t size) -> std::span<std::byte>;
+  /// Returns a block of allocate() to its pool
+  void deallocate(std::span<std::byte> block);
+
+  /// Bytes of the arenas and of the blocks too large for them
+  [[nodiscard]] auto reserved_bytes() const noexcept -> std::size_t
+  {
+    return reserved_bytes_;
+  }
+
+private:
+  struct AlignedDelete {
+    void operator()(std::byte* memory) const noexcept
+    {
+      ::operator delete[](memory, std::align_val_t{alignment});
+    }
+  };
+  using AlignedMemory = std::unique_ptr<std::byte[], AlignedDelete>;
+
+  // Classes of 64 << i bytes
+  static constexpr std::size_t class_count = 15;
+  static_assert(min_block_size << (class_count - 1) == max_block_size);
+
+  std::vector<AlignedMemory> arenas_;
+  std::array<std::vector<std::byte*>, class_count> free_blocks_;
+  std::byte* arena_cursor_ = nullptr;
+  std::size_t arena_remaining_ = 0;
+  std::size_t reserved_bytes_ = 0;
+
+  [[nodiscard]] static auto size_class(std::size_t size) noexcept
+      -> std::size_t;
+  [[nodiscard]] static auto allocate_aligned(std::size_t size) -> std::byte*;
+  /// Carves a block of `block_class` out of the current arena, starting a
+  /// new one if it is too full
+  [[nodiscard]] auto carve(std::size_t block_class) -> std::byte*;
+};
+
+} // namespace yasr
+
+#endif // YASR_BUFFER_ALLOCATOR_HPP
@@ -0,0 +1,207 @@
+#include "clipping.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace yasr {
+
+namespace {
+
+/// A clip-space plane a * x + b * y + c * z + d * w = 0, its inside positive
+struct ClipPlane {
+  float a = 0;
+  float b = 0;
+  float c = 0;
+  float d = 0;
+
+  [[nodiscard]] auto distance(const beyond::Vec4& pos) const noexcept -> float
+  {
+    return a * pos.x + b * pos.y + c * pos.z + d * pos.w;
+  }
+};
+
+[[nodiscard]] auto lerp(const ClipVertex& from, const ClipVertex& to,
+                        float t) noexcept -> ClipVertex
+{
+  const auto mix = [t](float a, float b) { return a + (b - a) * t; };
+  return ClipVertex{
+      .pos = {mix(from.pos.x, to.pos.x), mix(from.pos.y, to.pos.y),
+              mix(from.pos.z, to.pos.z), mix(from.pos.w, to.pos.w)},
+      .weights = {mix(from.weights.x, to.weights.x),
+                  mix(from.weights.y, to.weights.y)},
+  };
+}
+
+/// One Sutherland-Hodgman step, keeping the part of `polygon` inside `plane`
+[[nodiscard]] auto clip_polygon(const ClipPolygon& polygon,
+                                const ClipPlane& plane) noexcept -> ClipPolygon
+{
+  ClipPolygon result;
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    const ClipVertex& current = polygon.vertices[i];
+    const ClipVertex& next = polygon.vertices[(i + 1) % polygon.size];
+    const float current_distance = plane.distance(current.pos);
+    const float next_distance = plane.distance(next.pos);
+
+    if (current_distance >= 0) {
+      result.vertices[result.size++] = current;
+    }
+    if ((current_distance >= 0) != (next_distance >= 0)) {
+      // Interpolate from the inside vertex, so the two triangles sharing an
+      // edge produce the same point whichever way they traverse it
+      const bool current_inside = current_distance >= 0;
+      const ClipVertex& inside = current_inside ? current : next;
+      const ClipVertex& outside = current_inside ? next : current;
+      const float inside_distance =
+          current_inside ? current_distance : next_distance;
+      const float outside_distance =
+          current_inside ? next_distance : current_distance;
+      result.vertices[result.size++] =
+          lerp(inside, outside,
+               inside_distance / (inside_distance - outside_distance));
+    }
+  }
+  return result;
+}
+
+// Outcodes of Cohen-Sutherland clipping, in screen space with y down
+constexpr unsigned outside_left = 1;
+constexpr unsigned outside_right = 2;
+constexpr unsigned outside_top = 4;
+constexpr unsigned outside_bottom = 8;
+
+[[nodiscard]] auto outcode(const beyond::Point3& p, float min_x, float min_y,
+                           float max_x, float max_y) noexcept -> unsigned
+{
+  return (p.x < min_x ? outside_left : 0) | (p.x > max_x ? outside_right : 0) |
+         (p.y < min_y ? outside_top : 0) | (p.y > max_y ? outside_bottom : 0);
+}
+
+} // anonymous namespace
+
+auto guard_band(const Rect& viewport) noexcept -> GuardBand
+{
+  const float width = static_cast<float>(viewport.max.x - viewport.min.x);
+  const float height = static_cast<float>(viewport.max.y - viewport.min.y);
+  return GuardBand{.x = std::max(2 * guard_band_extent / width, 1.f),
+                   .y = std::max(2 * guard_band_extent / height, 1.f)};
+}
+
+auto outside_frustum(const beyond::Mat4& mvp,
+                     const BoundingSphere& sphere) noexcept -> bool
+{
+  // Row 3 of mvp plus or minus row 0, 1 or 2 is a frustum plane in object
+  // space, w + x >= 0 for the left one
+  for (int axis = 0; axis < 3; ++axis) {
+    for (const float sign : {1.f, -1.f}) {
+      const auto plane = [&](int column) {
+        return mvp(3, column) + sign * mvp(axis, column);
+      };
+      const float a = plane(0);
+      const float b = plane(1);
+      const float c = plane(2);
+      const float distance = a * sphere.center.x + b * sphere.center.y +
+                             c * sphere.center.z + plane(3);
+      if (distance < -sphere.radius * std::sqrt(a * a + b * b + c * c)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+auto clip_line_near(beyond::Vec4& a, beyond::Vec4& b) noexcept -> bool
+{
+  const ClipPlane near{.c = 1, .d = 1};
+  const float a_distance = near.distance(a);
+  const float b_distance = near.distance(b);
+  if (a_distance < 0 && b_distance < 0) { return false; }
+  if (a_distance >= 0 && b_distance >= 0) { return true; }
+
+  // Interpolated from the inside end, as clip_triangle() does
+  beyond::Vec4& outside = a_distance < 0 ? a : b;
+  const beyond::Vec4& inside = a_distance < 0 ? b : a;
+  const float inside_distance = std::max(a_distance, b_distance);
+  const float t = inside_distance / (inside_distance - std::min(a_distance,
+                                                                b_distance));
+  const auto mix = [t](float from, float to) { return from + (to - from) * t; };
+  outside = {mix(inside.x, outside.x), mix(inside.y, outside.y),
+             mix(inside.z, outside.z), mix(inside.w, outside.w)};
+  return true;
+}
+
+auto clip_line(beyond::Point3& a, beyond::Point3& b, const Rect& rect) noexcept
+    -> bool
+{
+  const auto finite = [](const beyond::Point3& p) {
+    return std::isfinite(p.x) && std::isfinite(p.y) && std::isfinite(p.z);
+  };
+  if (rect.empty() || !finite(a) || !finite(b)) { return false; }
+
+  const auto min_x = static_cast<float>(rect.min.x);
+  const auto min_y = static_cast<float>(rect.min.y);
+  const auto max_x = static_cast<float>(rect.max.x);
+  const auto max_y = static_cast<float>(rect.max.y);
+  unsigned a_code = outcode(a, min_x, min_y, max_x, max_y);
+  unsigned b_code = outcode(b, min_x, min_y, max_x, max_y);
+
+  // Every pass moves an end onto one edge, which takes at most two passes
+  // per end. Rounding may leave an end just outside after that, and the line
+  // is then dropped.
+  for (int pass = 0; pass < 4 && (a_code | b_code) != 0; ++pass) {
+    if ((a_code & b_code) != 0) { return false; }
+    const bool move_a = a_code != 0;
+    beyond::Point3& outside = move_a ? a : b;
+    const beyond::Point3& other = move_a ? b : a;
+    const unsigned code = move_a ? a_code : b_code;
+
+    const auto at_x = [&](float x) {
+      const float t = (x - outside.x) / (other.x - outside.x);
+      return beyond::Point3{x, outside.y + (other.y - outside.y) * t,
+                            outside.z + (other.z - outside.z) * t};
+    };
+    const auto at_y = [&](float y) {
+      const float t = (y - outside.y) / (other.y - outside.y);
+      return beyond::Point3{outside.x + (other.x - outside.x) * t, y,
+                            outside.z + (other.z - outside.z) * t};
+    };
+    if ((code & outside_left) != 0) {
+      outside = at_x(min_x);
+    } else if ((code & outside_right) != 0) {
+      outside = at_x(max_x);
+    } else if ((code & outside_top) != 0) {
+      outside = at_y(min_y);
+    } else {
+      outside = at_y(max_y);
+    }
+
+    (move_a ? a_code : b_code) =
+        outcode(outside, min_x, min_y, max_x, max_y);
+  }
+  return (a_code | b_code) == 0;
+}
+
+auto clip_triangle(const std::array<beyond::Vec4, 3>& triangle,
+                   GuardBand band) noexcept -> ClipPolygon
+{
+  const std::array planes{
+      ClipPlane{.c = 1, .d = 1},        // near, z >= -w
+      ClipPlane{.a = 1, .d = band.x},   // x >= -band.x * w
+      ClipPlane{.a = -1, .d = band.x},  // x <= band.x * w
+      ClipPlane{.b = 1, .d = band.y},   // y >= -band.y * w
+      ClipPlane{.b = -1, .d = band.y},  // y <= band.y * w
+  };
+  static_assert(3 + planes.size() == max_clip_vertices);
+
+  ClipPolygon polygon{.vertices = {ClipVertex{triangle[0], {0, 0}},
+                                   ClipVertex{triangle[1], {1, 0}},
+                                   ClipVertex{triangle[2], {0, 1}}},
+                      .size = 3};
+  for (const ClipPlane& plane : planes) {
+    polygon = clip_polygon(polygon, plane);
+    if (polygon.size < 3) { return ClipPolygon{}; }
+  }
+  return polygon;
+}
+
+} // namespace yasr
@@ -0,0 +1,169 @@
+#ifndef YASR_CLIPPING_HPP
+#define YASR_CLIPPING_HPP
+
+#include "rasterizer.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <beyond/math/matrix.hpp>
+#include <beyond/math/vector.hpp>
+
+namespace yasr {
+
+// Bits of the clip flags of a vertex, set for the planes it lies outside of.
+// The first six are the planes of the view frustum.
+constexpr std::uint8_t clip_left = 1U << 0U;
+constexpr std::uint8_t clip_right = 1U << 1U;
+constexpr std::uint8_t clip_bottom = 1U << 2U;
+constexpr std::uint8_t clip_top = 1U << 3U;
+constexpr std::uint8_t clip_near = 1U << 4U;
+constexpr std::uint8_t clip_far = 1U << 5U;
+/// Outside the guard band on x or y, too far out to be rasterized directly
+constexpr std::uint8_t clip_guard_band = 1U << 6U;
+
+constexpr std::uint8_t clip_frustum =
+    clip_left | clip_right | clip_bottom | clip_top | clip_near | clip_far;
+/// Triangles with a vertex outside of these planes go through clip_triangle()
+constexpr std::uint8_t clip_needed = clip_near | clip_guard_band;
+
+/// Vertices closer than this many pixels to the centre of the viewport are
+/// rasterized without clipping. A float still holds 1/1024 pixel there, finer
+/// than the sub-pixel grid.
+constexpr float guard_band_extent = 8192;
+
+/// Half extents of the guard band in normalized device coordinates
+struct GuardBand {
+  float x = 1;
+  float y = 1;
+};
+
+[[nodiscard]] auto guard_band(const Rect& viewport) noexcept -> GuardBand;
+
+/// The clip flags of the clip-space position (x, y, z, w)
+[[nodiscard]] constexpr auto clip_flags(float x, float y, float z, float w,
+                                        GuardBand band) noexcept
+    -> std::uint8_t
+{
+  const auto flag = [](bool outside, std::uint8_t bit) {
+    return outside ? bit : std::uint8_t{0};
+  };
+  const bool outside_band = x < -band.x * w || x > band.x * w ||
+                            y < -band.y * w || y > band.y * w;
+  return static_cast<std::uint8_t>(
+      flag(x < -w, clip_left) | flag(x > w, clip_right) |
+      flag(y < -w, clip_bottom) | flag(y > w, clip_top) |
+      flag(z < -w, clip_near) | flag(z > w, clip_far) |
+      flag(outside_band, clip_guard_band));
+}
+
+/// A sphere around the vertices of a mesh, in object space
+struct BoundingSphere {
+  beyond::Vec3 center;
+  float radius = 0;
+};
+
+/// Whether `sphere` lies entirely outside one plane of the view frustum of
+/// `mvp`. Tested against the planes in object space, so instances are culled
+/// without transforming any of their vertices.
+[[nodiscard]] auto outside_frustum(const beyond::Mat4& mvp,
+                                   const BoundingSphere& sphere) noexcept
+    -> bool;
+
+/// `pos` transformed by `mvp`, with the same arithmetic as the vertex stage
+[[nodiscard]] inline auto transform_to_clip(const beyond::Mat4& mvp,
+                                            const beyond::Point3& pos) noexcept
+    -> beyond::Vec4
+{
+  const auto row = [&](int r) {
+    return mvp(r, 0) * pos.x + mvp(r, 1) * pos.y + mvp(r, 2) * pos.z +
+           mvp(r, 3);
+  };
+  return {row(0), row(1), row(2), row(3)};
+}
+
+/**
+ * \brief Perspective divide and viewport transform of a clip-space position
+ *
+ * The vertex stage and the clipper share it, so a vertex shared by a clipped
+ * and an unclipped triangle lands on the same sub-pixel.
+ */
+[[nodiscard]] inline auto to_screen(float x, float y, float z, float w,
+                                    const Rect& viewport) noexcept
+    -> ScreenVertex
+{
+  const float width = static_cast<float>(viewport.max.x - viewport.min.x);
+  const float height = static_cast<float>(viewport.max.y - viewport.min.y);
+  const float inv_w = 1.f / w;
+  return ScreenVertex{
+      .pos = {static_cast<float>(viewport.min.x) +
+                  (x * inv_w + 1.f) * width / 2,
+              static_cast<float>(viewport.max.y) -
+                  (y * inv_w + 1.f) * height / 2,
+              -(z * inv_w)},
+      .inv_w = inv_w,
+      .uv = {},
+  };
+}
+
+/// A vertex of a clipped triangle in homogeneous clip space
+struct ClipVertex {
+  beyond::Vec4 pos;
+  /// Barycentric weights of the input triangle's vertices 1 and 2, from which
+  /// the caller interpolates any attributes
+  beyond::Vec2 weights;
+};
+
+/// An attribute with values `a0`, `a1` and `a2` at the input vertices,
+/// interpolated at the barycentric `weights` of a clip vertex
+[[nodiscard]] constexpr auto interpolate(float a0, float a1, float a2,
+                                         beyond::Vec2 weights) noexcept
+    -> float
+{
+  return a0 + weights.x * (a1 - a0) + weights.y * (a2 - a0);
+}
+
+/// A triangle clipped by one plane gains at most one vertex per plane
+constexpr std::size_t max_clip_vertices = 3 + 5;
+
+/// A convex polygon, fanned around its first vertex
+struct ClipPolygon {
+  std::array<ClipVertex, max_clip_vertices> vertices;
+  std::size_t size = 0;
+};
+
+/**
+ * \brief Clips a triangle against the near plane and the guard band
+ *
+ * Clipping to the other planes of the frustum is left to the rasterizer,
+ * which only visits pixels inside the viewport. Points on a plane count as
+ * inside. The result keeps the winding of the clip-space positions
+ * `triangle` and is empty if nothing of it remains.
+ */
+[[nodiscard]] auto clip_triangle(const std::array<beyond::Vec4, 3>& triangle,
+                                 GuardBand band) noexcept -> ClipPolygon;
+
+/**
+ * \brief Clips the line from `a` to `b` against the near plane
+ *
+ * An end behind the plane is moved onto it.
+ * \return false if the whole line lies behind the plane
+ */
+[[nodiscard]] auto clip_line_near(beyond::Vec4& a, beyond::Vec4& b) noexcept
+    -> bool;
+
+/**
+ * \brief Cohen-Sutherland clipping of the screen-space line from `a` to `b`
+ * against `rect`
+ *
+ * Depth is interpolated along with x and y. The clipped ends lie inside the
+ * closed rectangle, so an end can lie on its max edges.
+ * \return false if the line misses `rect` or has a non-finite end
+ */
+[[nodiscard]] auto clip_line(beyond::Point3& a, beyond::Point3& b,
+                             const Rect& rect) noexcept -> bool;
+
+} // namespace yasr
+
+#endif // YASR_CLIPPING_HPP
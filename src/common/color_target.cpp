@@ -0,0 +1,26 @@
+#include "color_target.hpp"
+
+#include <cmath>
+
+namespace yasr {
+
+namespace {
+
+[[nodiscard]] auto make_srgb8_encoding_table()
+    -> std::array<std::uint8_t, srgb8_table_size>
+{
+  std::array<std::uint8_t, srgb8_table_size> table{};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    const float c =
+        static_cast<float>(i) / static_cast<float>(srgb8_table_size - 1);
+    table[i] = static_cast<std::uint8_t>(std::lround(encode_srgb(c) * 255));
+  }
+  return table;
+}
+
+} // anonymous namespace
+
+const std::array<std::uint8_t, srgb8_table_size> srgb8_encoding_table =
+    make_srgb8_encoding_table();
+
+} // namespace yasr
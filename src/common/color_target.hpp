@@ -0,0 +1,176 @@
+#ifndef YASR_COLOR_TARGET_HPP
+#define YASR_COLOR_TARGET_HPP
+
+#include "color.hpp"
+#include "image.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace yasr {
+
+/// Storage of a color attachment. Every format holds sRGB encoded colors.
+enum class ColorFormat : std::uint8_t {
+  /// 32-bit float RGB, neither quantized nor dithered
+  rgb32_float,
+  /// 8-bit R, G, B and A bytes, in this order in memory
+  rgba8_srgb,
+  /// 8-bit channels packed into a std::uint32_t as 0xAARRGGBB in native byte
+  /// order, the layout of SDL_PIXELFORMAT_RGB888 and SDL_PIXELFORMAT_ARGB8888
+  bgra8_srgb,
+};
+
+[[nodiscard]] constexpr auto bytes_per_pixel(ColorFormat format) noexcept
+    -> std::size_t
+{
+  return format == ColorFormat::rgb32_float ? sizeof(RGB) : 4;
+}
+
+/// Exact sRGB encoding of a linear channel, clamped to [0, 1]
+[[nodiscard]] inline auto encode_srgb(float c) noexcept -> float
+{
+  if (c >= 1.f) { return 1.f; }
+  return c <= 0.0031308f ? std::max(c, 0.f) * 12.92f
+                         : 1.055f * std::pow(c, 1 / 2.4f) - 0.055f;
+}
+
+/// Number of entries of the table behind encode_srgb8(). Where the curve is
+/// steepest, next to 0, neighbouring entries differ by less than one code.
+constexpr std::size_t srgb8_table_size = 4096;
+
+/// Entry i holds the 8-bit sRGB encoding of i / (srgb8_table_size - 1)
+extern const std::array<std::uint8_t, srgb8_table_size> srgb8_encoding_table;
+
+/**
+ * \brief 8-bit sRGB encoding of a linear channel, through a table lookup
+ *
+ * Within one code of the rounded exact encoding. Clamps to [0, 1] and encodes
+ * NaN as 0.
+ */
+[[nodiscard]] inline auto encode_srgb8(float c) noexcept -> std::uint8_t
+{
+  constexpr float scale = srgb8_table_size - 1;
+  const float clamped = c > 0.f ? (c < 1.f ? c : 1.f) : 0.f;
+  const auto index = static_cast<std::size_t>(clamped * scale + 0.5f);
+  return srgb8_encoding_table[index];
+}
+
+/// Bit offsets of the R, G, B and A channels in the std::uint32_t pixels of
+/// an 8-bit format
+[[nodiscard]] constexpr auto channel_shifts(ColorFormat format) noexcept
+    -> std::array<std::uint32_t, 4>
+{
+  if (format == ColorFormat::bgra8_srgb) { return {16, 8, 0, 24}; }
+  if constexpr (std::endian::native == std::endian::little) {
+    return {0, 8, 16, 24};
+  } else {
+    return {24, 16, 8, 0};
+  }
+}
+
+/// Packs four 8-bit channels into a pixel of an 8-bit format
+[[nodiscard]] constexpr auto pack_rgba8(ColorFormat format, std::uint8_t r,
+                                        std::uint8_t g, std::uint8_t b,
+                                        std::uint8_t a) noexcept
+    -> std::uint32_t
+{
+  const auto [r_shift, g_shift, b_shift, a_shift] = channel_shifts(format);
+  return std::uint32_t{r} << r_shift | std::uint32_t{g} << g_shift |
+         std::uint32_t{b} << b_shift | std::uint32_t{a} << a_shift;
+}
+
+/// The sRGB encoded pixel of a linear color in an 8-bit format, fully opaque
+[[nodiscard]] inline auto encode_rgba8(ColorFormat format,
+                                       const RGB& color) noexcept
+    -> std::uint32_t
+{
+  return pack_rgba8(format, encode_srgb8(color.r), encode_srgb8(color.g),
+                    encode_srgb8(color.b), 0xFF);
+}
+
+/// A read-only view of a color attachment
+struct ColorView {
+  ColorFormat format = ColorFormat::rgb32_float;
+  int width = 0;
+  int height = 0;
+  /// Tightly packed rows of bytes_per_pixel(format) bytes, top row first.
+  /// Points to RGB for rgb32_float and to std::uint32_t otherwise.
+  const void* pixels = nullptr;
+
+  /// The sRGB encoded color at (x, y), without bound checking. 8-bit
+  /// channels are mapped to [0, 1].
+  [[nodiscard]] auto load(int x, int y) const noexcept -> RGB
+  {
+    const std::size_t index = static_cast<std::size_t>(y) *
+                                  static_cast<std::size_t>(width) +
+                              static_cast<std::size_t>(x);
+    if (format == ColorFormat::rgb32_float) {
+      return static_cast<const RGB*>(pixels)[index];
+    }
+    const std::uint32_t pixel =
+        static_cast<const std::uint32_t*>(pixels)[index];
+    const auto [r_shift, g_shift, b_shift, a_shift] = channel_shifts(format);
+    const auto channel = [pixel](std::uint32_t shift) {
+      return static_cast<float>(pixel >> shift & 0xFFu) / 255.f;
+    };
+    return RGB{channel(r_shift), channel(g_shift), channel(b_shift)};
+  }
+};
+
+/**
+ * \brief A color attachment the rasterizer writes to
+ *
+ * Shading produces linear colors, the target encodes them to its format.
+ */
+struct ColorTarget {
+  ColorFormat format = ColorFormat::rgb32_float;
+  int width = 0;
+  int height = 0;
+  /// Laid out like ColorView::pixels
+  void* pixels = nullptr;
+
+  /// Encodes the linear `color` and stores it at (x, y), without bound
+  /// checking
+  void store(int x, int y, const RGB& color) const noexcept
+  {
+    const std::size_t index = static_cast<std::size_t>(y) *
+                                  static_cast<std::size_t>(width) +
+                              static_cast<std::size_t>(x);
+    if (format == ColorFormat::rgb32_float) {
+      static_cast<RGB*>(pixels)[index] = RGB{
+          encode_srgb(color.r), encode_srgb(color.g), encode_srgb(color.b)};
+    } else {
+      static_cast<std::uint32_t*>(pixels)[index] = encode_rgba8(format, color);
+    }
+  }
+
+  [[nodiscard]] auto view() const noexcept -> ColorView
+  {
+    return ColorView{
+        .format = format, .width = width, .height = height, .pixels = pixels};
+  }
+};
+
+[[nodiscard]] inline auto color_target(Image& image) noexcept -> ColorTarget
+{
+  return ColorTarget{.format = ColorFormat::rgb32_float,
+                     .width = image.width(),
+                     .height = image.height(),
+                     .pixels = image.data()};
+}
+
+[[nodiscard]] inline auto color_view(const Image& image) noexcept -> ColorView
+{
+  return ColorView{.format = ColorFormat::rgb32_float,
+                   .width = image.width(),
+                   .height = image.height(),
+                   .pixels = image.data()};
+}
+
+} // namespace yasr
+
+#endif // YASR_COLOR_TARGET_HPP
@@ -0,0 +1,194 @@
+#include "deferred.hpp"
+#include "clipping.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <beyond/math/transform.hpp>
+
+namespace yasr {
+
+namespace {
+
+/// The depth-buffer value of the view-space depth `z`, or +infinity if the
+/// projection puts it behind the camera
+[[nodiscard]] auto depth_of(const beyond::Mat4& projection, float z) noexcept
+    -> float
+{
+  const float w = projection(3, 2) * z + projection(3, 3);
+  if (w <= 0) { return std::numeric_limits<float>::infinity(); }
+  return -(projection(2, 2) * z + projection(2, 3)) / w;
+}
+
+/// The linear color of an albedo of the G-buffer
+[[nodiscard]] auto decode_albedo(std::uint32_t albedo) noexcept -> RGB
+{
+  static const std::array<float, 256>& to_linear =
+      channel_to_linear_table(TextureFormat::rgba8_srgb);
+  const auto [r_shift, g_shift, b_shift, a_shift] =
+      channel_shifts(ColorFormat::rgba8_srgb);
+  const auto channel = [&](std::uint32_t shift) {
+    return to_linear[(albedo >> shift) & 0xFF];
+  };
+  return RGB{channel(r_shift), channel(g_shift), channel(b_shift)};
+}
+
+} // anonymous namespace
+
+auto make_lighting_view(const Camera& camera, const Rect& viewport)
+    -> LightingView
+{
+  const float aspect = static_cast<float>(viewport.max.x - viewport.min.x) /
+                       static_cast<float>(viewport.max.y - viewport.min.y);
+  return LightingView{
+      .view = beyond::look_at(camera.eye, camera.target, camera.up),
+      .projection = beyond::perspective(camera.fov_y, aspect, camera.z_near,
+                                        camera.z_far),
+      .viewport = viewport,
+  };
+}
+
+auto make_view_light(const PointLight& light, const LightingView& view)
+    -> std::optional<ViewLight>
+{
+  const beyond::Vec4 centre = transform_to_clip(
+      view.view, beyond::Point3{light.position.x, light.position.y,
+                                light.position.z});
+  const float radius = light.radius;
+
+  // Depth grows towards the camera, so the far end of the sphere bounds the
+  // depth from below
+  const float far_depth = depth_of(view.projection, centre.z - radius);
+  const float near_depth = depth_of(view.projection, centre.z + radius);
+  const bool behind_camera =
+      far_depth == std::numeric_limits<float>::infinity();
+  if (behind_camera || !(radius > 0)) { return std::nullopt; }
+
+  // The projection of the cube around the sphere contains the sphere's, as
+  // long as the cube lies in front of the camera
+  Rect bounds = view.viewport;
+  if (near_depth != std::numeric_limits<float>::infinity()) {
+    // Far outside the viewport, clamped before the conversion to int
+    const Rect& viewport = view.viewport;
+    const auto clamp = [](float value, int min, int max) {
+      return std::clamp(value, static_cast<float>(min - 1),
+                        static_cast<float>(max + 1));
+    };
+    Rect corners{{viewport.max.x, viewport.max.y},
+                 {viewport.min.x, viewport.min.y}};
+    bool in_front = true;
+    for (int corner = 0; corner < 8 && in_front; ++corner) {
+      const beyond::Point3 point{
+          centre.x + ((corner & 1) != 0 ? radius : -radius),
+          centre.y + ((corner & 2) != 0 ? radius : -radius),
+          centre.z + ((corner & 4) != 0 ? radius : -radius)};
+      const beyond::Vec4 clip = transform_to_clip(view.projection, point);
+      in_front = clip.w > 0;
+      if (!in_front) { break; }
+
+      const ScreenVertex screen =
+          to_screen(clip.x, clip.y, clip.z, clip.w, viewport);
+      const float x = clamp(screen.pos.x, viewport.min.x, viewport.max.x);
+      const float y = clamp(screen.pos.y, viewport.min.y, viewport.max.y);
+      corners.min.x = std::min(corners.min.x, static_cast<int>(std::floor(x)));
+      corners.min.y = std::min(corners.min.y, static_cast<int>(std::floor(y)));
+      corners.max.x = std::max(corners.max.x, static_cast<int>(std::ceil(x)));
+      corners.max.y = std::max(corners.max.y, static_cast<int>(std::ceil(y)));
+    }
+    if (in_front) { bounds = intersect(viewport, corners); }
+  }
+  if (bounds.empty()) { return std::nullopt; }
+
+  return ViewLight{
+      .position = {centre.x, centre.y, centre.z},
+      .color = light.color,
+      .radius = radius,
+      .bounds = bounds,
+      .min_depth = far_depth,
+      .max_depth = near_depth,
+  };
+}
+
+void shade_tile(const Rect& tile, const LightingView& view,
+                const beyond::Vec3& sun, std::vector<const ViewLight*>& lights,
+                const std::vector<float>& depth_buffer, float clear_depth,
+                const GBufferTarget& g_buffer, const ColorTarget& target,
+                PipelineStats& stats)
+{
+  const auto pixel_index = [&](int x, int y) {
+    return static_cast<std::size_t>(y * g_buffer.width + x);
+  };
+
+  float tile_min = std::numeric_limits<float>::infinity();
+  float tile_max = -tile_min;
+  for (int y = tile.min.y; y < tile.max.y; ++y) {
+    for (int x = tile.min.x; x < tile.max.x; ++x) {
+      const float depth = depth_buffer[pixel_index(x, y)];
+      if (depth == clear_depth) { continue; }
+      tile_min = std::min(tile_min, depth);
+      tile_max = std::max(tile_max, depth);
+    }
+  }
+  if (tile_min > tile_max) { return; }
+
+  stats.lights_culled += std::erase_if(lights, [&](const ViewLight* light) {
+    return light->max_depth < tile_min || light->min_depth > tile_max;
+  });
+
+  // Inverts the projection and viewport transform of the pixel centres
+  const beyond::Mat4& p = view.projection;
+  const Rect& viewport = view.viewport;
+  const float x_scale =
+      2.f / static_cast<float>(viewport.max.x - viewport.min.x);
+  const float y_scale =
+      2.f / static_cast<float>(viewport.max.y - viewport.min.y);
+
+  for (int y = tile.min.y; y < tile.max.y; ++y) {
+    const float ndc_y =
+        (static_cast<float>(viewport.max.y - y) - 0.5f) * y_scale - 1.f;
+    for (int x = tile.min.x; x < tile.max.x; ++x) {
+      const std::size_t pixel = pixel_index(x, y);
+      const float depth = depth_buffer[pixel];
+      if (depth == clear_depth) { continue; }
+
+      const float ndc_x =
+          (static_cast<float>(x - viewport.min.x) + 0.5f) * x_scale - 1.f;
+      const float z =
+          -(p(2, 3) + depth * p(3, 3)) / (depth * p(3, 2) + p(2, 2));
+      const float w = p(3, 2) * z + p(3, 3);
+      const beyond::Vec3 position{(ndc_x * w - p(0, 2) * z - p(0, 3)) / p(0, 0),
+                                  (ndc_y * w - p(1, 2) * z - p(1, 3)) / p(1, 1),
+                                  z};
+      const beyond::Vec3 normal = unpack_normal(g_buffer.normal[pixel]);
+
+      const float sun_intensity = std::max(beyond::dot(normal, sun), 0.f);
+      RGB light{sun_intensity, sun_intensity, sun_intensity};
+      for (const ViewLight* point_light : lights) {
+        const beyond::Vec3 to_light = point_light->position - position;
+        const float distance_squared = beyond::dot(to_light, to_light);
+        const float radius_squared = point_light->radius * point_light->radius;
+        if (distance_squared >= radius_squared) { continue; }
+        const float facing = beyond::dot(normal, to_light);
+        if (facing <= 0) { continue; }
+
+        // Lambert with a windowed falloff that reaches 0 at the radius
+        const float window = 1.f - distance_squared / radius_squared;
+        const float intensity =
+            window * window * facing / std::sqrt(distance_squared);
+        light.r += point_light->color.r * intensity;
+        light.g += point_light->color.g * intensity;
+        light.b += point_light->color.b * intensity;
+      }
+
+      const RGB albedo = decode_albedo(g_buffer.albedo[pixel]);
+      target.store(x, y,
+                   RGB{albedo.r * light.r, albedo.g * light.g,
+                       albedo.b * light.b});
+    }
+  }
+}
+
+} // namespace yasr
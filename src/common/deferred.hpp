@@ -0,0 +1,62 @@
+#ifndef YASR_DEFERRED_HPP
+#define YASR_DEFERRED_HPP
+
+#include "color_target.hpp"
+#include "rasterizer.hpp"
+#include "yasr.hpp"
+
+#include <optional>
+#include <vector>
+
+#include <beyond/math/matrix.hpp>
+#include <beyond/math/vector.hpp>
+
+namespace yasr {
+
+/// The camera the G-buffer was drawn with, which its pixels are lit from
+struct LightingView {
+  beyond::Mat4 view;
+  /// A perspective projection, in which x and y do not mix
+  beyond::Mat4 projection;
+  Rect viewport;
+};
+
+/// The view and projection of `camera`, whose product is view_projection()
+[[nodiscard]] auto make_lighting_view(const Camera& camera,
+                                      const Rect& viewport) -> LightingView;
+
+/// A point light in view space, with the bounds it is culled by
+struct ViewLight {
+  beyond::Vec3 position;
+  RGB color;
+  float radius = 0;
+  /// The pixels the light may reach
+  Rect bounds;
+  /// The range of depth-buffer values the light may reach
+  float min_depth = 0;
+  float max_depth = 0;
+};
+
+/// `light` in the view space of `view`, or std::nullopt if it reaches no
+/// pixel of the viewport
+[[nodiscard]] auto make_view_light(const PointLight& light,
+                                   const LightingView& view)
+    -> std::optional<ViewLight>;
+
+/**
+ * \brief Lights the pixels of `tile` that a draw covered
+ *
+ * Drops the `lights` that lie outside the depth range of the tile's pixels,
+ * then shades each pixel at a depth other than `clear_depth` once, with the
+ * directional light towards `sun`, in view space, and the remaining lights.
+ * Counts the culled lights in `stats`.
+ */
+void shade_tile(const Rect& tile, const LightingView& view,
+                const beyond::Vec3& sun, std::vector<const ViewLight*>& lights,
+                const std::vector<float>& depth_buffer, float clear_depth,
+                const GBufferTarget& g_buffer, const ColorTarget& target,
+                PipelineStats& stats);
+
+} // namespace yasr
+
+#endif // YASR_DEFERRED_HPP
@@ -0,0 +1,61 @@
+#include "dynamic_resolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+namespace {
+
+/// Frames averaged before each decision
+constexpr std::uint32_t averaged_frames = 8;
+/// Frames in flight when the scale changes, which still have the old one
+constexpr std::uint32_t queued_frames = 2;
+/// Relative deviation from the target that keeps the scale
+constexpr double tolerance = 0.1;
+
+} // anonymous namespace
+
+DynamicResolution::DynamicResolution(
+    const DynamicResolutionDesc& desc) noexcept
+    : desc_{desc}, scale_{desc.max_scale}
+{
+  BEYOND_ASSERT(desc.min_scale > 0 && desc.min_scale <= desc.max_scale);
+  BEYOND_ASSERT(desc.target_frame_time.count() > 0);
+}
+
+auto DynamicResolution::update(Milliseconds frame_time) noexcept -> float
+{
+  if (frames_to_skip_ > 0) {
+    --frames_to_skip_;
+    return scale_;
+  }
+  average_frame_time_ += frame_time / averaged_frames;
+  if (++frames_averaged_ < averaged_frames) { return scale_; }
+
+  const double ratio = desc_.target_frame_time / average_frame_time_;
+  frames_averaged_ = 0;
+  average_frame_time_ = {};
+  if (std::abs(ratio - 1.0) <= tolerance) { return scale_; }
+
+  const float scale =
+      std::clamp(static_cast<float>(scale_ * std::sqrt(ratio)),
+                 desc_.min_scale, desc_.max_scale);
+  if (scale != scale_) {
+    scale_ = scale;
+    frames_to_skip_ = queued_frames;
+  }
+  return scale_;
+}
+
+auto DynamicResolution::scaled(std::uint32_t size) const noexcept
+    -> std::uint32_t
+{
+  const auto pixels = static_cast<std::uint32_t>(
+      std::lround(static_cast<float>(size) * scale_));
+  return std::max(pixels, 1u);
+}
+
+} // namespace yasr
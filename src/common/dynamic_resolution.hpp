@@ -0,0 +1,53 @@
+#ifndef YASR_DYNAMIC_RESOLUTION_HPP
+#define YASR_DYNAMIC_RESOLUTION_HPP
+
+#include <chrono>
+#include <cstdint>
+
+namespace yasr {
+
+struct DynamicResolutionDesc {
+  std::chrono::duration<double, std::milli> target_frame_time{1000.0 / 60.0};
+  /// Bounds of the scale of each axis
+  float min_scale = 0.5f;
+  float max_scale = 1.f;
+};
+
+/**
+ * \brief Scales the internal resolution to hit a target frame time
+ *
+ * Rasterization costs about as much as the pixels it covers, so a frame
+ * slower than the target shrinks both axes by the square root of their
+ * ratio. Frame times are averaged over a few frames, and deviations within
+ * a tenth of the target leave the scale alone, so the resolution does not
+ * oscillate. The frames queued before a change are ignored.
+ */
+class DynamicResolution {
+public:
+  using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  explicit DynamicResolution(const DynamicResolutionDesc& desc = {}) noexcept;
+
+  /// Records the time of the last frame and returns the scale of the next one
+  auto update(Milliseconds frame_time) noexcept -> float;
+
+  [[nodiscard]] auto scale() const noexcept -> float
+  {
+    return scale_;
+  }
+
+  /// `size` pixels scaled, and at least one pixel
+  [[nodiscard]] auto scaled(std::uint32_t size) const noexcept -> std::uint32_t;
+
+private:
+  DynamicResolutionDesc desc_;
+  float scale_ = 1.f;
+  Milliseconds average_frame_time_{};
+  /// Frames to ignore, which were queued at an older scale
+  std::uint32_t frames_to_skip_ = 0;
+  std::uint32_t frames_averaged_ = 0;
+};
+
+} // namespace yasr
+
+#endif // YASR_DYNAMIC_RESOLUTION_HPP
@@ -1,5 +1,7 @@
 #include "file_util.hpp"
 
+#include <utility>
+
 auto read_file(std::string_view path) -> std::string
 {
   std::ifstream file{path.data()};
@@ -15,3 +17,95 @@ auto read_file(std::string_view path) -> std::string
 
   return ss.str();
 }
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+auto MappedFile::open(std::string_view path) -> std::optional<MappedFile>
+{
+  HANDLE file =
+      CreateFileA(std::string{path}.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) { return std::nullopt; }
+
+  LARGE_INTEGER size{};
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return std::nullopt;
+  }
+  if (size.QuadPart == 0) {
+    CloseHandle(file);
+    return MappedFile{nullptr, 0};
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) { return std::nullopt; }
+
+  const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (data == nullptr) { return std::nullopt; }
+  return MappedFile{static_cast<const std::byte*>(data),
+                    static_cast<std::size_t>(size.QuadPart)};
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr) { UnmapViewOfFile(data_); }
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+auto MappedFile::open(std::string_view path) -> std::optional<MappedFile>
+{
+  const int fd = ::open(std::string{path}.c_str(), O_RDONLY);
+  if (fd < 0) { return std::nullopt; }
+
+  struct stat status {};
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+    return std::nullopt;
+  }
+  const auto size = static_cast<std::size_t>(status.st_size);
+  if (size == 0) {
+    close(fd);
+    return MappedFile{nullptr, 0};
+  }
+
+  // The mapping stays valid after its file descriptor is closed
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) { return std::nullopt; }
+  return MappedFile{static_cast<const std::byte*>(data), size};
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_ != nullptr) {
+    munmap(const_cast<std::byte*>(data_), size_);
+  }
+}
+
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)}
+{
+}
+
+auto MappedFile::operator=(MappedFile&& other) noexcept -> MappedFile&
+{
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  return *this;
+}
@@ -3,7 +3,10 @@
 #ifndef YASR_FILE_UTIL_HPP
 #define YASR_FILE_UTIL_HPP
 
+#include <cstddef>
 #include <fstream>
+#include <optional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -12,4 +15,37 @@
 
 [[nodiscard]] auto read_file(std::string_view path) -> std::string;
 
+/**
+ * \brief A read-only memory mapping of a whole file
+ *
+ * The pages are loaded by the operating system on first access, so opening a
+ * file does not read it.
+ */
+class MappedFile {
+public:
+  /// Returns nullopt if the file cannot be opened or mapped
+  [[nodiscard]] static auto open(std::string_view path)
+      -> std::optional<MappedFile>;
+
+  MappedFile(const MappedFile&) = delete;
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+  MappedFile(MappedFile&& other) noexcept;
+  auto operator=(MappedFile&& other) noexcept -> MappedFile&;
+  ~MappedFile();
+
+  [[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte>
+  {
+    return {data_, size_};
+  }
+
+private:
+  MappedFile(const std::byte* data, std::size_t size) noexcept
+      : data_{data}, size_{size}
+  {
+  }
+
+  const std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
 #endif // YASR_FILE_UTIL_HPP
@@ -0,0 +1,209 @@
+#include "framebuffer.hpp"
+
+#include <algorithm>
+
+namespace yasr {
+
+FramebufferStorage::FramebufferStorage(int width, int height,
+                                       ColorFormat format, int sample_count,
+                                       bool g_buffer)
+    : width_{width},
+      height_{height},
+      format_{format},
+      sample_count_{sample_count},
+      color_{format == ColorFormat::rgb32_float ? width : 0,
+             format == ColorFormat::rgb32_float ? height : 0},
+      packed_color_(format == ColorFormat::rgb32_float
+                        ? 0
+                        : static_cast<std::size_t>(width * height)),
+      depth_(static_cast<std::size_t>(width * height * sample_count),
+             ClearValue{}.depth),
+      coarse_depth_(static_cast<std::size_t>(hiz_block_count(width) *
+                                             hiz_block_count(height)),
+                    ClearValue{}.depth),
+      sample_color_(sample_count == 1
+                        ? 0
+                        : static_cast<std::size_t>(width * height *
+                                                   sample_count)),
+      uniform_(sample_count == 1 ? 0 : static_cast<std::size_t>(width * height),
+               1),
+      g_buffer_normal_(g_buffer ? static_cast<std::size_t>(width * height) : 0),
+      g_buffer_albedo_(g_buffer ? static_cast<std::size_t>(width * height) : 0),
+      tile_count_x_{(width + tile_size - 1) / tile_size},
+      pending_clear_(static_cast<std::size_t>(
+                         tile_count_x_ * ((height + tile_size - 1) / tile_size)),
+                     0),
+      unresolved_(pending_clear_.size(), 0),
+      tile_split_(pending_clear_.size(), 0)
+{
+  BEYOND_ASSERT(sample_count == 1 || sample_count == msaa_sample_count);
+  BEYOND_ASSERT(!g_buffer || sample_count == 1);
+}
+
+auto FramebufferStorage::tile_rect(std::size_t tile_index) const noexcept
+    -> Rect
+{
+  const int tile_x = static_cast<int>(tile_index) % tile_count_x_;
+  const int tile_y = static_cast<int>(tile_index) / tile_count_x_;
+  return Rect{{tile_x * tile_size, tile_y * tile_size},
+              {std::min((tile_x + 1) * tile_size, width()),
+               std::min((tile_y + 1) * tile_size, height())}};
+}
+
+auto FramebufferStorage::color_target() noexcept -> ColorTarget
+{
+  return ColorTarget{
+      .format = format_,
+      .width = width_,
+      .height = height_,
+      .pixels = format_ == ColorFormat::rgb32_float
+                    ? static_cast<void*>(color_.data())
+                    : static_cast<void*>(packed_color_.data()),
+  };
+}
+
+auto FramebufferStorage::color_view() const noexcept -> ColorView
+{
+  return ColorView{
+      .format = format_,
+      .width = width_,
+      .height = height_,
+      .pixels = format_ == ColorFormat::rgb32_float
+                    ? static_cast<const void*>(color_.data())
+                    : static_cast<const void*>(packed_color_.data()),
+  };
+}
+
+auto FramebufferStorage::sample_target(std::size_t tile_index) noexcept
+    -> SampleTarget
+{
+  BEYOND_ASSERT(sample_count_ == msaa_sample_count);
+  unresolved_[tile_index] = 1;
+  return SampleTarget{
+      .width = width_,
+      .height = height_,
+      .depth = depth_.data(),
+      .color = sample_color_.data(),
+      .uniform = uniform_.data(),
+      .tile_split = &tile_split_[tile_index],
+  };
+}
+
+auto FramebufferStorage::g_buffer_target() noexcept -> GBufferTarget
+{
+  BEYOND_ASSERT(has_g_buffer());
+  return GBufferTarget{
+      .width = width_,
+      .height = height_,
+      .normal = g_buffer_normal_.data(),
+      .albedo = g_buffer_albedo_.data(),
+  };
+}
+
+void FramebufferStorage::clear(const ClearValue& value)
+{
+  clear_value_ = value;
+  const RGB& color = value.color;
+  clear_color_ = RGB{encode_srgb(color.r), encode_srgb(color.g),
+                     encode_srgb(color.b)};
+  clear_pixel_ = format_ == ColorFormat::rgb32_float
+                     ? 0
+                     : encode_rgba8(format_, color);
+  std::ranges::fill(pending_clear_, pending_color | pending_depth);
+  std::ranges::fill(unresolved_, std::uint8_t{0});
+}
+
+void FramebufferStorage::resolve_clear(std::size_t tile_index)
+{
+  resolve_color_clear(tile_index);
+  if ((pending_clear_[tile_index] & pending_depth) == 0) { return; }
+  pending_clear_[tile_index] = 0;
+
+  const Rect rect = tile_rect(tile_index);
+  for (int y = rect.min.y; y < rect.max.y; ++y) {
+    const auto row = static_cast<std::ptrdiff_t>(y * width());
+    std::fill(depth_.begin() + (row + rect.min.x) * sample_count_,
+              depth_.begin() + (row + rect.max.x) * sample_count_,
+              clear_value_.depth);
+    if (sample_count_ != 1) {
+      std::fill(uniform_.begin() + row + rect.min.x,
+                uniform_.begin() + row + rect.max.x, std::uint8_t{1});
+      for (std::ptrdiff_t pixel = row + rect.min.x; pixel < row + rect.max.x;
+           ++pixel) {
+        sample_color_[static_cast<std::size_t>(pixel * sample_count_)] =
+            clear_value_.color;
+      }
+    }
+  }
+  tile_split_[tile_index] = 0;
+
+  const int stride = hiz_block_count(width());
+  for (int y = rect.min.y / hiz_block_size; y < hiz_block_count(rect.max.y);
+       ++y) {
+    const auto row = static_cast<std::ptrdiff_t>(y * stride);
+    std::fill(coarse_depth_.begin() + row + rect.min.x / hiz_block_size,
+              coarse_depth_.begin() + row + hiz_block_count(rect.max.x),
+              clear_value_.depth);
+  }
+}
+
+void FramebufferStorage::resolve_color_clear(std::size_t tile_index)
+{
+  if ((pending_clear_[tile_index] & pending_color) == 0) { return; }
+  pending_clear_[tile_index] &= pending_depth;
+
+  const Rect rect = tile_rect(tile_index);
+  for (int y = rect.min.y; y < rect.max.y; ++y) {
+    const auto row = static_cast<std::ptrdiff_t>(y * width());
+    if (format_ == ColorFormat::rgb32_float) {
+      std::fill(color_.data() + row + rect.min.x,
+                color_.data() + row + rect.max.x, clear_color_);
+    } else {
+      std::fill(packed_color_.begin() + row + rect.min.x,
+                packed_color_.begin() + row + rect.max.x, clear_pixel_);
+    }
+  }
+}
+
+void FramebufferStorage::resolve_all_clears()
+{
+  for (std::size_t i = 0; i < pending_clear_.size(); ++i) { resolve_clear(i); }
+}
+
+void FramebufferStorage::resolve_samples(std::size_t tile_index)
+{
+  if (unresolved_[tile_index] == 0) { return; }
+  unresolved_[tile_index] = 0;
+
+  const ColorTarget target = color_target();
+  const Rect rect = tile_rect(tile_index);
+  const bool split = tile_split_[tile_index] != 0;
+  constexpr float weight = 1.f / msaa_sample_count;
+  for (int y = rect.min.y; y < rect.max.y; ++y) {
+    for (int x = rect.min.x; x < rect.max.x; ++x) {
+      const auto pixel = static_cast<std::size_t>(y * width_ + x);
+      const RGB* samples = sample_color_.data() + pixel * msaa_sample_count;
+      if (!split || uniform_[pixel] != 0) {
+        target.store(x, y, samples[0]);
+        continue;
+      }
+      RGB sum;
+      for (int s = 0; s < msaa_sample_count; ++s) {
+        sum.r += samples[s].r;
+        sum.g += samples[s].g;
+        sum.b += samples[s].b;
+      }
+      target.store(x, y, RGB{sum.r * weight, sum.g * weight, sum.b * weight});
+    }
+  }
+}
+
+void FramebufferStorage::resolve_color()
+{
+  for (std::size_t i = 0; i < pending_clear_.size(); ++i) {
+    resolve_color_clear(i);
+    resolve_samples(i);
+  }
+}
+
+} // namespace yasr
@@ -0,0 +1,173 @@
+#ifndef YASR_FRAMEBUFFER_HPP
+#define YASR_FRAMEBUFFER_HPP
+
+#include "color_target.hpp"
+#include "image.hpp"
+#include "rasterizer.hpp"
+#include "yasr.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+/**
+ * \brief Device-side color and depth attachments of a framebuffer
+ *
+ * Clears are lazy: clear() only records the clear value and flags every tile,
+ * and a tile is filled the first time a draw touches it. Reading the color
+ * attachment back only fills the color of the tiles.
+ *
+ * The depth attachment comes with a hierarchical depth level that stores the
+ * farthest depth of every hiz_block_size x hiz_block_size block.
+ *
+ * A multisampled framebuffer keeps msaa_sample_count depths and linear colors
+ * per pixel, and the color attachment holds their average once resolved.
+ * Pixels whose samples share one color store it once, and tiles whose pixels
+ * all do resolve by copying it.
+ *
+ * A framebuffer with a G-buffer also keeps a packed normal and an albedo per
+ * pixel for deferred shading. They are never cleared, the pixels at the clear
+ * depth hold stale values.
+ */
+class FramebufferStorage {
+public:
+  FramebufferStorage() = default;
+  /// `sample_count` is 1 or msaa_sample_count, and 1 with a G-buffer
+  FramebufferStorage(int width, int height,
+                     ColorFormat format = ColorFormat::rgb32_float,
+                     int sample_count = 1, bool g_buffer = false);
+
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return depth_.empty();
+  }
+
+  [[nodiscard]] auto width() const noexcept -> int
+  {
+    return width_;
+  }
+
+  [[nodiscard]] auto height() const noexcept -> int
+  {
+    return height_;
+  }
+
+  [[nodiscard]] auto format() const noexcept -> ColorFormat
+  {
+    return format_;
+  }
+
+  [[nodiscard]] auto sample_count() const noexcept -> int
+  {
+    return sample_count_;
+  }
+
+  [[nodiscard]] auto tile_count_x() const noexcept -> int
+  {
+    return tile_count_x_;
+  }
+
+  [[nodiscard]] auto tile_count() const noexcept -> std::size_t
+  {
+    return pending_clear_.size();
+  }
+
+  [[nodiscard]] auto tile_rect(std::size_t tile_index) const noexcept -> Rect;
+
+  [[nodiscard]] auto has_g_buffer() const noexcept -> bool
+  {
+    return !g_buffer_normal_.empty();
+  }
+
+  void clear(const ClearValue& value);
+  /// The depth of the last clear, which pixels no draw covered still hold
+  [[nodiscard]] auto clear_depth() const noexcept -> float
+  {
+    return clear_value_.depth;
+  }
+
+  /// Fills the tile with the clear value if a clear is still pending on it.
+  /// Different tiles can be resolved concurrently.
+  void resolve_clear(std::size_t tile_index);
+  void resolve_all_clears();
+  /// Whether the depth of the tile was filled in since the last clear, which
+  /// the first draw that touches the tile does
+  [[nodiscard]] auto depth_resolved(std::size_t tile_index) const noexcept
+      -> bool
+  {
+    return (pending_clear_[tile_index] & pending_depth) == 0;
+  }
+
+  /// Averages the samples a draw wrote to the tile since its last resolve
+  /// into the color attachment. Different tiles can be resolved concurrently.
+  void resolve_samples(std::size_t tile_index);
+  /// Brings the color attachment up to date for reading, leaving the pending
+  /// clears of the depth and the samples pending
+  void resolve_color();
+
+  /// Raw attachments, pending clears must be resolved before accessing them.
+  /// color() is only available in the rgb32_float format.
+  [[nodiscard]] auto color() noexcept -> Image&
+  {
+    BEYOND_ASSERT(format_ == ColorFormat::rgb32_float);
+    return color_;
+  }
+  [[nodiscard]] auto color_target() noexcept -> ColorTarget;
+  [[nodiscard]] auto color_view() const noexcept -> ColorView;
+  /// One depth per sample
+  [[nodiscard]] auto depth() noexcept -> std::vector<float>&
+  {
+    return depth_;
+  }
+  [[nodiscard]] auto coarse_depth() noexcept -> std::vector<float>&
+  {
+    return coarse_depth_;
+  }
+  /// Samples of a multisampled framebuffer for the rasterization of a tile,
+  /// which leaves the tile to be resolved
+  [[nodiscard]] auto sample_target(std::size_t tile_index) noexcept
+      -> SampleTarget;
+  [[nodiscard]] auto g_buffer_target() noexcept -> GBufferTarget;
+
+private:
+  static constexpr std::uint8_t pending_color = 1;
+  /// Also covers the samples and the hierarchical depth
+  static constexpr std::uint8_t pending_depth = 2;
+
+  int width_ = 0;
+  int height_ = 0;
+  ColorFormat format_ = ColorFormat::rgb32_float;
+  int sample_count_ = 1;
+  /// Holds the pixels of the rgb32_float format
+  Image color_{0, 0};
+  /// Holds the pixels of the 8-bit formats
+  std::vector<std::uint32_t> packed_color_;
+  std::vector<float> depth_;
+  std::vector<float> coarse_depth_;
+  /// Linear colors and compression flags of the samples of a multisampled
+  /// framebuffer
+  std::vector<RGB> sample_color_;
+  std::vector<std::uint8_t> uniform_;
+  std::vector<std::uint32_t> g_buffer_normal_;
+  std::vector<std::uint32_t> g_buffer_albedo_;
+  int tile_count_x_ = 0;
+  /// pending_color and pending_depth flags of every tile
+  std::vector<std::uint8_t> pending_clear_;
+  /// Tiles with samples newer than their color attachment
+  std::vector<std::uint8_t> unresolved_;
+  /// Tiles that hold a pixel of several colors since their last clear
+  std::vector<std::uint8_t> tile_split_;
+  ClearValue clear_value_;
+  /// The clear color, encoded to the format
+  RGB clear_color_;
+  std::uint32_t clear_pixel_ = 0;
+
+  void resolve_color_clear(std::size_t tile_index);
+};
+
+} // namespace yasr
+
+#endif // YASR_FRAMEBUFFER_HPP
@@ -0,0 +1,264 @@
+#include "image_io.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string>
+
+#include <beyond/utils/assert.hpp>
+#include <beyond/utils/bit_cast.hpp>
+#include <stb_image_write.h>
+
+namespace yasr {
+
+namespace {
+
+/// Serializes the little-endian fields of an OpenEXR file
+class ExrWriter {
+public:
+  explicit ExrWriter(std::vector<std::uint8_t>& bytes) : bytes_{bytes}
+  {
+    bytes_.clear();
+  }
+
+  void u8(std::uint8_t value)
+  {
+    bytes_.push_back(value);
+  }
+
+  void u32(std::uint32_t value)
+  {
+    for (int shift = 0; shift < 32; shift += 8) {
+      u8(static_cast<std::uint8_t>(value >> shift));
+    }
+  }
+
+  void i32(std::int32_t value)
+  {
+    u32(static_cast<std::uint32_t>(value));
+  }
+
+  void u64(std::uint64_t value)
+  {
+    for (int shift = 0; shift < 64; shift += 8) {
+      u8(static_cast<std::uint8_t>(value >> shift));
+    }
+  }
+
+  void f32(float value)
+  {
+    u32(std::bit_cast<std::uint32_t>(value));
+  }
+
+  void string(std::string_view value)
+  {
+    bytes_.insert(bytes_.end(), value.begin(), value.end());
+    u8(0);
+  }
+
+  void attribute(std::string_view name, std::string_view type,
+                 std::uint32_t size)
+  {
+    string(name);
+    string(type);
+    u32(size);
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t
+  {
+    return bytes_.size();
+  }
+
+private:
+  std::vector<std::uint8_t>& bytes_;
+};
+
+void encode_exr(const ColorView& image, std::vector<std::uint8_t>& bytes)
+{
+  const int width = image.width;
+  const int height = image.height;
+  ExrWriter out{bytes};
+
+  out.u32(20000630); // Magic number
+  out.u32(2);        // Version 2, single-part scanline image
+
+  // Channels are stored in alphabetical order
+  constexpr std::string_view channel_names[] = {"B", "G", "R"};
+  constexpr std::int32_t float_pixel_type = 2;
+  out.attribute("channels", "chlist", 3 * 18 + 1);
+  for (const auto name : channel_names) {
+    out.string(name);
+    out.i32(float_pixel_type);
+    out.u32(0); // pLinear and reserved bytes
+    out.i32(1); // x sampling
+    out.i32(1); // y sampling
+  }
+  out.u8(0);
+  out.attribute("compression", "compression", 1);
+  out.u8(0); // NO_COMPRESSION
+  for (const auto window : {"dataWindow", "displayWindow"}) {
+    out.attribute(window, "box2i", 16);
+    out.i32(0);
+    out.i32(0);
+    out.i32(width - 1);
+    out.i32(height - 1);
+  }
+  out.attribute("lineOrder", "lineOrder", 1);
+  out.u8(0); // INCREASING_Y
+  out.attribute("pixelAspectRatio", "float", 4);
+  out.f32(1.f);
+  out.attribute("screenWindowCenter", "v2f", 8);
+  out.f32(0.f);
+  out.f32(0.f);
+  out.attribute("screenWindowWidth", "float", 4);
+  out.f32(1.f);
+  out.u8(0); // End of the header
+
+  // Every scan line is a chunk of its y, its size and one run per channel
+  const auto line_size = static_cast<std::uint32_t>(width) * 3 * 4;
+  const std::size_t first_chunk = out.size() + std::size_t{8} * height;
+  for (int y = 0; y < height; ++y) {
+    out.u64(first_chunk + static_cast<std::size_t>(y) * (8 + line_size));
+  }
+  for (int y = 0; y < height; ++y) {
+    out.i32(y);
+    out.u32(line_size);
+    for (int x = 0; x < width; ++x) { out.f32(image.load(x, y).b); }
+    for (int x = 0; x < width; ++x) { out.f32(image.load(x, y).g); }
+    for (int x = 0; x < width; ++x) { out.f32(image.load(x, y).r); }
+  }
+}
+
+auto write_bytes(std::string_view path, std::string_view header,
+                 std::span<const std::uint8_t> bytes) -> bool
+{
+  std::FILE* file = std::fopen(std::string{path}.c_str(), "wb");
+  if (file == nullptr) { return false; }
+  bool ok = std::fwrite(header.data(), 1, header.size(), file) ==
+            header.size();
+  ok = ok && std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  return std::fclose(file) == 0 && ok;
+}
+
+} // anonymous namespace
+
+auto image_file_format(std::string_view path) -> std::optional<ImageFileFormat>
+{
+  const auto dot = path.rfind('.');
+  if (dot == std::string_view::npos) { return std::nullopt; }
+  std::string extension{path.substr(dot + 1)};
+  std::ranges::transform(extension, extension.begin(), [](char c) {
+    return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+  });
+  if (extension == "ppm") { return ImageFileFormat::ppm; }
+  if (extension == "png") { return ImageFileFormat::png; }
+  if (extension == "exr") { return ImageFileFormat::exr; }
+  return std::nullopt;
+}
+
+namespace {
+
+[[nodiscard]] auto quantize(float c) noexcept -> std::uint8_t
+{
+  return static_cast<std::uint8_t>(std::clamp(c, 0.f, 1.f) * 255.99f);
+}
+
+} // anonymous namespace
+
+void encode_rgb8(const ColorView& image, std::vector<std::uint8_t>& rgb8)
+{
+  const std::size_t pixel_count =
+      static_cast<std::size_t>(image.width) * image.height;
+  rgb8.resize(pixel_count * 3);
+
+  if (image.format == ColorFormat::rgb32_float) {
+    const auto* pixels = static_cast<const RGB*>(image.pixels);
+    for (std::size_t i = 0; i < pixel_count; ++i) {
+      rgb8[3 * i + 0] = quantize(pixels[i].r);
+      rgb8[3 * i + 1] = quantize(pixels[i].g);
+      rgb8[3 * i + 2] = quantize(pixels[i].b);
+    }
+    return;
+  }
+
+  const auto* pixels = static_cast<const std::uint32_t*>(image.pixels);
+  const auto [r_shift, g_shift, b_shift, a_shift] =
+      channel_shifts(image.format);
+  for (std::size_t i = 0; i < pixel_count; ++i) {
+    rgb8[3 * i + 0] = static_cast<std::uint8_t>(pixels[i] >> r_shift);
+    rgb8[3 * i + 1] = static_cast<std::uint8_t>(pixels[i] >> g_shift);
+    rgb8[3 * i + 2] = static_cast<std::uint8_t>(pixels[i] >> b_shift);
+  }
+}
+
+void encode_xrgb8(const ColorView& image, std::span<std::byte> pixels,
+                  std::size_t pitch)
+{
+  const auto width = static_cast<std::size_t>(image.width);
+  const auto height = static_cast<std::size_t>(image.height);
+  BEYOND_ASSERT(height == 0 || pixels.size() >= (height - 1) * pitch +
+                                                    width * 4);
+
+  for (std::size_t y = 0; y < height; ++y) {
+    auto* dst = beyond::bit_cast<std::uint32_t*>(pixels.data() + y * pitch);
+    switch (image.format) {
+    case ColorFormat::rgb32_float: {
+      const RGB* src = static_cast<const RGB*>(image.pixels) + y * width;
+      for (std::size_t x = 0; x < width; ++x) {
+        dst[x] = std::uint32_t{quantize(src[x].r)} << 16u |
+                 std::uint32_t{quantize(src[x].g)} << 8u | quantize(src[x].b);
+      }
+      break;
+    }
+    case ColorFormat::bgra8_srgb:
+      std::memcpy(dst,
+                  static_cast<const std::uint32_t*>(image.pixels) + y * width,
+                  width * 4);
+      break;
+    case ColorFormat::rgba8_srgb: {
+      const std::uint32_t* src =
+          static_cast<const std::uint32_t*>(image.pixels) + y * width;
+      const auto [r_shift, g_shift, b_shift, a_shift] =
+          channel_shifts(image.format);
+      for (std::size_t x = 0; x < width; ++x) {
+        dst[x] = (src[x] >> r_shift & 0xFFu) << 16u |
+                 (src[x] >> g_shift & 0xFFu) << 8u |
+                 (src[x] >> b_shift & 0xFFu);
+      }
+      break;
+    }
+    }
+  }
+}
+
+auto write_image(std::string_view path, ImageFileFormat format,
+                 const ColorView& image, std::vector<std::uint8_t>& scratch)
+    -> bool
+{
+  switch (format) {
+  case ImageFileFormat::ppm: {
+    encode_rgb8(image, scratch);
+    const std::string header =
+        "P6\n" + std::to_string(image.width) + " " +
+        std::to_string(image.height) + "\n255\n";
+    return write_bytes(path, header, scratch);
+  }
+  case ImageFileFormat::png:
+    encode_rgb8(image, scratch);
+    return stbi_write_png(std::string{path}.c_str(), image.width,
+                          image.height, 3, scratch.data(),
+                          image.width * 3) != 0;
+  case ImageFileFormat::exr:
+    encode_exr(image, scratch);
+    return write_bytes(path, {}, scratch);
+  }
+  return false;
+}
+
+auto write_raw_rgb8(std::FILE* file, std::span<const std::uint8_t> rgb8)
+    -> bool
+{
+  return std::fwrite(rgb8.data(), 1, rgb8.size(), file) == rgb8.size();
+}
+
+} // namespace yasr
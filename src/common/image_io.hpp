@@ -0,0 +1,64 @@
+#ifndef YASR_IMAGE_IO_HPP
+#define YASR_IMAGE_IO_HPP
+
+#include "color_target.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace yasr {
+
+enum class ImageFileFormat {
+  /// Binary 8-bit RGB portable pixmap
+  ppm,
+  /// 8-bit RGB PNG
+  png,
+  /// Uncompressed 32-bit float RGB OpenEXR
+  exr,
+};
+
+/// Guesses the format from the extension of `path`
+[[nodiscard]] auto image_file_format(std::string_view path)
+    -> std::optional<ImageFileFormat>;
+
+/**
+ * \brief Quantizes `image` to tightly packed 8-bit RGB rows, top row first
+ *
+ * Float channels are clamped to [0, 1] without any transfer function, 8-bit
+ * channels are copied. `rgb8` is resized, so callers can reuse it between
+ * frames.
+ */
+void encode_rgb8(const ColorView& image, std::vector<std::uint8_t>& rgb8);
+
+/**
+ * \brief Converts `image` to 32-bit 0x00RRGGBB pixels in native byte order
+ *
+ * This is the layout of SDL_PIXELFORMAT_RGB888 textures, bgra8_srgb images are
+ * copied row by row. Row y starts at byte y * `pitch` of `pixels`, which must
+ * be suitably aligned for std::uint32_t.
+ */
+void encode_xrgb8(const ColorView& image, std::span<std::byte> pixels,
+                  std::size_t pitch);
+
+/**
+ * \brief Writes `image` to the file at `path`
+ *
+ * `scratch` holds the 8-bit encoding and is reused between calls. Returns false
+ * on I/O errors.
+ */
+[[nodiscard]] auto write_image(std::string_view path, ImageFileFormat format,
+                               const ColorView& image,
+                               std::vector<std::uint8_t>& scratch) -> bool;
+
+/// Writes the packed 8-bit RGB rows of a frame to `file`, without a header
+[[nodiscard]] auto write_raw_rgb8(std::FILE* file,
+                                  std::span<const std::uint8_t> rgb8) -> bool;
+
+} // namespace yasr
+
+#endif // YASR_IMAGE_IO_HPP
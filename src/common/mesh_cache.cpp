@@ -0,0 +1,143 @@
+#include "mesh_cache.hpp"
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <beyond/utils/panic.hpp>
+#include <spdlog/spdlog.h>
+
+namespace yasr {
+
+namespace {
+
+constexpr std::array<char, 8> mesh_cache_magic{'Y', 'A', 'S', 'R',
+                                               'M', 'E', 'S', 'H'};
+
+struct MeshCacheHeader {
+  std::array<char, 8> magic = mesh_cache_magic;
+  std::uint32_t version = mesh_cache_version;
+  std::uint32_t vertex_size = sizeof(Vertex);
+  std::uint64_t source_hash = 0;
+  std::uint64_t vertex_count = 0;
+  std::uint64_t index_count = 0;
+};
+static_assert(sizeof(MeshCacheHeader) % alignof(Vertex) == 0);
+static_assert((sizeof(MeshCacheHeader) + sizeof(Vertex)) %
+                  alignof(std::uint32_t) ==
+              0);
+
+} // anonymous namespace
+
+auto hash_bytes(std::span<const std::byte> bytes) noexcept -> std::uint64_t
+{
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (const auto byte : bytes) {
+    hash ^= static_cast<std::uint64_t>(byte);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+auto write_mesh_cache(std::string_view path, const Mesh& mesh,
+                      std::uint64_t source_hash) -> bool
+{
+  const MeshCacheHeader header{
+      .source_hash = source_hash,
+      .vertex_count = mesh.vertices.size(),
+      .index_count = mesh.indices.size(),
+  };
+
+  const std::filesystem::path final_path{path};
+  std::filesystem::path temporary_path = final_path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    const auto write = [&](std::span<const std::byte> bytes) {
+      file.write(reinterpret_cast<const char*>(bytes.data()),
+                 static_cast<std::streamsize>(bytes.size()));
+    };
+    write(std::as_bytes(std::span{&header, 1}));
+    write(std::as_bytes(std::span{mesh.vertices}));
+    write(std::as_bytes(std::span{mesh.indices}));
+    if (!file) { return false; }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, final_path, error);
+  return !error;
+}
+
+auto CachedMesh::open(std::string_view path, std::uint64_t source_hash)
+    -> std::optional<CachedMesh>
+{
+  std::optional<MappedFile> file = MappedFile::open(path);
+  if (!file) { return std::nullopt; }
+
+  const std::span<const std::byte> bytes = file->bytes();
+  MeshCacheHeader header;
+  if (bytes.size() < sizeof(header)) { return std::nullopt; }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != mesh_cache_magic ||
+      header.version != mesh_cache_version ||
+      header.vertex_size != sizeof(Vertex) ||
+      header.source_hash != source_hash) {
+    return std::nullopt;
+  }
+
+  if (header.vertex_count > bytes.size() / sizeof(Vertex) ||
+      header.index_count > bytes.size() / sizeof(std::uint32_t)) {
+    return std::nullopt;
+  }
+  const std::size_t vertices_size = header.vertex_count * sizeof(Vertex);
+  const std::size_t indices_size = header.index_count * sizeof(std::uint32_t);
+  if (bytes.size() != sizeof(header) + vertices_size + indices_size) {
+    return std::nullopt;
+  }
+
+  // The mapping is page aligned and the header size keeps both arrays aligned
+  const std::byte* vertices = bytes.data() + sizeof(header);
+  const std::byte* indices = vertices + vertices_size;
+  CachedMesh mesh{std::move(file)};
+  mesh.vertices_ = {reinterpret_cast<const Vertex*>(vertices),
+                    header.vertex_count};
+  mesh.indices_ = {reinterpret_cast<const std::uint32_t*>(indices),
+                   header.index_count};
+  return mesh;
+}
+
+auto mesh_cache_path(std::string_view obj_path) -> std::string
+{
+  return std::string{obj_path} + ".meshcache";
+}
+
+auto load_cached_mesh(std::string_view obj_path) -> CachedMesh
+{
+  const std::optional<MappedFile> source = MappedFile::open(obj_path);
+  if (!source) {
+    beyond::panic(fmt::format("Cannot open file {}", obj_path));
+  }
+  const std::uint64_t source_hash = hash_bytes(source->bytes());
+
+  const std::string cache_path = mesh_cache_path(obj_path);
+  if (auto cached = CachedMesh::open(cache_path, source_hash)) {
+    return std::move(*cached);
+  }
+
+  spdlog::info("{}: building mesh cache {}", obj_path, cache_path);
+  Mesh mesh = prepare_mesh(load_obj(obj_path));
+  if (write_mesh_cache(cache_path, mesh, source_hash)) {
+    if (auto cached = CachedMesh::open(cache_path, source_hash)) {
+      return std::move(*cached);
+    }
+  }
+
+  spdlog::warn("{}: cannot write mesh cache {}", obj_path, cache_path);
+  CachedMesh result{std::nullopt, std::move(mesh)};
+  result.vertices_ = result.mesh_.vertices;
+  result.indices_ = result.mesh_.indices;
+  return result;
+}
+
+} // namespace yasr
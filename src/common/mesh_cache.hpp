@@ -0,0 +1,89 @@
+#ifndef YASR_MESH_CACHE_HPP
+#define YASR_MESH_CACHE_HPP
+
+#include "file_util.hpp"
+#include "model.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace yasr {
+
+/// Bumped whenever the file layout or the output of prepare_mesh() changes
+constexpr std::uint32_t mesh_cache_version = 1;
+
+/// 64-bit FNV-1a hash, used to detect changes of a cached source file
+[[nodiscard]] auto hash_bytes(std::span<const std::byte> bytes) noexcept
+    -> std::uint64_t;
+
+/**
+ * \brief Writes `mesh` as a binary mesh cache
+ *
+ * The file is a header followed by the packed `Vertex` and index arrays, in the
+ * host's byte order. It is written to a temporary file that is then renamed,
+ * so readers never observe a partial cache. Returns false on I/O errors.
+ */
+[[nodiscard]] auto write_mesh_cache(std::string_view path, const Mesh& mesh,
+                                    std::uint64_t source_hash) -> bool;
+
+/**
+ * \brief A mesh memory-mapped from a binary mesh cache
+ *
+ * vertices() and indices() point into the mapping, so they can be handed to
+ * BufferDesc without copying or parsing.
+ */
+class CachedMesh {
+public:
+  /// Maps the cache at `path`. Returns nullopt if the file is missing, was
+  /// written by another version or for another `Vertex` layout, is truncated,
+  /// or was built from a source whose hash differs from `source_hash`.
+  [[nodiscard]] static auto open(std::string_view path,
+                                 std::uint64_t source_hash)
+      -> std::optional<CachedMesh>;
+
+  [[nodiscard]] auto vertices() const noexcept -> std::span<const Vertex>
+  {
+    return vertices_;
+  }
+
+  [[nodiscard]] auto indices() const noexcept
+      -> std::span<const std::uint32_t>
+  {
+    return indices_;
+  }
+
+private:
+  explicit CachedMesh(std::optional<MappedFile> file, Mesh mesh = {}) noexcept
+      : file_{std::move(file)}, mesh_{std::move(mesh)}
+  {
+  }
+
+  friend auto load_cached_mesh(std::string_view obj_path) -> CachedMesh;
+
+  std::optional<MappedFile> file_;
+  /// Owns the mesh when its cache could not be written
+  Mesh mesh_;
+  std::span<const Vertex> vertices_;
+  std::span<const std::uint32_t> indices_;
+};
+
+/// Path of the cache that load_cached_mesh() keeps for `obj_path`
+[[nodiscard]] auto mesh_cache_path(std::string_view obj_path) -> std::string;
+
+/**
+ * \brief Loads an OBJ file through its binary mesh cache
+ *
+ * If the cache is missing or stale, the OBJ file is parsed, passed through
+ * prepare_mesh() and the cache is rewritten before being mapped. If the cache
+ * cannot be written, the prepared mesh is returned from memory instead.
+ */
+[[nodiscard]] auto load_cached_mesh(std::string_view obj_path) -> CachedMesh;
+
+} // namespace yasr
+
+#endif // YASR_MESH_CACHE_HPP
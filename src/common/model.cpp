@@ -1,4 +1,231 @@
 #include "model.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include <beyond/utils/assert.hpp>
+#include <beyond/utils/panic.hpp>
+
 #define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
\ No newline at end of file
+#include <tiny_obj_loader.h>
+
+namespace yasr {
+
+auto load_obj(std::string_view filename) -> Mesh
+{
+  tinyobj::attrib_t attrib;
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+  std::string err;
+
+  if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err,
+                        std::string{filename}.c_str())) {
+    beyond::panic(err);
+  }
+
+  Mesh mesh;
+  for (const auto& shape : shapes) {
+    for (const auto& index : shape.mesh.indices) {
+      mesh.vertices.emplace_back(Vertex{
+          .pos = {attrib.vertices[3 * index.vertex_index + 0],
+                  attrib.vertices[3 * index.vertex_index + 1],
+                  attrib.vertices[3 * index.vertex_index + 2]},
+          .normal =
+              {
+                  attrib.normals[3 * index.normal_index + 0],
+                  attrib.normals[3 * index.normal_index + 1],
+                  attrib.normals[3 * index.normal_index + 2],
+              },
+          .texcoord = {attrib.texcoords[2 * index.texcoord_index + 0],
+                       attrib.texcoords[2 * index.texcoord_index + 1]},
+      });
+      mesh.indices.push_back(
+          static_cast<std::uint32_t>(mesh.indices.size()));
+    }
+  }
+  return mesh;
+}
+
+namespace {
+
+/// Vertices are compared and hashed by their bytes
+struct VertexBytes {
+  const Vertex* vertex = nullptr;
+
+  [[nodiscard]] friend auto operator==(VertexBytes lhs, VertexBytes rhs)
+      -> bool
+  {
+    return std::memcmp(lhs.vertex, rhs.vertex, sizeof(Vertex)) == 0;
+  }
+};
+
+struct VertexBytesHash {
+  [[nodiscard]] auto operator()(VertexBytes v) const noexcept -> std::size_t
+  {
+    return std::hash<std::string_view>{}(std::string_view{
+        reinterpret_cast<const char*>(v.vertex), sizeof(Vertex)});
+  }
+};
+
+} // anonymous namespace
+
+auto weld_vertices(const Mesh& mesh) -> Mesh
+{
+  Mesh result;
+  result.indices.reserve(mesh.indices.size());
+
+  std::unordered_map<VertexBytes, std::uint32_t, VertexBytesHash> welded;
+  welded.reserve(mesh.indices.size());
+  for (const auto index : mesh.indices) {
+    BEYOND_ASSERT(index < mesh.vertices.size());
+    const auto [it, inserted] = welded.try_emplace(
+        VertexBytes{&mesh.vertices[index]},
+        static_cast<std::uint32_t>(result.vertices.size()));
+    if (inserted) { result.vertices.push_back(mesh.vertices[index]); }
+    result.indices.push_back(it->second);
+  }
+  return result;
+}
+
+void optimize_vertex_cache(std::span<std::uint32_t> indices,
+                           std::size_t vertex_count, std::size_t cache_size)
+{
+  const std::size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) { return; }
+
+  // Triangles adjacent to each vertex, in compressed sparse row layout
+  std::vector<std::uint32_t> live(vertex_count, 0);
+  for (const auto index : indices) { ++live[index]; }
+  std::vector<std::uint32_t> adjacency_offsets(vertex_count + 1, 0);
+  for (std::size_t v = 0; v < vertex_count; ++v) {
+    adjacency_offsets[v + 1] = adjacency_offsets[v] + live[v];
+  }
+  std::vector<std::uint32_t> adjacency(indices.size());
+  {
+    std::vector<std::uint32_t> cursor(adjacency_offsets.begin(),
+                                      adjacency_offsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+      adjacency[cursor[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+  }
+
+  // Time stamps of when each vertex entered the simulated FIFO cache
+  std::vector<std::size_t> cache_time(vertex_count, 0);
+  std::size_t timestamp = cache_size + 1;
+  std::vector<bool> emitted(triangle_count, false);
+  std::vector<std::uint32_t> dead_end;
+  std::vector<std::uint32_t> candidates;
+  std::vector<std::uint32_t> output;
+  output.reserve(indices.size());
+
+  std::size_t next_vertex = 0;
+  const auto skip_dead_end = [&]() -> std::optional<std::uint32_t> {
+    while (!dead_end.empty()) {
+      const auto v = dead_end.back();
+      dead_end.pop_back();
+      if (live[v] > 0) { return v; }
+    }
+    for (; next_vertex < vertex_count; ++next_vertex) {
+      if (live[next_vertex] > 0) {
+        return static_cast<std::uint32_t>(next_vertex);
+      }
+    }
+    return std::nullopt;
+  };
+
+  // The next fanning vertex is the candidate that stays in the cache longest
+  // while its remaining triangles are emitted
+  const auto next_fanning_vertex = [&]() -> std::optional<std::uint32_t> {
+    std::optional<std::uint32_t> best;
+    std::size_t best_priority = 0;
+    for (const auto v : candidates) {
+      if (live[v] == 0) { continue; }
+      std::size_t priority = 0;
+      if (timestamp - cache_time[v] + 2 * live[v] <= cache_size) {
+        priority = timestamp - cache_time[v];
+      }
+      if (!best || priority > best_priority) {
+        best = v;
+        best_priority = priority;
+      }
+    }
+    return best ? best : skip_dead_end();
+  };
+
+  std::optional<std::uint32_t> fanning = indices[0];
+  while (fanning) {
+    candidates.clear();
+    const std::uint32_t f = *fanning;
+    for (std::uint32_t i = adjacency_offsets[f]; i < adjacency_offsets[f + 1];
+         ++i) {
+      const std::uint32_t triangle = adjacency[i];
+      if (emitted[triangle]) { continue; }
+      emitted[triangle] = true;
+      for (std::size_t corner = 0; corner < 3; ++corner) {
+        const std::uint32_t v = indices[3 * triangle + corner];
+        output.push_back(v);
+        dead_end.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (timestamp - cache_time[v] > cache_size) {
+          cache_time[v] = timestamp++;
+        }
+      }
+    }
+    fanning = next_fanning_vertex();
+  }
+
+  BEYOND_ASSERT(output.size() == triangle_count * 3);
+  std::ranges::copy(output, indices.begin());
+}
+
+void optimize_vertex_fetch(Mesh& mesh)
+{
+  constexpr auto unused = std::numeric_limits<std::uint32_t>::max();
+  std::vector<std::uint32_t> remap(mesh.vertices.size(), unused);
+  std::vector<Vertex> vertices;
+  vertices.reserve(mesh.vertices.size());
+
+  for (auto& index : mesh.indices) {
+    if (remap[index] == unused) {
+      remap[index] = static_cast<std::uint32_t>(vertices.size());
+      vertices.push_back(mesh.vertices[index]);
+    }
+    index = remap[index];
+  }
+  mesh.vertices = std::move(vertices);
+}
+
+auto average_cache_miss_ratio(std::span<const std::uint32_t> indices,
+                              std::size_t vertex_count, std::size_t cache_size)
+    -> float
+{
+  const std::size_t triangle_count = indices.size() / 3;
+  if (triangle_count == 0) { return 0; }
+
+  // A FIFO cache: vertex v is cached while fewer than cache_size misses
+  // happened after its own
+  std::vector<std::size_t> miss_time(vertex_count, 0);
+  std::size_t misses = 0;
+  for (const auto index : indices) {
+    if (miss_time[index] == 0 || misses - miss_time[index] >= cache_size) {
+      ++misses;
+      miss_time[index] = misses;
+    }
+  }
+  return static_cast<float>(misses) / static_cast<float>(triangle_count);
+}
+
+auto prepare_mesh(const Mesh& mesh) -> Mesh
+{
+  Mesh result = weld_vertices(mesh);
+  optimize_vertex_cache(result.indices, result.vertices.size());
+  optimize_vertex_fetch(result);
+  return result;
+}
+
+} // namespace yasr
@@ -0,0 +1,410 @@
+#ifndef YASR_PIPELINE_HPP
+#define YASR_PIPELINE_HPP
+
+#include "clipping.hpp"
+#include "raster_kernel.hpp"
+#include "rasterizer.hpp"
+#include "thread_pool.hpp"
+#include "vertex_processing.hpp"
+#include "yasr.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <beyond/math/matrix.hpp>
+#include <beyond/math/transform.hpp>
+#include <beyond/math/vector.hpp>
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+/// The view and projection transform of `camera`
+[[nodiscard]] inline auto view_projection(const Camera& camera, float aspect)
+    -> beyond::Mat4
+{
+  return beyond::perspective(camera.fov_y, aspect, camera.z_near,
+                             camera.z_far) *
+         beyond::look_at(camera.eye, camera.target, camera.up);
+}
+
+/// Output of a vertex shader
+template <typename Varyings> struct ShadedVertex {
+  /// Position in homogeneous clip space
+  beyond::Vec4 position;
+  Varyings varyings;
+};
+
+/// The bindings a pipeline reads during one draw
+struct DrawInputs {
+  std::span<const Vertex> vertices;
+  /// Slots of the vertices the draw references
+  const VertexCache& vertex_cache;
+  /// Contents of the bound constant buffer
+  std::span<const std::byte> constants;
+  /// The bound texture, without levels if none is bound
+  TextureView texture;
+  Rect viewport;
+  /// Model transforms of the instances of the draw. Instance k owns the
+  /// slots from first_slot + k * vertex_cache.unique_vertices().size().
+  std::span<const beyond::Mat4> instance_transforms;
+  std::size_t first_slot = 0;
+};
+
+/// A triangle after primitive assembly and clipping, before setup
+struct AssembledTriangle {
+  /// Vertex cache slots of the input triangle
+  std::array<std::uint32_t, 3> slots{};
+  std::array<ScreenVertex, 3> screen;
+  /// Whether the triangle is a part of the input triangle cut by clipping,
+  /// its vertices then lie at `weights` of the input triangle
+  bool clipped = false;
+  std::array<beyond::Vec2, 3> weights;
+};
+
+/**
+ * \brief The type-erased side of a ShaderPipeline
+ *
+ * The device calls it once per draw, per setup batch or per triangle. The
+ * per-fragment work runs inside the run rasterizers of the pipeline, or
+ * inside shade_visible() once per tile.
+ */
+class PipelineProgram {
+public:
+  /**
+   * \brief Runs the vertex shader on every vertex of every instance of the
+   * draw
+   *
+   * Also binds the uniforms and texture of the draw. Writes the screen
+   * positions and clip flags of the slots of the instances to `out`, which
+   * must hold them. A multi-draw calls it once per draw, with increasing
+   * slots.
+   */
+  virtual void shade_vertices(const DrawInputs& inputs,
+                              PostTransformVertices& out,
+                              ThreadPool& thread_pool) = 0;
+
+  /// Clip-space position of a slot of the vertex cache of the current draw
+  [[nodiscard]] virtual auto clip_position(std::uint32_t slot) const
+      -> beyond::Vec4 = 0;
+
+  /// Discards the varyings of the previous draw and makes room for the
+  /// triangles of `batch_count` setup batches
+  virtual void begin_setup(std::size_t batch_count) = 0;
+
+  /**
+   * \brief Interpolation setup of the varyings of `triangle`, which set up as
+   * `setup`
+   *
+   * Batches may be set up concurrently, every batch by a single thread. The
+   * result stays valid until the next begin_setup().
+   */
+  [[nodiscard]] virtual auto
+  triangle_varyings(std::size_t batch, const AssembledTriangle& triangle,
+                    const TriangleSetup& setup) -> const void* = 0;
+
+  /// The rasterizer of the pipeline, which takes the pipeline as its context
+  [[nodiscard]] virtual auto run_rasterizer() const noexcept
+      -> RunRasterizer = 0;
+  /// The rasterizer of the pipeline for multisampled framebuffers, which
+  /// takes the pipeline as its context
+  [[nodiscard]] virtual auto multisampled_run_rasterizer() const noexcept
+      -> MultisampledRunRasterizer = 0;
+  /// Shades the visible pixels of `tile` of a visibility buffer, see
+  /// detail::shade_visible()
+  virtual void shade_visible(std::span<const TriangleSetup* const> triangles,
+                             const Rect& tile,
+                             const VisibilityTarget& visibility,
+                             const ColorTarget& target,
+                             PipelineStats& stats) const = 0;
+
+  PipelineProgram() = default;
+  virtual ~PipelineProgram() = default;
+  PipelineProgram(const PipelineProgram&) = delete;
+  auto operator=(const PipelineProgram&) & -> PipelineProgram& = delete;
+  PipelineProgram(PipelineProgram&&) noexcept = delete;
+  auto operator=(PipelineProgram&&) & noexcept -> PipelineProgram& = delete;
+};
+
+/**
+ * \brief A pipeline of user shaders, specialized at compile time
+ *
+ * The vertex shader is called as `vertex_shader(const Vertex&, const
+ * Uniforms&) -> ShadedVertex<Varyings>`, or with the model transform of the
+ * instance as a third `const beyond::Mat4&` argument if it takes one. The
+ * fragment shader is called as
+ * `fragment_shader(const Varyings&, const Uniforms&, const TextureView&) ->
+ * RGB`. Its result is a linear color, which the color attachment encodes to
+ * its format. The raster loop is instantiated for the shader types, so both
+ * shaders can be inlined into it.
+ *
+ * Varyings are perspective-correct interpolated, they must be a trivially
+ * copyable struct of floats. Uniforms are copied from the bound constant
+ * buffer at every draw.
+ */
+template <typename Uniforms, typename Varyings, typename VertexShader,
+          typename FragmentShader>
+class ShaderPipeline final : public PipelineProgram {
+  static_assert(std::is_trivially_copyable_v<Uniforms>);
+  static_assert(std::is_trivially_copyable_v<Varyings> &&
+                    sizeof(Varyings) % sizeof(float) == 0,
+                "Varyings must be a struct of floats");
+
+  static constexpr std::size_t varying_count =
+      sizeof(Varyings) / sizeof(float);
+  using Floats = std::array<float, varying_count>;
+
+  /// Varyings divided by w at vertex 0 and their changes towards vertex 1
+  /// and 2, interpolated like the texture coordinates of TriangleSetup
+  struct TriangleVaryings {
+    Floats v0{};
+    Floats d1{};
+    Floats d2{};
+  };
+
+public:
+  ShaderPipeline(VertexShader vertex_shader, FragmentShader fragment_shader)
+      : vertex_shader_{std::move(vertex_shader)},
+        fragment_shader_{std::move(fragment_shader)}
+  {
+  }
+
+  void shade_vertices(const DrawInputs& inputs, PostTransformVertices& out,
+                      ThreadPool& thread_pool) override
+  {
+    BEYOND_ASSERT(inputs.constants.size() >= sizeof(Uniforms));
+    std::memcpy(&uniforms_, inputs.constants.data(), sizeof(Uniforms));
+    texture_ = inputs.texture;
+
+    const std::span<const std::uint32_t> unique_vertices =
+        inputs.vertex_cache.unique_vertices();
+    const std::size_t total =
+        inputs.instance_transforms.size() * unique_vertices.size();
+    BEYOND_ASSERT(out.x.size() >= inputs.first_slot + total);
+    if (vertices_.size() < inputs.first_slot + total) {
+      vertices_.resize(inputs.first_slot + total);
+    }
+    const GuardBand band = guard_band(inputs.viewport);
+
+    constexpr std::size_t vertices_per_task = 1024;
+    thread_pool.parallel_for(
+        (total + vertices_per_task - 1) / vertices_per_task,
+        [&](std::size_t task) {
+          const std::size_t last =
+              std::min((task + 1) * vertices_per_task, total);
+          for (std::size_t item = task * vertices_per_task; item < last;
+               ++item) {
+            const Vertex& input =
+                inputs.vertices[unique_vertices[item % unique_vertices.size()]];
+            const beyond::Mat4& model =
+                inputs.instance_transforms[item / unique_vertices.size()];
+            const std::size_t slot = inputs.first_slot + item;
+            const ShadedVertex<Varyings>& vertex = vertices_[slot] =
+                shade_vertex(input, model);
+            const beyond::Vec4& pos = vertex.position;
+            const ScreenVertex screen =
+                to_screen(pos.x, pos.y, pos.z, pos.w, inputs.viewport);
+            out.x[slot] = screen.pos.x;
+            out.y[slot] = screen.pos.y;
+            out.z[slot] = screen.pos.z;
+            out.inv_w[slot] = screen.inv_w;
+            out.clip_flags[slot] = clip_flags(pos.x, pos.y, pos.z, pos.w, band);
+          }
+        });
+  }
+
+  [[nodiscard]] auto clip_position(std::uint32_t slot) const
+      -> beyond::Vec4 override
+  {
+    return vertices_[slot].position;
+  }
+
+  void begin_setup(std::size_t batch_count) override
+  {
+    batch_varyings_.resize(batch_count);
+    for (auto& batch : batch_varyings_) { batch.clear(); }
+  }
+
+  [[nodiscard]] auto triangle_varyings(std::size_t batch,
+                                       const AssembledTriangle& triangle,
+                                       const TriangleSetup& setup)
+      -> const void* override
+  {
+    std::array<Floats, 3> inputs;
+    for (std::size_t j = 0; j < 3; ++j) {
+      inputs[j] =
+          std::bit_cast<Floats>(vertices_[triangle.slots[j]].varyings);
+    }
+
+    // Varyings divided by w, in the vertex order of the setup
+    std::array<Floats, 3> values;
+    std::array<std::size_t, 3> order{0, 1, 2};
+    if (setup.swapped) { std::swap(order[1], order[2]); }
+    for (std::size_t j = 0; j < 3; ++j) {
+      const std::size_t vertex = order[j];
+      const float inv_w = triangle.screen[vertex].inv_w;
+      for (std::size_t k = 0; k < varying_count; ++k) {
+        const float value =
+            triangle.clipped
+                ? interpolate(inputs[0][k], inputs[1][k], inputs[2][k],
+                              triangle.weights[vertex])
+                : inputs[vertex][k];
+        values[j][k] = value * inv_w;
+      }
+    }
+
+    TriangleVaryings& result = batch_varyings_[batch].emplace_back();
+    for (std::size_t k = 0; k < varying_count; ++k) {
+      result.v0[k] = values[0][k];
+      result.d1[k] = values[1][k] - values[0][k];
+      result.d2[k] = values[2][k] - values[0][k];
+    }
+    return &result;
+  }
+
+  [[nodiscard]] auto run_rasterizer() const noexcept -> RunRasterizer override
+  {
+    return &rasterize_run;
+  }
+
+  [[nodiscard]] auto multisampled_run_rasterizer() const noexcept
+      -> MultisampledRunRasterizer override
+  {
+    return &rasterize_run_multisampled;
+  }
+
+  void shade_visible(std::span<const TriangleSetup* const> triangles,
+                     const Rect& tile, const VisibilityTarget& visibility,
+                     const ColorTarget& target,
+                     PipelineStats& stats) const override
+  {
+    detail::shade_visible(triangles, tile, visibility, target, stats,
+                          [&](const TriangleSetup& setup, float l1, float l2) {
+                            return shade_pixel(setup, l1, l2);
+                          });
+  }
+
+private:
+  [[nodiscard]] auto shade_vertex(const Vertex& vertex,
+                                  const beyond::Mat4& model) const
+      -> ShadedVertex<Varyings>
+  {
+    if constexpr (std::is_invocable_v<const VertexShader&, const Vertex&,
+                                      const Uniforms&, const beyond::Mat4&>) {
+      return vertex_shader_(vertex, uniforms_, model);
+    } else {
+      return vertex_shader_(vertex, uniforms_);
+    }
+  }
+
+  VertexShader vertex_shader_;
+  FragmentShader fragment_shader_;
+  Uniforms uniforms_{};
+  TextureView texture_;
+  /// Shaded vertices of the current draw, indexed by vertex cache slot
+  std::vector<ShadedVertex<Varyings>> vertices_;
+  /// Varyings of the triangles of every setup batch. A deque keeps them in
+  /// place while a batch grows.
+  std::vector<std::deque<TriangleVaryings>> batch_varyings_;
+
+  /// Runs the fragment shader on the varyings interpolated at the barycentric
+  /// weights (l1, l2) of vertex 1 and 2
+  [[nodiscard]] auto shade_pixel(const TriangleSetup& setup, float l1,
+                                 float l2) const -> RGB
+  {
+    const auto& varyings =
+        *static_cast<const TriangleVaryings*>(setup.varyings);
+    const float w =
+        1.f / (setup.inv_w0 + l1 * setup.dinv_w1 + l2 * setup.dinv_w2);
+    Floats values;
+    for (std::size_t k = 0; k < varying_count; ++k) {
+      values[k] =
+          (varyings.v0[k] + l1 * varyings.d1[k] + l2 * varyings.d2[k]) * w;
+    }
+    return fragment_shader_(std::bit_cast<Varyings>(values), uniforms_,
+                            texture_);
+  }
+
+  /// The scalar raster loop of rasterize_span_scalar() with the varyings and
+  /// the fragment shader of this pipeline
+  static auto rasterize_run(const void* context, const TriangleSetup& setup,
+                            const Rect& run, std::vector<float>& depth_buffer,
+                            const ColorTarget& target) -> FragmentCounts
+  {
+    const auto& self = *static_cast<const ShaderPipeline*>(context);
+    const detail::SpanSetup span = detail::make_span_setup(setup, run);
+    const auto& [e0, e1, e2] = setup.edges;
+    FragmentCounts counts;
+
+    for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+      const detail::RowStart row = detail::row_start(setup, span, y);
+      const int offset = span.rect.min.x - span.anchor_x;
+      std::int64_t w0 = row.w0 + e0.step_x * offset;
+      std::int64_t w1 = row.w1 + e1.step_x * offset;
+      std::int64_t w2 = row.w2 + e2.step_x * offset;
+
+      for (int x = span.rect.min.x; x < span.rect.max.x; ++x) {
+        if ((w0 | w1 | w2) >= 0) {
+          ++counts.tested;
+          const float dx = static_cast<float>(x - span.anchor_x);
+          const float l1 = row.l1 + dx * span.l1_dx;
+          const float l2 = row.l2 + dx * span.l2_dx;
+
+          float& depth = depth_buffer[y * target.width + x];
+          const float z = setup.z0 + l1 * setup.dz1 + l2 * setup.dz2;
+          if (depth < z) {
+            depth = z;
+            ++counts.passed;
+            target.store(x, y, self.shade_pixel(setup, l1, l2));
+          }
+        }
+
+        w0 += e0.step_x;
+        w1 += e1.step_x;
+        w2 += e2.step_x;
+      }
+    }
+    return counts;
+  }
+
+  /// detail::rasterize_run_multisampled() with the varyings and the fragment
+  /// shader of this pipeline
+  static auto rasterize_run_multisampled(const void* context,
+                                         const TriangleSetup& setup,
+                                         const Rect& run,
+                                         const SampleSteps& steps,
+                                         const SampleTarget& target)
+      -> FragmentCounts
+  {
+    const auto& self = *static_cast<const ShaderPipeline*>(context);
+    return detail::rasterize_run_multisampled(
+        setup, run, steps, target, [&](float l1, float l2) {
+          return self.shade_pixel(setup, l1, l2);
+        });
+  }
+};
+
+/// Builds a ShaderPipeline for Device::create_pipeline()
+template <typename Uniforms, typename Varyings, typename VertexShader,
+          typename FragmentShader>
+[[nodiscard]] auto make_pipeline(VertexShader vertex_shader,
+                                 FragmentShader fragment_shader)
+    -> std::unique_ptr<PipelineProgram>
+{
+  return std::make_unique<
+      ShaderPipeline<Uniforms, Varyings, VertexShader, FragmentShader>>(
+      std::move(vertex_shader), std::move(fragment_shader));
+}
+
+} // namespace yasr
+
+#endif // YASR_PIPELINE_HPP
@@ -0,0 +1,97 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace yasr {
+
+auto stage_name(PipelineStage stage) noexcept -> std::string_view
+{
+  switch (stage) {
+  case PipelineStage::vertex:
+    return "vertex";
+  case PipelineStage::setup:
+    return "setup";
+  case PipelineStage::binning:
+    return "binning";
+  case PipelineStage::raster:
+    return "raster";
+  case PipelineStage::lighting:
+    return "lighting";
+  case PipelineStage::resolve:
+    return "resolve";
+  case PipelineStage::present:
+    return "present";
+  }
+  return "unknown";
+}
+
+void Profiler::begin_frame()
+{
+  const std::scoped_lock lock{mutex_};
+  stage_times_ = {};
+  ++frame_;
+}
+
+void Profiler::record(PipelineStage stage, Clock::time_point begin,
+                      Clock::time_point end)
+{
+  const std::scoped_lock lock{mutex_};
+  stage_times_[static_cast<std::size_t>(stage)] += end - begin;
+  if (!tracing_) { return; }
+
+  const auto id = std::this_thread::get_id();
+  auto thread = std::ranges::find(threads_, id);
+  if (thread == threads_.end()) {
+    threads_.push_back(id);
+    thread = threads_.end() - 1;
+  }
+  events_.push_back(TraceEvent{
+      .stage = stage,
+      .frame = frame_,
+      .thread = static_cast<std::uint32_t>(thread - threads_.begin()),
+      .begin = begin,
+      .duration = end - begin,
+  });
+}
+
+auto Profiler::stage_times() const -> StageTimes
+{
+  const std::scoped_lock lock{mutex_};
+  return stage_times_;
+}
+
+void Profiler::set_tracing(bool enabled)
+{
+  const std::scoped_lock lock{mutex_};
+  tracing_ = enabled;
+}
+
+auto Profiler::write_chrome_trace(std::string_view path) const -> bool
+{
+  const std::scoped_lock lock{mutex_};
+  std::ofstream file{std::string{path}};
+  if (!file) { return false; }
+
+  // Timestamps and durations are in microseconds
+  const auto microseconds = [](Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+  };
+  file << std::fixed << std::setprecision(3);
+  file << R"({"displayTimeUnit":"ms","traceEvents":[)";
+  for (std::size_t i = 0; i < events_.size(); ++i) {
+    const TraceEvent& event = events_[i];
+    file << (i == 0 ? "\n" : ",\n") << R"({"name":")"
+         << stage_name(event.stage) << R"(","cat":"yasr","ph":"X","pid":0,)"
+         << R"("tid":)" << event.thread
+         << R"(,"ts":)" << microseconds(event.begin - origin_)
+         << R"(,"dur":)" << microseconds(event.duration)
+         << R"(,"args":{"frame":)" << event.frame << "}}";
+  }
+  file << "\n]}\n";
+  return static_cast<bool>(file);
+}
+
+} // namespace yasr
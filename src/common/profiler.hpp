@@ -0,0 +1,112 @@
+#ifndef YASR_PROFILER_HPP
+#define YASR_PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace yasr {
+
+enum class PipelineStage : std::uint8_t {
+  /// Vertex transform of the unique vertices of a draw
+  vertex,
+  /// Primitive assembly and triangle setup
+  setup,
+  /// Sorting triangles into screen tiles
+  binning,
+  /// Rasterization, depth test and shading, which the kernels fuse
+  raster,
+  /// Tiled light culling and shading of the G-buffer of deferred shading
+  lighting,
+  /// Resolving pending clears before the color attachment is read back
+  resolve,
+  /// Handing a finished frame to the window or an encoder
+  present,
+};
+
+constexpr std::size_t pipeline_stage_count = 7;
+
+[[nodiscard]] auto stage_name(PipelineStage stage) noexcept -> std::string_view;
+
+/**
+ * \brief Collects the time spent in every pipeline stage
+ *
+ * Stage times are summed from the last begin_frame(). While tracing, every
+ * interval is also kept for write_chrome_trace(). Recording is thread-safe and
+ * costs two clock reads and an uncontended lock per interval.
+ */
+class Profiler {
+public:
+  using Clock = std::chrono::steady_clock;
+  using StageTimes = std::array<Clock::duration, pipeline_stage_count>;
+
+  /// Resets the stage times and starts the next frame of the trace
+  void begin_frame();
+
+  void record(PipelineStage stage, Clock::time_point begin,
+              Clock::time_point end);
+
+  /// Time spent in each stage since begin_frame(), indexed by PipelineStage
+  [[nodiscard]] auto stage_times() const -> StageTimes;
+
+  /// Starts or stops keeping the recorded intervals for write_chrome_trace()
+  void set_tracing(bool enabled);
+
+  /**
+   * \brief Writes the traced intervals as Chrome trace event JSON
+   *
+   * The file opens in chrome://tracing and in Perfetto, with one track per
+   * recording thread. Returns false on I/O errors.
+   */
+  [[nodiscard]] auto write_chrome_trace(std::string_view path) const -> bool;
+
+private:
+  struct TraceEvent {
+    PipelineStage stage = PipelineStage::vertex;
+    std::uint32_t frame = 0;
+    std::uint32_t thread = 0;
+    Clock::time_point begin;
+    Clock::duration duration{};
+  };
+
+  mutable std::mutex mutex_;
+  StageTimes stage_times_{};
+  std::uint32_t frame_ = 0;
+  bool tracing_ = false;
+  Clock::time_point origin_ = Clock::now();
+  std::vector<TraceEvent> events_;
+  std::vector<std::thread::id> threads_;
+};
+
+/// Records the lifetime of the timer as an interval of `stage`
+class ScopedTimer {
+public:
+  ScopedTimer(Profiler& profiler, PipelineStage stage) noexcept
+      : profiler_{profiler}, stage_{stage}, begin_{Profiler::Clock::now()}
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    profiler_.record(stage_, begin_, Profiler::Clock::now());
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  auto operator=(const ScopedTimer&) & -> ScopedTimer& = delete;
+  ScopedTimer(ScopedTimer&&) noexcept = delete;
+  auto operator=(ScopedTimer&&) & noexcept -> ScopedTimer& = delete;
+
+private:
+  Profiler& profiler_;
+  PipelineStage stage_;
+  Profiler::Clock::time_point begin_;
+};
+
+} // namespace yasr
+
+#endif // YASR_PROFILER_HPP
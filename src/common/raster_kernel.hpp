@@ -0,0 +1,408 @@
+#ifndef YASR_RASTER_KERNEL_HPP
+#define YASR_RASTER_KERNEL_HPP
+
+// Building blocks shared by the scalar and SIMD raster kernels.
+//
+// The SIMD kernels are compiled with per-function target attributes rather
+// than per-file ISA flags, so the out-of-line copies of these inline helpers
+// (and of anything they instantiate from the standard library) never contain
+// instructions the running CPU may not support.
+
+#include "rasterizer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <span>
+
+#include <beyond/utils/assert.hpp>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define YASR_TARGET(isa) __attribute__((target(isa)))
+#else
+#define YASR_TARGET(isa)
+#endif
+
+namespace yasr::detail {
+
+/// A triangle clipped against one tile
+struct SpanSetup {
+  Rect rect;
+
+  /// The barycentric weights of a row are interpolated from this x, the left
+  /// of the triangle's bounds, so the result of a pixel does not depend on how
+  /// the triangle is split into tiles and blocks
+  int anchor_x = 0;
+
+  /// Change of the barycentric weights of vertex 1 and 2 per pixel in x
+  float l1_dx = 0;
+  float l2_dx = 0;
+};
+
+/// Edge values and barycentric weights at (anchor_x, y)
+struct RowStart {
+  std::int64_t w0 = 0;
+  std::int64_t w1 = 0;
+  std::int64_t w2 = 0;
+  float l1 = 0;
+  float l2 = 0;
+};
+
+[[nodiscard]] inline auto make_span_setup(const TriangleSetup& setup,
+                                          const Rect& tile) -> SpanSetup
+{
+  return SpanSetup{
+      .rect = intersect(setup.bounds, tile),
+      .anchor_x = setup.bounds.min.x,
+      .l1_dx = static_cast<float>(setup.edges[1].step_x) * setup.inv_area,
+      .l2_dx = static_cast<float>(setup.edges[2].step_x) * setup.inv_area,
+  };
+}
+
+[[nodiscard]] inline auto row_start(const TriangleSetup& setup,
+                                    const SpanSetup& span, int y) -> RowStart
+{
+  const int x = span.anchor_x;
+  const auto& [e0, e1, e2] = setup.edges;
+  const auto w1 = e1.at(x, y);
+  const auto w2 = e2.at(x, y);
+  return RowStart{
+      .w0 = e0.at(x, y),
+      .w1 = w1,
+      .w2 = w2,
+      .l1 = static_cast<float>(w1) * setup.inv_area,
+      .l2 = static_cast<float>(w2) * setup.inv_area,
+  };
+}
+
+/**
+ * \brief Level of detail of a texture lookup at a pixel
+ *
+ * Uses the analytic screen-space derivatives of the perspective-correct
+ * (u, v), which follow from the gradients of u/w, v/w and 1/w.
+ */
+[[nodiscard]] inline auto texture_lod(const TriangleSetup& setup,
+                                      const MipLevel& level, float u, float v,
+                                      float w) -> float
+{
+  const float width = static_cast<float>(level.width);
+  const float height = static_cast<float>(level.height);
+  const float du_dx = (setup.uv_w_dx.x - u * setup.inv_w_dx) * w * width;
+  const float dv_dx = (setup.uv_w_dx.y - v * setup.inv_w_dx) * w * height;
+  const float du_dy = (setup.uv_w_dy.x - u * setup.inv_w_dy) * w * width;
+  const float dv_dy = (setup.uv_w_dy.y - v * setup.inv_w_dy) * w * height;
+  const float footprint_squared = std::max(du_dx * du_dx + dv_dx * dv_dx,
+                                           du_dy * du_dy + dv_dy * dv_dy);
+  return 0.5f * std::log2(footprint_squared);
+}
+
+/// Textures and lights a fragment that passed the depth test, the target
+/// encodes the linear result
+[[nodiscard]] inline auto shade_fragment(const TriangleSetup& setup,
+                                         const TextureView& diffuse_texture,
+                                         float u, float v, float w) -> RGB
+{
+  const float lod = diffuse_texture.filter == TextureFilter::nearest
+                        ? 0.f
+                        : texture_lod(setup, diffuse_texture.levels[0], u, v, w);
+  const RGB texel = sample(diffuse_texture, u, v, lod);
+  const RGB& color = setup.color;
+  return RGB{color.r * texel.r, color.g * texel.g, color.b * texel.b};
+}
+
+/**
+ * \brief Rasterizes the pixels [x_begin, x_end) of row y one at a time
+ *
+ * The SIMD kernels use it for the columns that do not fill a whole vector, so
+ * it evaluates the attributes with exactly the same operations as they do.
+ */
+inline auto rasterize_span_scalar(const TriangleSetup& setup,
+                                  const SpanSetup& span, const RowStart& row,
+                                  int y, int x_begin, int x_end,
+                                  std::vector<float>& depth_buffer,
+                                  const ColorTarget& target,
+                                  const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  const auto& [e0, e1, e2] = setup.edges;
+  const int offset = x_begin - span.anchor_x;
+  std::int64_t w0 = row.w0 + e0.step_x * offset;
+  std::int64_t w1 = row.w1 + e1.step_x * offset;
+  std::int64_t w2 = row.w2 + e2.step_x * offset;
+  FragmentCounts counts;
+
+  for (int x = x_begin; x < x_end; ++x) {
+    if ((w0 | w1 | w2) >= 0) {
+      ++counts.tested;
+      const float dx = static_cast<float>(x - span.anchor_x);
+      const float l1 = row.l1 + dx * span.l1_dx;
+      const float l2 = row.l2 + dx * span.l2_dx;
+
+      float& depth = depth_buffer[y * target.width + x];
+      const float z = setup.z0 + l1 * setup.dz1 + l2 * setup.dz2;
+      if (depth < z) {
+        depth = z;
+        ++counts.passed;
+        const float w =
+            1.f / (setup.inv_w0 + l1 * setup.dinv_w1 + l2 * setup.dinv_w2);
+        const float u =
+            (setup.uv_w0.x + l1 * setup.duv_w1.x + l2 * setup.duv_w2.x) * w;
+        const float v =
+            (setup.uv_w0.y + l1 * setup.duv_w1.y + l2 * setup.duv_w2.y) * w;
+        target.store(x, y, shade_fragment(setup, diffuse_texture, u, v, w));
+      }
+    }
+
+    w0 += e0.step_x;
+    w1 += e1.step_x;
+    w2 += e2.step_x;
+  }
+  return counts;
+}
+
+/// Interpolated attributes of one group of lanes, written to memory so the
+/// lanes that passed the depth test can be shaded one by one
+template <int lanes> struct alignas(32) GroupAttributes {
+  float z[lanes];
+  float u[lanes];
+  float v[lanes];
+  float w[lanes];
+};
+
+/// Writes depth and shades the lanes of `mask`, starting at pixel (x, y)
+template <int lanes>
+void shade_group(const TriangleSetup& setup,
+                 const GroupAttributes<lanes>& attributes, unsigned mask,
+                 int y, int x, std::vector<float>& depth_buffer,
+                 const ColorTarget& target, const TextureView& diffuse_texture)
+{
+  float* depth = depth_buffer.data() + y * target.width + x;
+  while (mask != 0) {
+    const int lane = std::countr_zero(mask);
+    mask &= mask - 1;
+    depth[lane] = attributes.z[lane];
+    target.store(x + lane, y,
+                 shade_fragment(setup, diffuse_texture, attributes.u[lane],
+                                attributes.v[lane], attributes.w[lane]));
+  }
+}
+
+/// The first x of the SIMD groups, aligned to `lanes` relative to the tile
+[[nodiscard]] constexpr auto aligned_group_begin(const SpanSetup& span,
+                                                 const Rect& tile,
+                                                 int lanes) noexcept -> int
+{
+  return tile.min.x + (span.rect.min.x - tile.min.x) / lanes * lanes;
+}
+
+/// One past the last x at which a group of `lanes` pixels still lies entirely
+/// inside the tile, groups never touch pixels of other tiles. The groups can
+/// reach past the span, see span_lanes().
+[[nodiscard]] constexpr auto aligned_group_end(const SpanSetup& span,
+                                               const Rect& tile, int lanes,
+                                               int group_begin) noexcept -> int
+{
+  const int limit = std::min(tile.max.x, span.rect.max.x + lanes - 1);
+  return group_begin + std::max(limit - group_begin, 0) / lanes * lanes;
+}
+
+/**
+ * \brief The lanes of the group starting at `x` whose pixels lie in the span
+ *
+ * Groups are aligned to the tile, so the first and last ones of a row can
+ * reach past the span. The span is clamped to the viewport and the scissor,
+ * and the triangle can cover the pixels past it.
+ */
+[[nodiscard]] constexpr auto span_lanes(const SpanSetup& span, int x,
+                                        int lanes) noexcept -> unsigned
+{
+  const int first = std::clamp(span.rect.min.x - x, 0, lanes);
+  const int last = std::clamp(span.rect.max.x - x, first, lanes);
+  return ((1u << last) - 1u) & ~((1u << first) - 1u);
+}
+
+/// Stores `color` into the samples of `mask` of a pixel, compressing the
+/// pixel if they are all of them
+inline void store_samples(const SampleTarget& target, std::size_t pixel,
+                          unsigned mask, const RGB& color)
+{
+  constexpr unsigned all_samples = (1u << msaa_sample_count) - 1;
+  RGB* const samples = target.color + pixel * msaa_sample_count;
+  if (mask == all_samples) {
+    samples[0] = color;
+    target.uniform[pixel] = 1;
+    return;
+  }
+  if (target.uniform[pixel] != 0) {
+    std::fill(samples + 1, samples + msaa_sample_count, samples[0]);
+    target.uniform[pixel] = 0;
+    *target.tile_split = 1;
+  }
+  while (mask != 0) {
+    samples[std::countr_zero(mask)] = color;
+    mask &= mask - 1;
+  }
+}
+
+/**
+ * \brief Rasterizes the pixels of `run` into a multisampled target
+ *
+ * A pixel whose samples pass the depth test is shaded once with
+ * `shade(l1, l2) -> RGB`, given the barycentric weights of vertex 1 and 2 at
+ * its centre, or at its first covered sample if the centre lies outside the
+ * triangle. It is instantiated for every shading, which can then be inlined.
+ */
+template <typename Shade>
+auto rasterize_run_multisampled(const TriangleSetup& setup, const Rect& run,
+                                const SampleSteps& steps,
+                                const SampleTarget& target, const Shade& shade)
+    -> FragmentCounts
+{
+  const SpanSetup span = make_span_setup(setup, run);
+  const auto& [e0, e1, e2] = setup.edges;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const RowStart row = row_start(setup, span, y);
+    const int offset = span.rect.min.x - span.anchor_x;
+    std::int64_t w0 = row.w0 + e0.step_x * offset;
+    std::int64_t w1 = row.w1 + e1.step_x * offset;
+    std::int64_t w2 = row.w2 + e2.step_x * offset;
+
+    for (int x = span.rect.min.x; x < span.rect.max.x; ++x) {
+      unsigned covered = 0;
+      for (std::size_t s = 0; s < msaa_sample_count; ++s) {
+        if (((w0 + steps.edges[0][s]) | (w1 + steps.edges[1][s]) |
+             (w2 + steps.edges[2][s])) >= 0) {
+          covered |= 1u << s;
+        }
+      }
+
+      if (covered != 0) {
+        ++counts.tested;
+        const float dx = static_cast<float>(x - span.anchor_x);
+        const float l1 = row.l1 + dx * span.l1_dx;
+        const float l2 = row.l2 + dx * span.l2_dx;
+
+        const auto pixel = static_cast<std::size_t>(y * target.width + x);
+        float* const depth = target.depth + pixel * msaa_sample_count;
+        unsigned passed = 0;
+        for (unsigned mask = covered; mask != 0; mask &= mask - 1) {
+          const auto s = static_cast<std::size_t>(std::countr_zero(mask));
+          const float z = setup.z0 + (l1 + steps.l1[s]) * setup.dz1 +
+                          (l2 + steps.l2[s]) * setup.dz2;
+          if (depth[s] < z) {
+            depth[s] = z;
+            passed |= 1u << s;
+          }
+        }
+
+        if (passed != 0) {
+          ++counts.passed;
+          const bool centre_covered = (w0 | w1 | w2) >= 0;
+          const auto first =
+              static_cast<std::size_t>(std::countr_zero(covered));
+          const RGB color =
+              centre_covered
+                  ? shade(l1, l2)
+                  : shade(l1 + steps.l1[first], l2 + steps.l2[first]);
+          store_samples(target, pixel, passed, color);
+        }
+      }
+
+      w0 += e0.step_x;
+      w1 += e1.step_x;
+      w2 += e2.step_x;
+    }
+  }
+  return counts;
+}
+
+/**
+ * \brief Shades every pixel of `tile` that holds a triangle of `triangles`
+ * once, and resets it to no_triangle
+ *
+ * A pixel is shaded with `shade(setup, l1, l2) -> RGB`, given the barycentric
+ * weights of vertex 1 and 2 at its centre. They are reconstructed from the
+ * edge functions of the stored triangle with the arithmetic of the raster
+ * kernels, so the pixels get the colors immediate shading would give them.
+ */
+template <typename Shade>
+void shade_visible(std::span<const TriangleSetup* const> triangles,
+                   const Rect& tile, const VisibilityTarget& visibility,
+                   const ColorTarget& target, PipelineStats& stats,
+                   const Shade& shade)
+{
+  for (int y = tile.min.y; y < tile.max.y; ++y) {
+    // Neighbouring pixels mostly share their triangle, whose row start is
+    // then reused
+    std::uint32_t row_triangle = no_triangle;
+    SpanSetup span;
+    RowStart row;
+    for (int x = tile.min.x; x < tile.max.x; ++x) {
+      std::uint32_t& triangle =
+          visibility.triangle[static_cast<std::size_t>(y * visibility.width +
+                                                       x)];
+      if (triangle == no_triangle) { continue; }
+      BEYOND_ASSERT(triangle < triangles.size());
+      const TriangleSetup& setup = *triangles[triangle];
+      if (triangle != row_triangle) {
+        span = make_span_setup(setup, tile);
+        row = row_start(setup, span, y);
+        row_triangle = triangle;
+      }
+      triangle = no_triangle;
+
+      const float dx = static_cast<float>(x - span.anchor_x);
+      const float l1 = row.l1 + dx * span.l1_dx;
+      const float l2 = row.l2 + dx * span.l2_dx;
+      target.store(x, y, shade(setup, l1, l2));
+      ++stats.fragments_shaded;
+    }
+  }
+}
+
+auto rasterize_triangle_scalar(const TriangleSetup& setup, const Rect& tile,
+                               std::vector<float>& depth_buffer,
+                               const ColorTarget& target,
+                               const TextureView& diffuse_texture)
+    -> FragmentCounts;
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) ||            \
+    defined(_M_IX86)
+#define YASR_HAS_X86_KERNELS 1
+auto rasterize_triangle_sse41(const TriangleSetup& setup, const Rect& tile,
+                              std::vector<float>& depth_buffer,
+                              const ColorTarget& target,
+                              const TextureView& diffuse_texture)
+    -> FragmentCounts;
+auto rasterize_triangle_avx2(const TriangleSetup& setup, const Rect& tile,
+                             std::vector<float>& depth_buffer,
+                             const ColorTarget& target,
+                             const TextureView& diffuse_texture)
+    -> FragmentCounts;
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#define YASR_HAS_NEON_KERNEL 1
+auto rasterize_triangle_neon(const TriangleSetup& setup, const Rect& tile,
+                             std::vector<float>& depth_buffer,
+                             const ColorTarget& target,
+                             const TextureView& diffuse_texture)
+    -> FragmentCounts;
+#endif
+
+#if defined(__wasm_simd128__)
+#define YASR_HAS_WASM_SIMD_KERNEL 1
+auto rasterize_triangle_wasm_simd128(const TriangleSetup& setup,
+                                     const Rect& tile,
+                                     std::vector<float>& depth_buffer,
+                                     const ColorTarget& target,
+                                     const TextureView& diffuse_texture)
+    -> FragmentCounts;
+#endif
+
+} // namespace yasr::detail
+
+#endif // YASR_RASTER_KERNEL_HPP
@@ -0,0 +1,149 @@
+#include "raster_kernel.hpp"
+
+#if defined(YASR_HAS_NEON_KERNEL)
+
+#include <arm_neon.h>
+
+namespace yasr::detail {
+
+namespace {
+
+/// Sign bits of the two 64-bit lanes as a 2-bit mask
+[[nodiscard]] inline auto sign_mask(int64x2_t v) -> unsigned
+{
+  const uint64x2_t signs = vshrq_n_u64(vreinterpretq_u64_s64(v), 63);
+  return static_cast<unsigned>(vgetq_lane_u64(signs, 0) |
+                               (vgetq_lane_u64(signs, 1) << 1));
+}
+
+[[nodiscard]] inline auto lane_mask(uint32x4_t v) -> unsigned
+{
+  const uint32x4_t bits{1, 2, 4, 8};
+  return vaddvq_u32(vandq_u32(v, bits));
+}
+
+[[nodiscard]] inline auto make_lanes(std::int64_t first, std::int64_t second)
+    -> int64x2_t
+{
+  const std::int64_t values[2] = {first, second};
+  return vld1q_s64(values);
+}
+
+} // anonymous namespace
+
+auto rasterize_triangle_neon(const TriangleSetup& setup, const Rect& tile,
+                             std::vector<float>& depth_buffer,
+                             const ColorTarget& target,
+                             const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  constexpr int lanes = 4;
+
+  const SpanSetup span = make_span_setup(setup, tile);
+  if (span.rect.empty()) { return {}; }
+
+  const int group_begin = aligned_group_begin(span, tile, lanes);
+  const int group_end = aligned_group_end(span, tile, lanes, group_begin);
+  const int tail_begin = std::max(group_end, span.rect.min.x);
+
+  const auto& [e0, e1, e2] = setup.edges;
+  const int64x2_t step0 = vdupq_n_s64(e0.step_x * lanes);
+  const int64x2_t step1 = vdupq_n_s64(e1.step_x * lanes);
+  const int64x2_t step2 = vdupq_n_s64(e2.step_x * lanes);
+
+  const float32x4_t lane_offsets{0, 1, 2, 3};
+  const float32x4_t l1_dx = vdupq_n_f32(span.l1_dx);
+  const float32x4_t l2_dx = vdupq_n_f32(span.l2_dx);
+  const float32x4_t z0 = vdupq_n_f32(setup.z0);
+  const float32x4_t dz1 = vdupq_n_f32(setup.dz1);
+  const float32x4_t dz2 = vdupq_n_f32(setup.dz2);
+  const float32x4_t inv_w0 = vdupq_n_f32(setup.inv_w0);
+  const float32x4_t dinv_w1 = vdupq_n_f32(setup.dinv_w1);
+  const float32x4_t dinv_w2 = vdupq_n_f32(setup.dinv_w2);
+  const float32x4_t u0 = vdupq_n_f32(setup.uv_w0.x);
+  const float32x4_t du1 = vdupq_n_f32(setup.duv_w1.x);
+  const float32x4_t du2 = vdupq_n_f32(setup.duv_w2.x);
+  const float32x4_t v0 = vdupq_n_f32(setup.uv_w0.y);
+  const float32x4_t dv1 = vdupq_n_f32(setup.duv_w1.y);
+  const float32x4_t dv2 = vdupq_n_f32(setup.duv_w2.y);
+  const float32x4_t one = vdupq_n_f32(1.f);
+
+  GroupAttributes<lanes> attributes;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const RowStart row = row_start(setup, span, y);
+    const float32x4_t row_l1 = vdupq_n_f32(row.l1);
+    const float32x4_t row_l2 = vdupq_n_f32(row.l2);
+
+    // Two 64-bit lanes per register, lanes {0, 1} and {2, 3}
+    const std::int64_t offset = group_begin - span.anchor_x;
+    const std::int64_t w0_begin = row.w0 + e0.step_x * offset;
+    const std::int64_t w1_begin = row.w1 + e1.step_x * offset;
+    const std::int64_t w2_begin = row.w2 + e2.step_x * offset;
+    int64x2_t w0_lo = make_lanes(w0_begin, w0_begin + e0.step_x);
+    int64x2_t w0_hi =
+        make_lanes(w0_begin + 2 * e0.step_x, w0_begin + 3 * e0.step_x);
+    int64x2_t w1_lo = make_lanes(w1_begin, w1_begin + e1.step_x);
+    int64x2_t w1_hi =
+        make_lanes(w1_begin + 2 * e1.step_x, w1_begin + 3 * e1.step_x);
+    int64x2_t w2_lo = make_lanes(w2_begin, w2_begin + e2.step_x);
+    int64x2_t w2_hi =
+        make_lanes(w2_begin + 2 * e2.step_x, w2_begin + 3 * e2.step_x);
+
+    for (int x = group_begin; x < group_end; x += lanes) {
+      const unsigned covered =
+          ~(sign_mask(vorrq_s64(vorrq_s64(w0_lo, w1_lo), w2_lo)) |
+            (sign_mask(vorrq_s64(vorrq_s64(w0_hi, w1_hi), w2_hi)) << 2)) &
+          span_lanes(span, x, lanes);
+
+      w0_lo = vaddq_s64(w0_lo, step0);
+      w0_hi = vaddq_s64(w0_hi, step0);
+      w1_lo = vaddq_s64(w1_lo, step1);
+      w1_hi = vaddq_s64(w1_hi, step1);
+      w2_lo = vaddq_s64(w2_lo, step2);
+      w2_hi = vaddq_s64(w2_hi, step2);
+
+      if (covered == 0) { continue; }
+      counts.tested += static_cast<std::uint32_t>(std::popcount(covered));
+
+      const float32x4_t dx = vaddq_f32(
+          vdupq_n_f32(static_cast<float>(x - span.anchor_x)), lane_offsets);
+      const float32x4_t l1 = vaddq_f32(row_l1, vmulq_f32(dx, l1_dx));
+      const float32x4_t l2 = vaddq_f32(row_l2, vmulq_f32(dx, l2_dx));
+
+      const float32x4_t z =
+          vaddq_f32(vaddq_f32(z0, vmulq_f32(l1, dz1)), vmulq_f32(l2, dz2));
+      const float32x4_t depth =
+          vld1q_f32(depth_buffer.data() + y * target.width + x);
+      const unsigned passed = covered & lane_mask(vcltq_f32(depth, z));
+      if (passed == 0) { continue; }
+
+      const float32x4_t w = vdivq_f32(
+          one, vaddq_f32(vaddq_f32(inv_w0, vmulq_f32(l1, dinv_w1)),
+                         vmulq_f32(l2, dinv_w2)));
+      const float32x4_t u = vmulq_f32(
+          vaddq_f32(vaddq_f32(u0, vmulq_f32(l1, du1)), vmulq_f32(l2, du2)), w);
+      const float32x4_t v = vmulq_f32(
+          vaddq_f32(vaddq_f32(v0, vmulq_f32(l1, dv1)), vmulq_f32(l2, dv2)), w);
+      vst1q_f32(attributes.z, z);
+      vst1q_f32(attributes.u, u);
+      vst1q_f32(attributes.v, v);
+      vst1q_f32(attributes.w, w);
+      counts.passed += static_cast<std::uint32_t>(std::popcount(passed));
+      shade_group(setup, attributes, passed, y, x, depth_buffer, target,
+                  diffuse_texture);
+    }
+
+    if (tail_begin < span.rect.max.x) {
+      counts += rasterize_span_scalar(setup, span, row, y, tail_begin,
+                                      span.rect.max.x, depth_buffer, target,
+                                      diffuse_texture);
+    }
+  }
+  return counts;
+}
+
+} // namespace yasr::detail
+
+#endif // YASR_HAS_NEON_KERNEL
@@ -0,0 +1,129 @@
+#include "raster_kernel.hpp"
+
+#if defined(YASR_HAS_WASM_SIMD_KERNEL)
+
+#include <wasm_simd128.h>
+
+namespace yasr::detail {
+
+auto rasterize_triangle_wasm_simd128(const TriangleSetup& setup,
+                                     const Rect& tile,
+                                     std::vector<float>& depth_buffer,
+                                     const ColorTarget& target,
+                                     const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  constexpr int lanes = 4;
+
+  const SpanSetup span = make_span_setup(setup, tile);
+  if (span.rect.empty()) { return {}; }
+
+  const int group_begin = aligned_group_begin(span, tile, lanes);
+  const int group_end = aligned_group_end(span, tile, lanes, group_begin);
+  const int tail_begin = std::max(group_end, span.rect.min.x);
+
+  const auto& [e0, e1, e2] = setup.edges;
+  const v128_t step0 = wasm_i64x2_splat(e0.step_x * lanes);
+  const v128_t step1 = wasm_i64x2_splat(e1.step_x * lanes);
+  const v128_t step2 = wasm_i64x2_splat(e2.step_x * lanes);
+
+  const v128_t lane_offsets = wasm_f32x4_make(0, 1, 2, 3);
+  const v128_t l1_dx = wasm_f32x4_splat(span.l1_dx);
+  const v128_t l2_dx = wasm_f32x4_splat(span.l2_dx);
+  const v128_t z0 = wasm_f32x4_splat(setup.z0);
+  const v128_t dz1 = wasm_f32x4_splat(setup.dz1);
+  const v128_t dz2 = wasm_f32x4_splat(setup.dz2);
+  const v128_t inv_w0 = wasm_f32x4_splat(setup.inv_w0);
+  const v128_t dinv_w1 = wasm_f32x4_splat(setup.dinv_w1);
+  const v128_t dinv_w2 = wasm_f32x4_splat(setup.dinv_w2);
+  const v128_t u0 = wasm_f32x4_splat(setup.uv_w0.x);
+  const v128_t du1 = wasm_f32x4_splat(setup.duv_w1.x);
+  const v128_t du2 = wasm_f32x4_splat(setup.duv_w2.x);
+  const v128_t v0 = wasm_f32x4_splat(setup.uv_w0.y);
+  const v128_t dv1 = wasm_f32x4_splat(setup.duv_w1.y);
+  const v128_t dv2 = wasm_f32x4_splat(setup.duv_w2.y);
+  const v128_t one = wasm_f32x4_splat(1.f);
+
+  GroupAttributes<lanes> attributes;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const RowStart row = row_start(setup, span, y);
+    const v128_t row_l1 = wasm_f32x4_splat(row.l1);
+    const v128_t row_l2 = wasm_f32x4_splat(row.l2);
+
+    // Two 64-bit lanes per register, lanes {0, 1} and {2, 3}
+    const std::int64_t offset = group_begin - span.anchor_x;
+    const std::int64_t w0_begin = row.w0 + e0.step_x * offset;
+    const std::int64_t w1_begin = row.w1 + e1.step_x * offset;
+    const std::int64_t w2_begin = row.w2 + e2.step_x * offset;
+    v128_t w0_lo = wasm_i64x2_make(w0_begin, w0_begin + e0.step_x);
+    v128_t w0_hi =
+        wasm_i64x2_make(w0_begin + 2 * e0.step_x, w0_begin + 3 * e0.step_x);
+    v128_t w1_lo = wasm_i64x2_make(w1_begin, w1_begin + e1.step_x);
+    v128_t w1_hi =
+        wasm_i64x2_make(w1_begin + 2 * e1.step_x, w1_begin + 3 * e1.step_x);
+    v128_t w2_lo = wasm_i64x2_make(w2_begin, w2_begin + e2.step_x);
+    v128_t w2_hi =
+        wasm_i64x2_make(w2_begin + 2 * e2.step_x, w2_begin + 3 * e2.step_x);
+
+    for (int x = group_begin; x < group_end; x += lanes) {
+      const unsigned covered =
+          ~(wasm_i64x2_bitmask(wasm_v128_or(wasm_v128_or(w0_lo, w1_lo), w2_lo)) |
+            (wasm_i64x2_bitmask(
+                 wasm_v128_or(wasm_v128_or(w0_hi, w1_hi), w2_hi))
+             << 2)) &
+          span_lanes(span, x, lanes);
+
+      w0_lo = wasm_i64x2_add(w0_lo, step0);
+      w0_hi = wasm_i64x2_add(w0_hi, step0);
+      w1_lo = wasm_i64x2_add(w1_lo, step1);
+      w1_hi = wasm_i64x2_add(w1_hi, step1);
+      w2_lo = wasm_i64x2_add(w2_lo, step2);
+      w2_hi = wasm_i64x2_add(w2_hi, step2);
+
+      if (covered == 0) { continue; }
+      counts.tested += static_cast<std::uint32_t>(std::popcount(covered));
+
+      const v128_t dx = wasm_f32x4_add(
+          wasm_f32x4_splat(static_cast<float>(x - span.anchor_x)),
+          lane_offsets);
+      const v128_t l1 = wasm_f32x4_add(row_l1, wasm_f32x4_mul(dx, l1_dx));
+      const v128_t l2 = wasm_f32x4_add(row_l2, wasm_f32x4_mul(dx, l2_dx));
+
+      const v128_t z =
+          wasm_f32x4_add(wasm_f32x4_add(z0, wasm_f32x4_mul(l1, dz1)), wasm_f32x4_mul(l2, dz2));
+      const v128_t depth =
+          wasm_v128_load(depth_buffer.data() + y * target.width + x);
+      const unsigned passed =
+          covered & wasm_i32x4_bitmask(wasm_f32x4_lt(depth, z));
+      if (passed == 0) { continue; }
+
+      const v128_t w = wasm_f32x4_div(
+          one, wasm_f32x4_add(wasm_f32x4_add(inv_w0, wasm_f32x4_mul(l1, dinv_w1)),
+                         wasm_f32x4_mul(l2, dinv_w2)));
+      const v128_t u = wasm_f32x4_mul(
+          wasm_f32x4_add(wasm_f32x4_add(u0, wasm_f32x4_mul(l1, du1)), wasm_f32x4_mul(l2, du2)), w);
+      const v128_t v = wasm_f32x4_mul(
+          wasm_f32x4_add(wasm_f32x4_add(v0, wasm_f32x4_mul(l1, dv1)), wasm_f32x4_mul(l2, dv2)), w);
+      wasm_v128_store(attributes.z, z);
+      wasm_v128_store(attributes.u, u);
+      wasm_v128_store(attributes.v, v);
+      wasm_v128_store(attributes.w, w);
+      counts.passed += static_cast<std::uint32_t>(std::popcount(passed));
+      shade_group(setup, attributes, passed, y, x, depth_buffer, target,
+                  diffuse_texture);
+    }
+
+    if (tail_begin < span.rect.max.x) {
+      counts += rasterize_span_scalar(setup, span, row, y, tail_begin,
+                                      span.rect.max.x, depth_buffer, target,
+                                      diffuse_texture);
+    }
+  }
+  return counts;
+}
+
+} // namespace yasr::detail
+
+#endif // YASR_HAS_WASM_SIMD_KERNEL
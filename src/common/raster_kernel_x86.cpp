@@ -0,0 +1,266 @@
+#include "raster_kernel.hpp"
+
+#if defined(YASR_HAS_X86_KERNELS)
+
+#include <immintrin.h>
+
+namespace yasr::detail {
+
+YASR_TARGET("sse4.1")
+auto rasterize_triangle_sse41(const TriangleSetup& setup, const Rect& tile,
+                              std::vector<float>& depth_buffer,
+                              const ColorTarget& target,
+                              const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  constexpr int lanes = 4;
+
+  const SpanSetup span = make_span_setup(setup, tile);
+  if (span.rect.empty()) { return {}; }
+
+  const int group_begin = aligned_group_begin(span, tile, lanes);
+  const int group_end = aligned_group_end(span, tile, lanes, group_begin);
+  const int tail_begin = std::max(group_end, span.rect.min.x);
+
+  const auto& [e0, e1, e2] = setup.edges;
+  const __m128i step0 = _mm_set1_epi64x(e0.step_x * lanes);
+  const __m128i step1 = _mm_set1_epi64x(e1.step_x * lanes);
+  const __m128i step2 = _mm_set1_epi64x(e2.step_x * lanes);
+
+  const __m128 lane_offsets = _mm_setr_ps(0, 1, 2, 3);
+  const __m128 l1_dx = _mm_set1_ps(span.l1_dx);
+  const __m128 l2_dx = _mm_set1_ps(span.l2_dx);
+  const __m128 z0 = _mm_set1_ps(setup.z0);
+  const __m128 dz1 = _mm_set1_ps(setup.dz1);
+  const __m128 dz2 = _mm_set1_ps(setup.dz2);
+  const __m128 inv_w0 = _mm_set1_ps(setup.inv_w0);
+  const __m128 dinv_w1 = _mm_set1_ps(setup.dinv_w1);
+  const __m128 dinv_w2 = _mm_set1_ps(setup.dinv_w2);
+  const __m128 u0 = _mm_set1_ps(setup.uv_w0.x);
+  const __m128 du1 = _mm_set1_ps(setup.duv_w1.x);
+  const __m128 du2 = _mm_set1_ps(setup.duv_w2.x);
+  const __m128 v0 = _mm_set1_ps(setup.uv_w0.y);
+  const __m128 dv1 = _mm_set1_ps(setup.duv_w1.y);
+  const __m128 dv2 = _mm_set1_ps(setup.duv_w2.y);
+  const __m128 one = _mm_set1_ps(1.f);
+
+  GroupAttributes<lanes> attributes;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const RowStart row = row_start(setup, span, y);
+    const __m128 row_l1 = _mm_set1_ps(row.l1);
+    const __m128 row_l2 = _mm_set1_ps(row.l2);
+
+    // Two 64-bit lanes per register, lanes {0, 1} and {2, 3}
+    const std::int64_t offset = group_begin - span.anchor_x;
+    const std::int64_t w0_begin = row.w0 + e0.step_x * offset;
+    const std::int64_t w1_begin = row.w1 + e1.step_x * offset;
+    const std::int64_t w2_begin = row.w2 + e2.step_x * offset;
+    __m128i w0_lo = _mm_set_epi64x(w0_begin + e0.step_x, w0_begin);
+    __m128i w0_hi = _mm_set_epi64x(w0_begin + 3 * e0.step_x,
+                                   w0_begin + 2 * e0.step_x);
+    __m128i w1_lo = _mm_set_epi64x(w1_begin + e1.step_x, w1_begin);
+    __m128i w1_hi = _mm_set_epi64x(w1_begin + 3 * e1.step_x,
+                                   w1_begin + 2 * e1.step_x);
+    __m128i w2_lo = _mm_set_epi64x(w2_begin + e2.step_x, w2_begin);
+    __m128i w2_hi = _mm_set_epi64x(w2_begin + 3 * e2.step_x,
+                                   w2_begin + 2 * e2.step_x);
+
+    for (int x = group_begin; x < group_end; x += lanes) {
+      // A lane is covered when no edge value has its sign bit set
+      const __m128i outside_lo = _mm_or_si128(_mm_or_si128(w0_lo, w1_lo), w2_lo);
+      const __m128i outside_hi = _mm_or_si128(_mm_or_si128(w0_hi, w1_hi), w2_hi);
+      const unsigned covered =
+          ~static_cast<unsigned>(
+              _mm_movemask_pd(_mm_castsi128_pd(outside_lo)) |
+              (_mm_movemask_pd(_mm_castsi128_pd(outside_hi)) << 2)) &
+          span_lanes(span, x, lanes);
+
+      w0_lo = _mm_add_epi64(w0_lo, step0);
+      w0_hi = _mm_add_epi64(w0_hi, step0);
+      w1_lo = _mm_add_epi64(w1_lo, step1);
+      w1_hi = _mm_add_epi64(w1_hi, step1);
+      w2_lo = _mm_add_epi64(w2_lo, step2);
+      w2_hi = _mm_add_epi64(w2_hi, step2);
+
+      if (covered == 0) { continue; }
+      counts.tested += static_cast<std::uint32_t>(std::popcount(covered));
+
+      const __m128 dx = _mm_add_ps(
+          _mm_set1_ps(static_cast<float>(x - span.anchor_x)), lane_offsets);
+      const __m128 l1 = _mm_add_ps(row_l1, _mm_mul_ps(dx, l1_dx));
+      const __m128 l2 = _mm_add_ps(row_l2, _mm_mul_ps(dx, l2_dx));
+
+      const __m128 z = _mm_add_ps(_mm_add_ps(z0, _mm_mul_ps(l1, dz1)),
+                                  _mm_mul_ps(l2, dz2));
+      const __m128 depth =
+          _mm_loadu_ps(depth_buffer.data() + y * target.width + x);
+      const unsigned passed =
+          covered &
+          static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(depth, z)));
+      if (passed == 0) { continue; }
+
+      const __m128 w = _mm_div_ps(
+          one, _mm_add_ps(_mm_add_ps(inv_w0, _mm_mul_ps(l1, dinv_w1)),
+                          _mm_mul_ps(l2, dinv_w2)));
+      const __m128 u = _mm_mul_ps(
+          _mm_add_ps(_mm_add_ps(u0, _mm_mul_ps(l1, du1)), _mm_mul_ps(l2, du2)),
+          w);
+      const __m128 v = _mm_mul_ps(
+          _mm_add_ps(_mm_add_ps(v0, _mm_mul_ps(l1, dv1)), _mm_mul_ps(l2, dv2)),
+          w);
+      _mm_store_ps(attributes.z, z);
+      _mm_store_ps(attributes.u, u);
+      _mm_store_ps(attributes.v, v);
+      _mm_store_ps(attributes.w, w);
+      counts.passed += static_cast<std::uint32_t>(std::popcount(passed));
+      shade_group(setup, attributes, passed, y, x, depth_buffer, target,
+                  diffuse_texture);
+    }
+
+    if (tail_begin < span.rect.max.x) {
+      counts += rasterize_span_scalar(setup, span, row, y, tail_begin,
+                                      span.rect.max.x, depth_buffer, target,
+                                      diffuse_texture);
+    }
+  }
+  return counts;
+}
+
+YASR_TARGET("avx2")
+auto rasterize_triangle_avx2(const TriangleSetup& setup, const Rect& tile,
+                             std::vector<float>& depth_buffer,
+                             const ColorTarget& target,
+                             const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  constexpr int lanes = 8;
+
+  const SpanSetup span = make_span_setup(setup, tile);
+  if (span.rect.empty()) { return {}; }
+
+  const int group_begin = aligned_group_begin(span, tile, lanes);
+  const int group_end = aligned_group_end(span, tile, lanes, group_begin);
+  const int tail_begin = std::max(group_end, span.rect.min.x);
+
+  const auto& [e0, e1, e2] = setup.edges;
+  const __m256i step0 = _mm256_set1_epi64x(e0.step_x * lanes);
+  const __m256i step1 = _mm256_set1_epi64x(e1.step_x * lanes);
+  const __m256i step2 = _mm256_set1_epi64x(e2.step_x * lanes);
+  const __m256i half_step0 = _mm256_set1_epi64x(e0.step_x * lanes / 2);
+  const __m256i half_step1 = _mm256_set1_epi64x(e1.step_x * lanes / 2);
+  const __m256i half_step2 = _mm256_set1_epi64x(e2.step_x * lanes / 2);
+
+  const __m256 lane_offsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256 l1_dx = _mm256_set1_ps(span.l1_dx);
+  const __m256 l2_dx = _mm256_set1_ps(span.l2_dx);
+  const __m256 z0 = _mm256_set1_ps(setup.z0);
+  const __m256 dz1 = _mm256_set1_ps(setup.dz1);
+  const __m256 dz2 = _mm256_set1_ps(setup.dz2);
+  const __m256 inv_w0 = _mm256_set1_ps(setup.inv_w0);
+  const __m256 dinv_w1 = _mm256_set1_ps(setup.dinv_w1);
+  const __m256 dinv_w2 = _mm256_set1_ps(setup.dinv_w2);
+  const __m256 u0 = _mm256_set1_ps(setup.uv_w0.x);
+  const __m256 du1 = _mm256_set1_ps(setup.duv_w1.x);
+  const __m256 du2 = _mm256_set1_ps(setup.duv_w2.x);
+  const __m256 v0 = _mm256_set1_ps(setup.uv_w0.y);
+  const __m256 dv1 = _mm256_set1_ps(setup.duv_w1.y);
+  const __m256 dv2 = _mm256_set1_ps(setup.duv_w2.y);
+  const __m256 one = _mm256_set1_ps(1.f);
+
+  GroupAttributes<lanes> attributes;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const RowStart row = row_start(setup, span, y);
+    const __m256 row_l1 = _mm256_set1_ps(row.l1);
+    const __m256 row_l2 = _mm256_set1_ps(row.l2);
+
+    const std::int64_t offset = group_begin - span.anchor_x;
+    const std::int64_t w0_begin = row.w0 + e0.step_x * offset;
+    const std::int64_t w1_begin = row.w1 + e1.step_x * offset;
+    const std::int64_t w2_begin = row.w2 + e2.step_x * offset;
+
+    // Four 64-bit lanes per register, lanes {0, ..., 3} and {4, ..., 7}
+    __m256i w0_lo = _mm256_setr_epi64x(w0_begin, w0_begin + e0.step_x,
+                                       w0_begin + 2 * e0.step_x,
+                                       w0_begin + 3 * e0.step_x);
+    __m256i w1_lo = _mm256_setr_epi64x(w1_begin, w1_begin + e1.step_x,
+                                       w1_begin + 2 * e1.step_x,
+                                       w1_begin + 3 * e1.step_x);
+    __m256i w2_lo = _mm256_setr_epi64x(w2_begin, w2_begin + e2.step_x,
+                                       w2_begin + 2 * e2.step_x,
+                                       w2_begin + 3 * e2.step_x);
+    __m256i w0_hi = _mm256_add_epi64(w0_lo, half_step0);
+    __m256i w1_hi = _mm256_add_epi64(w1_lo, half_step1);
+    __m256i w2_hi = _mm256_add_epi64(w2_lo, half_step2);
+
+    for (int x = group_begin; x < group_end; x += lanes) {
+      const __m256i outside_lo =
+          _mm256_or_si256(_mm256_or_si256(w0_lo, w1_lo), w2_lo);
+      const __m256i outside_hi =
+          _mm256_or_si256(_mm256_or_si256(w0_hi, w1_hi), w2_hi);
+      const unsigned covered =
+          ~static_cast<unsigned>(
+              _mm256_movemask_pd(_mm256_castsi256_pd(outside_lo)) |
+              (_mm256_movemask_pd(_mm256_castsi256_pd(outside_hi)) << 4)) &
+          span_lanes(span, x, lanes);
+
+      w0_lo = _mm256_add_epi64(w0_lo, step0);
+      w0_hi = _mm256_add_epi64(w0_hi, step0);
+      w1_lo = _mm256_add_epi64(w1_lo, step1);
+      w1_hi = _mm256_add_epi64(w1_hi, step1);
+      w2_lo = _mm256_add_epi64(w2_lo, step2);
+      w2_hi = _mm256_add_epi64(w2_hi, step2);
+
+      if (covered == 0) { continue; }
+      counts.tested += static_cast<std::uint32_t>(std::popcount(covered));
+
+      const __m256 dx = _mm256_add_ps(
+          _mm256_set1_ps(static_cast<float>(x - span.anchor_x)),
+          lane_offsets);
+      const __m256 l1 = _mm256_add_ps(row_l1, _mm256_mul_ps(dx, l1_dx));
+      const __m256 l2 = _mm256_add_ps(row_l2, _mm256_mul_ps(dx, l2_dx));
+
+      const __m256 z = _mm256_add_ps(
+          _mm256_add_ps(z0, _mm256_mul_ps(l1, dz1)), _mm256_mul_ps(l2, dz2));
+      const __m256 depth =
+          _mm256_loadu_ps(depth_buffer.data() + y * target.width + x);
+      const unsigned passed =
+          covered & static_cast<unsigned>(_mm256_movemask_ps(
+                        _mm256_cmp_ps(depth, z, _CMP_LT_OQ)));
+      if (passed == 0) { continue; }
+
+      const __m256 w = _mm256_div_ps(
+          one, _mm256_add_ps(_mm256_add_ps(inv_w0, _mm256_mul_ps(l1, dinv_w1)),
+                             _mm256_mul_ps(l2, dinv_w2)));
+      const __m256 u = _mm256_mul_ps(
+          _mm256_add_ps(_mm256_add_ps(u0, _mm256_mul_ps(l1, du1)),
+                        _mm256_mul_ps(l2, du2)),
+          w);
+      const __m256 v = _mm256_mul_ps(
+          _mm256_add_ps(_mm256_add_ps(v0, _mm256_mul_ps(l1, dv1)),
+                        _mm256_mul_ps(l2, dv2)),
+          w);
+      _mm256_store_ps(attributes.z, z);
+      _mm256_store_ps(attributes.u, u);
+      _mm256_store_ps(attributes.v, v);
+      _mm256_store_ps(attributes.w, w);
+      counts.passed += static_cast<std::uint32_t>(std::popcount(passed));
+      shade_group(setup, attributes, passed, y, x, depth_buffer, target,
+                  diffuse_texture);
+    }
+
+    if (tail_begin < span.rect.max.x) {
+      counts += rasterize_span_scalar(setup, span, row, y, tail_begin,
+                                      span.rect.max.x, depth_buffer, target,
+                                      diffuse_texture);
+    }
+  }
+  return counts;
+}
+
+} // namespace yasr::detail
+
+#endif // YASR_HAS_X86_KERNELS
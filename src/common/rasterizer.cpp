@@ -0,0 +1,836 @@
+#include "rasterizer.hpp"
+#include "clipping.hpp"
+#include "raster_kernel.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <beyond/utils/assert.hpp>
+
+#if defined(_MSC_VER) && defined(YASR_HAS_X86_KERNELS)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+
+namespace yasr {
+
+namespace {
+
+struct FixedPoint2 {
+  std::int64_t x = 0;
+  std::int64_t y = 0;
+};
+
+[[nodiscard]] auto snap(const beyond::Point3& pos) -> FixedPoint2
+{
+  return {std::llround(pos.x * static_cast<float>(subpixel_one)),
+          std::llround(pos.y * static_cast<float>(subpixel_one))};
+}
+
+/// Twice the signed area of the triangle (a, b, p), positive when p lies on the
+/// inner side of the edge a -> b for our winding in y-down screen space
+[[nodiscard]] constexpr auto orient2d(FixedPoint2 a, FixedPoint2 b,
+                                      FixedPoint2 p) noexcept -> std::int64_t
+{
+  return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+}
+
+// With y pointing down, the interior lies below a top edge and to the right
+// of a left edge
+[[nodiscard]] constexpr auto is_top_left(FixedPoint2 a, FixedPoint2 b) noexcept
+    -> bool
+{
+  const auto dx = b.x - a.x;
+  const auto dy = b.y - a.y;
+  return dy < 0 || (dy == 0 && dx > 0);
+}
+
+[[nodiscard]] constexpr auto make_edge(FixedPoint2 a, FixedPoint2 b) noexcept
+    -> EdgeFunction
+{
+  constexpr std::int64_t half = subpixel_one / 2;
+
+  const std::int64_t a_coeff = a.y - b.y;
+  const std::int64_t b_coeff = b.x - a.x;
+  const std::int64_t bias = is_top_left(a, b) ? 0 : -1;
+
+  return EdgeFunction{
+      .step_x = a_coeff * subpixel_one,
+      .step_y = b_coeff * subpixel_one,
+      .c = a_coeff * (half - a.x) + b_coeff * (half - a.y) + bias,
+  };
+}
+
+[[nodiscard]] auto is_representable(const beyond::Point3& pos) -> bool
+{
+  return std::abs(pos.x) < max_screen_coordinate &&
+         std::abs(pos.y) < max_screen_coordinate;
+}
+
+/**
+ * \brief Upper bound of the depth a raster kernel computes for the covered
+ * pixels of rectangles inside `span`, including its rounding error
+ *
+ * The depth is affine, so over a rectangle it peaks at a corner pixel. The
+ * kernels interpolate the barycentric weights in float from the left of the
+ * triangle's bounds, so their error grows with the size of the weights between
+ * there and the span, which also peaks at corners.
+ */
+class NearestDepthBound {
+public:
+  /// `margin` is how far, in pixels, the tested depth may lie from the pixel
+  /// centres
+  NearestDepthBound(const TriangleSetup& setup, const Rect& span,
+                    double margin = 0) noexcept
+      : origin_{span.min}, max_z_{setup.max_z}
+  {
+    const auto weights = [&](int x, int y) {
+      return std::pair{
+          static_cast<double>(setup.edges[1].at(x, y)) * setup.inv_area,
+          static_cast<double>(setup.edges[2].at(x, y)) * setup.inv_area};
+    };
+
+    const auto [l1, l2] = weights(span.min.x, span.min.y);
+    z_ = setup.z0 + l1 * setup.dz1 + l2 * setup.dz2;
+    z_dx_ = (static_cast<double>(setup.edges[1].step_x) * setup.dz1 +
+             static_cast<double>(setup.edges[2].step_x) * setup.dz2) *
+            setup.inv_area;
+    z_dy_ = (static_cast<double>(setup.edges[1].step_y) * setup.dz1 +
+             static_cast<double>(setup.edges[2].step_y) * setup.dz2) *
+            setup.inv_area;
+
+    double l1_max = 1;
+    double l2_max = 1;
+    for (const int y : {span.min.y, span.max.y - 1}) {
+      for (const int x : {setup.bounds.min.x, span.min.x, span.max.x - 1}) {
+        const auto [corner_l1, corner_l2] = weights(x, y);
+        l1_max = std::max(l1_max, std::abs(corner_l1));
+        l2_max = std::max(l2_max, std::abs(corner_l2));
+      }
+    }
+    error_ = 16.0 * std::numeric_limits<float>::epsilon() *
+             (std::abs(setup.z0) + l1_max * std::abs(setup.dz1) +
+              l2_max * std::abs(setup.dz2));
+    margin_ = margin * (std::abs(z_dx_) + std::abs(z_dy_));
+  }
+
+  [[nodiscard]] auto operator()(const Rect& rect) const noexcept -> double
+  {
+    const double at_min = z_ + z_dx_ * (rect.min.x - origin_.x) +
+                          z_dy_ * (rect.min.y - origin_.y);
+    const double plane_max =
+        at_min + std::max(z_dx_, 0.0) * (rect.max.x - 1 - rect.min.x) +
+        std::max(z_dy_, 0.0) * (rect.max.y - 1 - rect.min.y) + margin_;
+    return std::min(plane_max, static_cast<double>(max_z_)) + error_;
+  }
+
+private:
+  beyond::IVec2 origin_;
+  double z_ = 0;
+  double z_dx_ = 0;
+  double z_dy_ = 0;
+  double error_ = 0;
+  double margin_ = 0;
+  float max_z_ = 0;
+};
+
+[[nodiscard]] auto farthest_depth(const std::vector<float>& depth_buffer,
+                                  int width, const Rect& block) noexcept
+    -> float
+{
+  // Column-wise minimum first, which vectorizes without reassociation
+  std::array<float, hiz_block_size> columns;
+  columns.fill(std::numeric_limits<float>::infinity());
+  const int block_width = block.max.x - block.min.x;
+  for (int y = block.min.y; y < block.max.y; ++y) {
+    const float* row = depth_buffer.data() + y * width + block.min.x;
+    for (int x = 0; x < block_width; ++x) {
+      columns[static_cast<std::size_t>(x)] =
+          std::min(columns[static_cast<std::size_t>(x)], row[x]);
+    }
+  }
+  return *std::ranges::min_element(columns);
+}
+
+[[nodiscard]] auto farthest_sample_depth(const float* depth, int width,
+                                         const Rect& block) noexcept -> float
+{
+  float farthest = std::numeric_limits<float>::infinity();
+  const int row_samples = (block.max.x - block.min.x) * msaa_sample_count;
+  for (int y = block.min.y; y < block.max.y; ++y) {
+    const float* row = depth + (y * width + block.min.x) * msaa_sample_count;
+    for (int i = 0; i < row_samples; ++i) {
+      farthest = std::min(farthest, row[i]);
+    }
+  }
+  return farthest;
+}
+
+[[nodiscard]] constexpr auto pixel_count(const Rect& rect) noexcept
+    -> std::uint64_t
+{
+  return static_cast<std::uint64_t>(rect.max.x - rect.min.x) *
+         static_cast<std::uint64_t>(rect.max.y - rect.min.y);
+}
+
+/// Texels read by one sample, counting both levels of a trilinear sample
+[[nodiscard]] constexpr auto texels_per_sample(
+    const TextureView& texture) noexcept -> std::uint64_t
+{
+  switch (texture.filter) {
+  case TextureFilter::nearest:
+    return 1;
+  case TextureFilter::bilinear:
+    return 4;
+  case TextureFilter::trilinear:
+    return 8;
+  }
+  return 0;
+}
+
+} // anonymous namespace
+
+auto setup_triangle(std::array<ScreenVertex, 3> vertices, const Rect& scissor,
+                    const RGB& color, CullMode cull)
+    -> std::optional<TriangleSetup>
+{
+  // Also rejects NaNs, which the clipper keeps out of the pipeline but callers
+  // of setup_triangle() may still pass
+  if (!std::ranges::all_of(vertices, [](const ScreenVertex& v) {
+        return is_representable(v.pos);
+      })) {
+    return std::nullopt;
+  }
+
+  std::array<FixedPoint2, 3> p{snap(vertices[0].pos), snap(vertices[1].pos),
+                               snap(vertices[2].pos)};
+
+  // Flipping y to point down turns counter-clockwise in normalized device
+  // coordinates into a negative area
+  std::int64_t area = orient2d(p[0], p[1], p[2]);
+  if (area == 0) { return std::nullopt; }
+  const bool front_facing = area < 0;
+  if ((cull == CullMode::front && front_facing) ||
+      (cull == CullMode::back && !front_facing)) {
+    return std::nullopt;
+  }
+  const bool swapped = area < 0;
+  if (swapped) {
+    std::swap(p[1], p[2]);
+    std::swap(vertices[1], vertices[2]);
+    area = -area;
+  }
+
+  const auto floor_to_pixel = [](std::int64_t v) {
+    return static_cast<int>(v >> subpixel_bits);
+  };
+  const auto ceil_to_pixel = [](std::int64_t v) {
+    return static_cast<int>((v + subpixel_one - 1) >> subpixel_bits);
+  };
+
+  const auto [min_x, max_x] = std::minmax({p[0].x, p[1].x, p[2].x});
+  const auto [min_y, max_y] = std::minmax({p[0].y, p[1].y, p[2].y});
+  const Rect bounds{
+      {std::max(floor_to_pixel(min_x), scissor.min.x),
+       std::max(floor_to_pixel(min_y), scissor.min.y)},
+      {std::min(ceil_to_pixel(max_x), scissor.max.x),
+       std::min(ceil_to_pixel(max_y), scissor.max.y)}};
+  if (bounds.empty()) { return std::nullopt; }
+
+  TriangleSetup setup{
+      .edges = {make_edge(p[1], p[2]), make_edge(p[2], p[0]),
+                make_edge(p[0], p[1])},
+      .bounds = bounds,
+      .inv_area = 1.f / static_cast<float>(area),
+      .color = color,
+      .swapped = swapped,
+  };
+
+  const auto& v = vertices;
+  setup.z0 = v[0].pos.z;
+  setup.dz1 = v[1].pos.z - v[0].pos.z;
+  setup.dz2 = v[2].pos.z - v[0].pos.z;
+  setup.max_z = std::max({v[0].pos.z, v[1].pos.z, v[2].pos.z});
+
+  setup.inv_w0 = v[0].inv_w;
+  setup.dinv_w1 = v[1].inv_w - v[0].inv_w;
+  setup.dinv_w2 = v[2].inv_w - v[0].inv_w;
+
+  const auto uv_w = [](const ScreenVertex& vertex) {
+    return beyond::Vec2{vertex.uv.x * vertex.inv_w, vertex.uv.y * vertex.inv_w};
+  };
+  setup.uv_w0 = uv_w(v[0]);
+  setup.duv_w1 = uv_w(v[1]) - setup.uv_w0;
+  setup.duv_w2 = uv_w(v[2]) - setup.uv_w0;
+
+  const float l1_dx = static_cast<float>(setup.edges[1].step_x) * setup.inv_area;
+  const float l1_dy = static_cast<float>(setup.edges[1].step_y) * setup.inv_area;
+  const float l2_dx = static_cast<float>(setup.edges[2].step_x) * setup.inv_area;
+  const float l2_dy = static_cast<float>(setup.edges[2].step_y) * setup.inv_area;
+  setup.inv_w_dx = l1_dx * setup.dinv_w1 + l2_dx * setup.dinv_w2;
+  setup.inv_w_dy = l1_dy * setup.dinv_w1 + l2_dy * setup.dinv_w2;
+  setup.uv_w_dx = setup.duv_w1 * l1_dx + setup.duv_w2 * l2_dx;
+  setup.uv_w_dy = setup.duv_w1 * l1_dy + setup.duv_w2 * l2_dy;
+
+  return setup;
+}
+
+namespace detail {
+
+auto rasterize_triangle_scalar(const TriangleSetup& setup, const Rect& tile,
+                               std::vector<float>& depth_buffer,
+                               const ColorTarget& target,
+                               const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  const SpanSetup span = make_span_setup(setup, tile);
+  if (span.rect.empty()) { return {}; }
+
+  FragmentCounts counts;
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    counts += rasterize_span_scalar(setup, span, row_start(setup, span, y), y,
+                                    span.rect.min.x, span.rect.max.x,
+                                    depth_buffer, target, diffuse_texture);
+  }
+  return counts;
+}
+
+} // namespace detail
+
+auto detect_simd_level() noexcept -> SimdLevel
+{
+#if defined(YASR_HAS_X86_KERNELS)
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) { return SimdLevel::avx2; }
+  if (__builtin_cpu_supports("sse4.1")) { return SimdLevel::sse41; }
+#elif defined(_MSC_VER)
+  std::array<int, 4> info{};
+  __cpuid(info.data(), 1);
+  const bool sse41 = (info[2] & (1 << 19)) != 0;
+  const bool os_saves_ymm = (info[2] & (1 << 27)) != 0 &&
+                            (info[2] & (1 << 28)) != 0 &&
+                            (_xgetbv(0) & 0x6) == 0x6;
+  __cpuidex(info.data(), 7, 0);
+  const bool avx2 = os_saves_ymm && (info[1] & (1 << 5)) != 0;
+  if (avx2) { return SimdLevel::avx2; }
+  if (sse41) { return SimdLevel::sse41; }
+#endif
+  return SimdLevel::scalar;
+#elif defined(YASR_HAS_NEON_KERNEL)
+  return SimdLevel::neon;
+#elif defined(YASR_HAS_WASM_SIMD_KERNEL)
+  return SimdLevel::wasm_simd128;
+#else
+  return SimdLevel::scalar;
+#endif
+}
+
+auto raster_kernel(SimdLevel level) noexcept -> RasterKernel
+{
+  switch (level) {
+  case SimdLevel::scalar:
+    return detail::rasterize_triangle_scalar;
+#if defined(YASR_HAS_X86_KERNELS)
+  case SimdLevel::sse41:
+    return detail::rasterize_triangle_sse41;
+  case SimdLevel::avx2:
+    return detail::rasterize_triangle_avx2;
+#endif
+#if defined(YASR_HAS_NEON_KERNEL)
+  case SimdLevel::neon:
+    return detail::rasterize_triangle_neon;
+#endif
+#if defined(YASR_HAS_WASM_SIMD_KERNEL)
+  case SimdLevel::wasm_simd128:
+    return detail::rasterize_triangle_wasm_simd128;
+#endif
+  default:
+    return nullptr;
+  }
+}
+
+namespace {
+
+/**
+ * \brief Hierarchical depth culling of the part of a triangle inside `tile`
+ *
+ * Calls rasterize_run(run) -> FragmentCounts on the runs of whole blocks that
+ * may be visible, and refreshes the farthest depth of the blocks a run wrote
+ * to with farthest(block). `margin` is how far, in pixels, the tested depth
+ * lies from the pixel centres.
+ */
+template <typename RasterizeRun, typename FarthestDepth>
+void rasterize_visible_blocks(const TriangleSetup& setup, const Rect& tile,
+                              int width, int height,
+                              std::vector<float>& coarse_depth, double margin,
+                              RasterizeRun rasterize_run,
+                              FarthestDepth farthest, PipelineStats& stats)
+{
+  BEYOND_ASSERT(tile.min.x % hiz_block_size == 0 &&
+                tile.min.y % hiz_block_size == 0);
+
+  const Rect span = intersect(setup.bounds, tile);
+  if (span.empty()) { return; }
+
+  const int stride = hiz_block_count(width);
+  const Rect blocks{{span.min.x / hiz_block_size, span.min.y / hiz_block_size},
+                    {hiz_block_count(span.max.x), hiz_block_count(span.max.y)}};
+  const auto coarse_at = [&](int block_x, int block_y) -> float& {
+    return coarse_depth[static_cast<std::size_t>(block_y * stride + block_x)];
+  };
+
+  // Reject the whole triangle against the farthest depth under its bounds
+  const NearestDepthBound nearest_depth{setup, span, margin};
+  float region_farthest = std::numeric_limits<float>::infinity();
+  for (int block_y = blocks.min.y; block_y < blocks.max.y; ++block_y) {
+    for (int block_x = blocks.min.x; block_x < blocks.max.x; ++block_x) {
+      region_farthest = std::min(region_farthest, coarse_at(block_x, block_y));
+    }
+  }
+  if (nearest_depth(span) <= region_farthest) {
+    ++stats.hiz_triangles_culled;
+    stats.hiz_pixels_culled += pixel_count(span);
+    return;
+  }
+
+  const auto block_rect = [&](int block_x, int block_y) {
+    return Rect{{block_x * hiz_block_size, block_y * hiz_block_size},
+                {std::min((block_x + 1) * hiz_block_size, width),
+                 std::min((block_y + 1) * hiz_block_size, height)}};
+  };
+
+  constexpr int blocks_per_tile = tile_size / hiz_block_size;
+  for (int block_y = blocks.min.y; block_y < blocks.max.y; ++block_y) {
+    std::array<bool, blocks_per_tile> visible{};
+    for (int block_x = blocks.min.x; block_x < blocks.max.x; ++block_x) {
+      const float block_farthest = coarse_at(block_x, block_y);
+      const Rect covered = intersect(span, block_rect(block_x, block_y));
+      const bool culled =
+          block_farthest != -std::numeric_limits<float>::infinity() &&
+          nearest_depth(covered) <= block_farthest;
+      visible[static_cast<std::size_t>(block_x - blocks.min.x)] = !culled;
+      if (culled) {
+        ++stats.hiz_blocks_culled;
+        stats.hiz_pixels_culled += pixel_count(covered);
+      }
+    }
+
+    // Runs of adjacent visible blocks are rasterized with one kernel call
+    for (int block_x = blocks.min.x; block_x < blocks.max.x;) {
+      if (!visible[static_cast<std::size_t>(block_x - blocks.min.x)]) {
+        ++block_x;
+        continue;
+      }
+      const int run_begin = block_x;
+      while (block_x < blocks.max.x &&
+             visible[static_cast<std::size_t>(block_x - blocks.min.x)]) {
+        ++block_x;
+      }
+
+      const Rect run{block_rect(run_begin, block_y).min,
+                     block_rect(block_x - 1, block_y).max};
+      const FragmentCounts counts = rasterize_run(run);
+      stats.fragments_tested += counts.tested;
+      stats.fragments_passed += counts.passed;
+      if (counts.passed == 0) { continue; }
+      for (int x = run_begin; x < block_x; ++x) {
+        coarse_at(x, block_y) = farthest(block_rect(x, block_y));
+      }
+    }
+  }
+}
+
+auto rasterize_run_g_buffer(const TriangleSetup& setup, const Rect& run,
+                            std::vector<float>& depth_buffer,
+                            const GBufferTarget& target,
+                            const TextureView& diffuse_texture)
+    -> FragmentCounts
+{
+  const detail::SpanSetup span = detail::make_span_setup(setup, run);
+  const auto& [e0, e1, e2] = setup.edges;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const detail::RowStart row = detail::row_start(setup, span, y);
+    const int offset = span.rect.min.x - span.anchor_x;
+    std::int64_t w0 = row.w0 + e0.step_x * offset;
+    std::int64_t w1 = row.w1 + e1.step_x * offset;
+    std::int64_t w2 = row.w2 + e2.step_x * offset;
+
+    for (int x = span.rect.min.x; x < span.rect.max.x; ++x) {
+      if ((w0 | w1 | w2) >= 0) {
+        ++counts.tested;
+        const float dx = static_cast<float>(x - span.anchor_x);
+        const float l1 = row.l1 + dx * span.l1_dx;
+        const float l2 = row.l2 + dx * span.l2_dx;
+
+        const auto pixel = static_cast<std::size_t>(y * target.width + x);
+        const float z = setup.z0 + l1 * setup.dz1 + l2 * setup.dz2;
+        if (depth_buffer[pixel] < z) {
+          depth_buffer[pixel] = z;
+          ++counts.passed;
+          const float w =
+              1.f / (setup.inv_w0 + l1 * setup.dinv_w1 + l2 * setup.dinv_w2);
+          const float u =
+              (setup.uv_w0.x + l1 * setup.duv_w1.x + l2 * setup.duv_w2.x) * w;
+          const float v =
+              (setup.uv_w0.y + l1 * setup.duv_w1.y + l2 * setup.duv_w2.y) * w;
+          target.albedo[pixel] = encode_rgba8(
+              ColorFormat::rgba8_srgb,
+              detail::shade_fragment(setup, diffuse_texture, u, v, w));
+          target.normal[pixel] = setup.normal;
+        }
+      }
+
+      w0 += e0.step_x;
+      w1 += e1.step_x;
+      w2 += e2.step_x;
+    }
+  }
+  return counts;
+}
+
+auto rasterize_run_visibility(const TriangleSetup& setup,
+                              std::uint32_t triangle, const Rect& run,
+                              std::vector<float>& depth_buffer,
+                              const VisibilityTarget& visibility)
+    -> FragmentCounts
+{
+  const detail::SpanSetup span = detail::make_span_setup(setup, run);
+  const auto& [e0, e1, e2] = setup.edges;
+  FragmentCounts counts;
+
+  for (int y = span.rect.min.y; y < span.rect.max.y; ++y) {
+    const detail::RowStart row = detail::row_start(setup, span, y);
+    const int offset = span.rect.min.x - span.anchor_x;
+    std::int64_t w0 = row.w0 + e0.step_x * offset;
+    std::int64_t w1 = row.w1 + e1.step_x * offset;
+    std::int64_t w2 = row.w2 + e2.step_x * offset;
+
+    for (int x = span.rect.min.x; x < span.rect.max.x; ++x) {
+      if ((w0 | w1 | w2) >= 0) {
+        ++counts.tested;
+        const float dx = static_cast<float>(x - span.anchor_x);
+        const float l1 = row.l1 + dx * span.l1_dx;
+        const float l2 = row.l2 + dx * span.l2_dx;
+
+        const auto pixel = static_cast<std::size_t>(y * visibility.width + x);
+        const float z = setup.z0 + l1 * setup.dz1 + l2 * setup.dz2;
+        if (depth_buffer[pixel] < z) {
+          depth_buffer[pixel] = z;
+          visibility.triangle[pixel] = triangle;
+          ++counts.passed;
+        }
+      }
+
+      w0 += e0.step_x;
+      w1 += e1.step_x;
+      w2 += e2.step_x;
+    }
+  }
+  return counts;
+}
+
+/// The built-in textured shading of a pixel, given the barycentric weights of
+/// vertex 1 and 2 at the point it is shaded at
+auto shade_textured_pixel(const TextureView& diffuse_texture,
+                          const TriangleSetup& setup, float l1, float l2)
+    -> RGB
+{
+  const float w =
+      1.f / (setup.inv_w0 + l1 * setup.dinv_w1 + l2 * setup.dinv_w2);
+  const float u =
+      (setup.uv_w0.x + l1 * setup.duv_w1.x + l2 * setup.duv_w2.x) * w;
+  const float v =
+      (setup.uv_w0.y + l1 * setup.duv_w1.y + l2 * setup.duv_w2.y) * w;
+  return detail::shade_fragment(setup, diffuse_texture, u, v, w);
+}
+
+/// Depth tests and writes a pixel of a line or point
+void plot_line_pixel(int x, int y, float z,
+                     const std::vector<float>& depth_buffer,
+                     const ColorTarget& target, const RGB& color,
+                     bool depth_test, PipelineStats& stats)
+{
+  ++stats.fragments_tested;
+  const auto pixel = static_cast<std::size_t>(y * target.width + x);
+  if (depth_test && depth_buffer[pixel] > z + line_depth_bias) { return; }
+  ++stats.fragments_passed;
+  ++stats.fragments_shaded;
+  target.store(x, y, color);
+}
+
+/// `v` as a 16-bit signed normalized value
+[[nodiscard]] auto encode_snorm16(float v) noexcept -> std::uint32_t
+{
+  const auto snorm = static_cast<std::int16_t>(
+      std::lround(std::clamp(v, -1.f, 1.f) * 32767.f));
+  return static_cast<std::uint16_t>(snorm);
+}
+
+[[nodiscard]] auto decode_snorm16(std::uint32_t bits) noexcept -> float
+{
+  const auto snorm = static_cast<std::int16_t>(bits & 0xFFFF);
+  return std::max(static_cast<float>(snorm) / 32767.f, -1.f);
+}
+
+[[nodiscard]] auto sign_not_zero(float v) noexcept -> float
+{
+  return v >= 0 ? 1.f : -1.f;
+}
+
+} // anonymous namespace
+
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const ColorTarget& target,
+                        RunRasterizer rasterize_run, const void* context,
+                        PipelineStats& stats)
+{
+  rasterize_visible_blocks(
+      setup, tile, target.width, target.height, coarse_depth, 0,
+      [&](const Rect& run) {
+        return rasterize_run(context, setup, run, depth_buffer, target);
+      },
+      [&](const Rect& block) {
+        return farthest_depth(depth_buffer, target.width, block);
+      },
+      stats);
+}
+
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const ColorTarget& target,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats)
+{
+  static const RasterKernel kernel = raster_kernel(detect_simd_level());
+
+  const std::uint64_t passed_before = stats.fragments_passed;
+  rasterize_triangle(
+      setup, tile, depth_buffer, coarse_depth, target,
+      [](const void* context, const TriangleSetup& triangle, const Rect& run,
+         std::vector<float>& depth, const ColorTarget& color) {
+        return kernel(triangle, run, depth, color,
+                      *static_cast<const TextureView*>(context));
+      },
+      &diffuse_texture, stats);
+  stats.texels_fetched += (stats.fragments_passed - passed_before) *
+                          texels_per_sample(diffuse_texture);
+}
+
+SampleSteps::SampleSteps(const TriangleSetup& setup) noexcept
+{
+  constexpr int grid = 16;
+  static_assert(subpixel_one % grid == 0);
+  const auto weight_step = [&](std::int64_t edge_step) {
+    return static_cast<float>(edge_step) * setup.inv_area;
+  };
+  const float l1_dx = weight_step(setup.edges[1].step_x);
+  const float l1_dy = weight_step(setup.edges[1].step_y);
+  const float l2_dx = weight_step(setup.edges[2].step_x);
+  const float l2_dy = weight_step(setup.edges[2].step_y);
+  for (std::size_t s = 0; s < msaa_sample_count; ++s) {
+    const auto [x, y] = msaa_sample_offsets[s];
+    // The steps are whole multiples of subpixel_one, so this is exact
+    for (std::size_t e = 0; e < 3; ++e) {
+      edges[e][s] =
+          (setup.edges[e].step_x * x + setup.edges[e].step_y * y) / grid;
+    }
+    const float fx = static_cast<float>(x) / grid;
+    const float fy = static_cast<float>(y) / grid;
+    l1[s] = fx * l1_dx + fy * l1_dy;
+    l2[s] = fx * l2_dx + fy * l2_dy;
+  }
+}
+
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        const SampleTarget& target,
+                        std::vector<float>& coarse_depth,
+                        MultisampledRunRasterizer rasterize_run,
+                        const void* context, PipelineStats& stats)
+{
+  const SampleSteps steps{setup};
+  // Samples lie less than half a pixel away from the centre in x and y
+  rasterize_visible_blocks(
+      setup, tile, target.width, target.height, coarse_depth, 0.5,
+      [&](const Rect& run) {
+        return rasterize_run(context, setup, run, steps, target);
+      },
+      [&](const Rect& block) {
+        return farthest_sample_depth(target.depth, target.width, block);
+      },
+      stats);
+}
+
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        const SampleTarget& target,
+                        std::vector<float>& coarse_depth,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats)
+{
+  const std::uint64_t passed_before = stats.fragments_passed;
+  rasterize_triangle(
+      setup, tile, target, coarse_depth,
+      [](const void* context, const TriangleSetup& triangle, const Rect& run,
+         const SampleSteps& steps, const SampleTarget& samples) {
+        const auto& texture = *static_cast<const TextureView*>(context);
+        return detail::rasterize_run_multisampled(
+            triangle, run, steps, samples, [&](float l1, float l2) {
+              return shade_textured_pixel(texture, triangle, l1, l2);
+            });
+      },
+      &diffuse_texture, stats);
+  stats.texels_fetched += (stats.fragments_passed - passed_before) *
+                          texels_per_sample(diffuse_texture);
+}
+
+void rasterize_triangle(const TriangleSetup& setup, std::uint32_t triangle,
+                        const Rect& tile, std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const VisibilityTarget& visibility,
+                        PipelineStats& stats)
+{
+  rasterize_visible_blocks(
+      setup, tile, visibility.width, visibility.height, coarse_depth, 0,
+      [&](const Rect& run) {
+        return rasterize_run_visibility(setup, triangle, run, depth_buffer,
+                                        visibility);
+      },
+      [&](const Rect& block) {
+        return farthest_depth(depth_buffer, visibility.width, block);
+      },
+      stats);
+}
+
+void shade_visible(std::span<const TriangleSetup* const> triangles,
+                   const Rect& tile, const VisibilityTarget& visibility,
+                   const ColorTarget& target,
+                   const TextureView& diffuse_texture, PipelineStats& stats)
+{
+  const std::uint64_t shaded_before = stats.fragments_shaded;
+  detail::shade_visible(triangles, tile, visibility, target, stats,
+                        [&](const TriangleSetup& setup, float l1, float l2) {
+                          return shade_textured_pixel(diffuse_texture, setup,
+                                                      l1, l2);
+                        });
+  stats.texels_fetched += (stats.fragments_shaded - shaded_before) *
+                          texels_per_sample(diffuse_texture);
+}
+
+void rasterize_line(beyond::Point3 from, beyond::Point3 to,
+                    const Rect& scissor, const std::vector<float>& depth_buffer,
+                    const ColorTarget& target, const RGB& color,
+                    bool depth_test, PipelineStats& stats)
+{
+  if (!clip_line(from, to, scissor)) { return; }
+
+  // An end on a max edge of the scissor belongs to the last pixel inside
+  const auto to_pixel = [](float v, int min, int max) {
+    return std::clamp(static_cast<int>(std::floor(v)), min, max - 1);
+  };
+  int x = to_pixel(from.x, scissor.min.x, scissor.max.x);
+  int y = to_pixel(from.y, scissor.min.y, scissor.max.y);
+  const int x_end = to_pixel(to.x, scissor.min.x, scissor.max.x);
+  const int y_end = to_pixel(to.y, scissor.min.y, scissor.max.y);
+
+  const int dx = std::abs(x_end - x);
+  const int dy = -std::abs(y_end - y);
+  const int step_x = x < x_end ? 1 : -1;
+  const int step_y = y < y_end ? 1 : -1;
+  const int steps = std::max(dx, -dy);
+  const float dz = steps > 0 ? (to.z - from.z) / static_cast<float>(steps) : 0;
+
+  int error = dx + dy;
+  for (int i = 0;; ++i) {
+    plot_line_pixel(x, y, from.z + dz * static_cast<float>(i), depth_buffer,
+                    target, color, depth_test, stats);
+    if (i == steps) { break; }
+    const int error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x += step_x;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y += step_y;
+    }
+  }
+  BEYOND_ASSERT(x == x_end && y == y_end);
+}
+
+void rasterize_point(const beyond::Point3& point, const Rect& scissor,
+                     const std::vector<float>& depth_buffer,
+                     const ColorTarget& target, const RGB& color,
+                     bool depth_test, PipelineStats& stats)
+{
+  // Also rejects NaNs
+  const bool inside = point.x >= static_cast<float>(scissor.min.x) &&
+                      point.x < static_cast<float>(scissor.max.x) &&
+                      point.y >= static_cast<float>(scissor.min.y) &&
+                      point.y < static_cast<float>(scissor.max.y);
+  if (!inside) { return; }
+  plot_line_pixel(static_cast<int>(point.x), static_cast<int>(point.y),
+                  point.z, depth_buffer, target, color, depth_test, stats);
+}
+
+auto pack_normal(const beyond::Vec3& normal) noexcept -> std::uint32_t
+{
+  // Projected onto the octahedron |x| + |y| + |z| = 1, whose lower half is
+  // folded over the diagonals onto the square of the upper half
+  const float norm = std::abs(normal.x) + std::abs(normal.y) +
+                     std::abs(normal.z);
+  if (!(norm > 0)) { return 0; }
+  float x = normal.x / norm;
+  float y = normal.y / norm;
+  if (normal.z < 0) {
+    const float folded_x = (1 - std::abs(y)) * sign_not_zero(x);
+    y = (1 - std::abs(x)) * sign_not_zero(y);
+    x = folded_x;
+  }
+  return encode_snorm16(x) | encode_snorm16(y) << 16;
+}
+
+auto unpack_normal(std::uint32_t packed) noexcept -> beyond::Vec3
+{
+  float x = decode_snorm16(packed);
+  float y = decode_snorm16(packed >> 16);
+  const float z = 1 - std::abs(x) - std::abs(y);
+  if (z < 0) {
+    const float unfolded_x = (1 - std::abs(y)) * sign_not_zero(x);
+    y = (1 - std::abs(x)) * sign_not_zero(y);
+    x = unfolded_x;
+  }
+  return beyond::normalize(beyond::Vec3{x, y, z});
+}
+
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const GBufferTarget& target,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats)
+{
+  const std::uint64_t passed_before = stats.fragments_passed;
+  rasterize_visible_blocks(
+      setup, tile, target.width, target.height, coarse_depth, 0,
+      [&](const Rect& run) {
+        return rasterize_run_g_buffer(setup, run, depth_buffer, target,
+                                      diffuse_texture);
+      },
+      [&](const Rect& block) {
+        return farthest_depth(depth_buffer, target.width, block);
+      },
+      stats);
+  stats.texels_fetched += (stats.fragments_passed - passed_before) *
+                          texels_per_sample(diffuse_texture);
+}
+
+} // namespace yasr
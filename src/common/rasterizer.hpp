@@ -0,0 +1,366 @@
+#ifndef YASR_RASTERIZER_HPP
+#define YASR_RASTERIZER_HPP
+
+#include "color_target.hpp"
+#include "texture.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <beyond/math/point.hpp>
+#include <beyond/math/vector.hpp>
+
+namespace yasr {
+
+/// Number of fractional bits of the fixed-point screen coordinates
+constexpr int subpixel_bits = 8;
+constexpr std::int64_t subpixel_one = std::int64_t{1} << subpixel_bits;
+
+/// Vertices further than this many pixels away from the origin are rejected
+/// before snapping, which keeps every edge function inside 64 bits
+constexpr float max_screen_coordinate = 1 << 20;
+
+constexpr int tile_size = 64;
+
+/// Side of the square pixel blocks of the hierarchical depth buffer, tiles are
+/// made of whole blocks
+constexpr int hiz_block_size = 8;
+static_assert(tile_size % hiz_block_size == 0);
+
+/// Number of hierarchical depth blocks needed to cover `pixels` pixels
+[[nodiscard]] constexpr auto hiz_block_count(int pixels) noexcept -> int
+{
+  return (pixels + hiz_block_size - 1) / hiz_block_size;
+}
+
+/// A screen-space rectangle [min, max) in pixels
+struct Rect {
+  beyond::IVec2 min;
+  beyond::IVec2 max;
+
+  [[nodiscard]] constexpr auto empty() const noexcept -> bool
+  {
+    return min.x >= max.x || min.y >= max.y;
+  }
+};
+
+[[nodiscard]] constexpr auto intersect(const Rect& lhs,
+                                      const Rect& rhs) noexcept -> Rect
+{
+  return Rect{{std::max(lhs.min.x, rhs.min.x), std::max(lhs.min.y, rhs.min.y)},
+              {std::min(lhs.max.x, rhs.max.x), std::min(lhs.max.y, rhs.max.y)}};
+}
+
+/// A vertex after the perspective divide and viewport transform
+struct ScreenVertex {
+  beyond::Point3 pos;
+  float inv_w = 1;
+  beyond::Vec2 uv;
+};
+
+/**
+ * \brief Edge function E(x, y) = step_x * x + step_y * y + c in fixed-point
+ *
+ * E is evaluated at pixel centres, includes the top-left fill rule bias and is
+ * non-negative exactly for the pixels covered by the edge's half-plane.
+ */
+struct EdgeFunction {
+  std::int64_t step_x = 0;
+  std::int64_t step_y = 0;
+  std::int64_t c = 0;
+
+  [[nodiscard]] constexpr auto at(int x, int y) const noexcept -> std::int64_t
+  {
+    return step_x * x + step_y * y + c;
+  }
+};
+
+/**
+ * \brief Per-triangle state computed once and shared by every tile
+ *
+ * `edges[i]` is the edge opposite to vertex i, so its value divided by the
+ * triangle's area is the barycentric weight of vertex i. Attributes are stored
+ * relative to vertex 0 and weighted by the barycentric of vertex 1 and 2.
+ */
+struct TriangleSetup {
+  std::array<EdgeFunction, 3> edges;
+  Rect bounds;
+  float inv_area = 0;
+
+  // Screen-space depth, which is already affine after the perspective divide
+  float z0 = 0, dz1 = 0, dz2 = 0;
+  /// Depth of the nearest vertex
+  float max_z = 0;
+
+  // 1/w, u/w and v/w for perspective-correct interpolation
+  float inv_w0 = 0, dinv_w1 = 0, dinv_w2 = 0;
+  beyond::Vec2 uv_w0{}, duv_w1{}, duv_w2{};
+
+  // Screen-space gradients of 1/w and (u/w, v/w), for texture derivatives
+  float inv_w_dx = 0, inv_w_dy = 0;
+  beyond::Vec2 uv_w_dx{}, uv_w_dy{};
+
+  RGB color;
+  /// View-space face normal by pack_normal(), for the G-buffer
+  std::uint32_t normal = 0;
+
+  /// Set when vertices 1 and 2 were swapped to make the area positive, so
+  /// attributes kept outside of the setup must be swapped as well
+  bool swapped = false;
+  /// Attributes of a programmable pipeline, owned and read by the pipeline
+  const void* varyings = nullptr;
+};
+
+/**
+ * \brief Snaps a triangle to the sub-pixel grid and builds its edge equations
+ *
+ * The winding is taken from the signed area of the snapped vertices, so the
+ * cull test agrees with what would be rasterized.
+ * \return std::nullopt for degenerate triangles, triangles culled by `cull`
+ * and triangles that cover no pixel of `scissor`
+ */
+[[nodiscard]] auto setup_triangle(std::array<ScreenVertex, 3> vertices,
+                                  const Rect& scissor, const RGB& color,
+                                  CullMode cull = CullMode::none)
+    -> std::optional<TriangleSetup>;
+
+enum class SimdLevel { scalar, sse41, avx2, neon, wasm_simd128 };
+
+/// The widest instruction set supported by both the build and the running CPU
+[[nodiscard]] auto detect_simd_level() noexcept -> SimdLevel;
+
+/// Fragments counted by a raster kernel
+struct FragmentCounts {
+  /// Covered pixels that reached the depth test
+  std::uint32_t tested = 0;
+  /// Fragments that passed the depth test and were shaded
+  std::uint32_t passed = 0;
+
+  constexpr auto operator+=(FragmentCounts other) noexcept -> FragmentCounts&
+  {
+    tested += other.tested;
+    passed += other.passed;
+    return *this;
+  }
+};
+
+using RasterKernel = auto (*)(const TriangleSetup& setup, const Rect& tile,
+                              std::vector<float>& depth_buffer,
+                              const ColorTarget& target,
+                              const TextureView& diffuse_texture)
+    -> FragmentCounts;
+
+/// Returns the raster kernel for `level`, or nullptr if it is not built in
+[[nodiscard]] auto raster_kernel(SimdLevel level) noexcept -> RasterKernel;
+
+/// Rasterizes and shades the pixels of `run`, a row of whole hierarchical
+/// depth blocks of one tile. `context` is passed through from the caller.
+using RunRasterizer = auto (*)(const void* context, const TriangleSetup& setup,
+                               const Rect& run,
+                               std::vector<float>& depth_buffer,
+                               const ColorTarget& target)
+    -> FragmentCounts;
+
+/**
+ * \brief Rasterizes the part of a triangle that lies inside `tile` with
+ * `rasterize_run`
+ *
+ * The triangle is rasterized one hierarchical depth block at a time.
+ * `coarse_depth` holds the farthest depth of every block of `depth_buffer`,
+ * hiz_block_count(target.width) blocks per row. The triangle, or the blocks
+ * of it, that lie entirely behind the stored depth are skipped, and the
+ * farthest depth of every rasterized block is updated. The culled work and
+ * the fragments are added to `stats`.
+ */
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const ColorTarget& target,
+                        RunRasterizer rasterize_run, const void* context,
+                        PipelineStats& stats);
+
+/**
+ * \brief Rasterizes the part of a triangle inside `tile` with the built-in
+ * textured shading
+ *
+ * Dispatches to the kernel of detect_simd_level(), all kernels produce
+ * bit-identical results. Also counts the texel fetches in `stats`.
+ */
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const ColorTarget& target,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats);
+
+/// Samples per pixel of a multisampled framebuffer
+constexpr int msaa_sample_count = 4;
+
+/// A sample position relative to the pixel centre, in 1/16 pixel
+struct SampleOffset {
+  int x = 0;
+  int y = 0;
+};
+
+/// The rotated grid of the standard 4x pattern, which gives near-horizontal
+/// and near-vertical edges four distinct coverage steps
+constexpr std::array<SampleOffset, msaa_sample_count> msaa_sample_offsets{
+    {{-2, -6}, {6, -2}, {-6, 2}, {2, 6}}};
+
+/**
+ * \brief Per-sample attachments of a multisampled framebuffer, as seen by the
+ * rasterization of one tile
+ *
+ * Sample s of pixel (x, y) lies at (y * width + x) * msaa_sample_count + s.
+ * Pixels whose `uniform` flag is set are compressed: their first sample holds
+ * the color of every sample.
+ */
+struct SampleTarget {
+  int width = 0;
+  int height = 0;
+  float* depth = nullptr;
+  /// Linear colors
+  RGB* color = nullptr;
+  std::uint8_t* uniform = nullptr;
+  /// Set once a pixel of the tile holds more than one color
+  std::uint8_t* tile_split = nullptr;
+};
+
+/// Offsets of the edge functions and barycentric weights of the samples of a
+/// triangle from the pixel centre
+struct SampleSteps {
+  std::array<std::array<std::int64_t, msaa_sample_count>, 3> edges{};
+  std::array<float, msaa_sample_count> l1{};
+  std::array<float, msaa_sample_count> l2{};
+
+  explicit SampleSteps(const TriangleSetup& setup) noexcept;
+};
+
+/// Rasterizes and shades the pixels of `run`, a row of whole hierarchical
+/// depth blocks of one tile, into a multisampled target. `context` is passed
+/// through from the caller.
+using MultisampledRunRasterizer =
+    auto (*)(const void* context, const TriangleSetup& setup, const Rect& run,
+             const SampleSteps& steps, const SampleTarget& target)
+        -> FragmentCounts;
+
+/**
+ * \brief Rasterizes the part of a triangle inside `tile` into a multisampled
+ * target with `rasterize_run`
+ *
+ * Coverage and depth are evaluated at every sample, and a pixel is shaded
+ * once if any of its samples passes the depth test, see
+ * detail::rasterize_run_multisampled(). Hierarchical depth culling works as
+ * for single sampled targets, with `coarse_depth` holding the farthest sample
+ * of every block.
+ */
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        const SampleTarget& target,
+                        std::vector<float>& coarse_depth,
+                        MultisampledRunRasterizer rasterize_run,
+                        const void* context, PipelineStats& stats);
+
+/// Rasterizes into a multisampled target with the built-in textured shading
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        const SampleTarget& target,
+                        std::vector<float>& coarse_depth,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats);
+
+/// A pixel of a visibility buffer that no triangle of the draw covers
+constexpr std::uint32_t no_triangle = 0xFFFF'FFFF;
+
+/// The visibility buffer of ShadingMode::visibility_buffer, laid out like the
+/// depth buffer. Each pixel holds the index of its nearest triangle in the
+/// bin of its tile, or no_triangle.
+struct VisibilityTarget {
+  int width = 0;
+  int height = 0;
+  std::uint32_t* triangle = nullptr;
+};
+
+/**
+ * \brief Rasterizes the depth of the part of a triangle inside `tile`, and
+ * stores `triangle` where it passes the depth test
+ *
+ * Nothing is shaded, so fragments_passed counts the pixels the triangle was
+ * the nearest of at the time. Hierarchical depth culling works as for the
+ * other rasterizers.
+ */
+void rasterize_triangle(const TriangleSetup& setup, std::uint32_t triangle,
+                        const Rect& tile, std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const VisibilityTarget& visibility,
+                        PipelineStats& stats);
+
+/**
+ * \brief Shades every pixel of `tile` that holds a triangle of `triangles`
+ * once with the built-in textured shading, and resets it to no_triangle
+ *
+ * See detail::shade_visible(). Also counts the texel fetches in `stats`.
+ */
+void shade_visible(std::span<const TriangleSetup* const> triangles,
+                   const Rect& tile, const VisibilityTarget& visibility,
+                   const ColorTarget& target,
+                   const TextureView& diffuse_texture, PipelineStats& stats);
+
+/// Octahedral encoding of a unit vector into two 16-bit signed normalized
+/// values, accurate to about 0.01 degrees
+[[nodiscard]] auto pack_normal(const beyond::Vec3& normal) noexcept
+    -> std::uint32_t;
+[[nodiscard]] auto unpack_normal(std::uint32_t packed) noexcept
+    -> beyond::Vec3;
+
+/// The G-buffer of deferred shading, laid out like the depth buffer
+struct GBufferTarget {
+  int width = 0;
+  int height = 0;
+  /// By pack_normal()
+  std::uint32_t* normal = nullptr;
+  /// sRGB encoded, in the layout of ColorFormat::rgba8_srgb
+  std::uint32_t* albedo = nullptr;
+};
+
+/**
+ * \brief Rasterizes the part of a triangle inside `tile` into a G-buffer
+ *
+ * Writes the depth, the normal of the setup and the texture color scaled by
+ * the color of the setup as albedo, with hierarchical depth culling.
+ */
+void rasterize_triangle(const TriangleSetup& setup, const Rect& tile,
+                        std::vector<float>& depth_buffer,
+                        std::vector<float>& coarse_depth,
+                        const GBufferTarget& target,
+                        const TextureView& diffuse_texture,
+                        PipelineStats& stats);
+
+/// Lines and points pass the depth test this far behind the stored depth, so
+/// the edges of a filled draw show in a wireframe of it
+constexpr float line_depth_bias = 1e-3f;
+
+/**
+ * \brief Draws a one-pixel wide line between two screen-space positions
+ *
+ * The line is clipped to `scissor` up front with clip_line(), then stepped
+ * with integer Bresenham, one pixel per step of its major axis. Pixels that
+ * pass the depth test, if enabled, get `color`. The depth buffer is never
+ * written.
+ */
+void rasterize_line(beyond::Point3 from, beyond::Point3 to,
+                    const Rect& scissor, const std::vector<float>& depth_buffer,
+                    const ColorTarget& target, const RGB& color,
+                    bool depth_test, PipelineStats& stats);
+
+/// Draws the pixel of a screen-space position as rasterize_line() does
+void rasterize_point(const beyond::Point3& point, const Rect& scissor,
+                     const std::vector<float>& depth_buffer,
+                     const ColorTarget& target, const RGB& color,
+                     bool depth_test, PipelineStats& stats);
+
+} // namespace yasr
+
+#endif // YASR_RASTERIZER_HPP
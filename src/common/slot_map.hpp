@@ -0,0 +1,110 @@
+#ifndef YASR_SLOT_MAP_HPP
+#define YASR_SLOT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+/**
+ * \brief A table of values addressed by ids that detect reuse of their slot
+ *
+ * An id packs the slot index in its low 32 bits and the generation of the
+ * slot in its high 32 bits. Erasing a value bumps the generation of its slot
+ * and queues the slot for reuse, so the ids of erased values stop resolving.
+ * Generations start at 1, so id 0 never resolves to a value.
+ *
+ * Values stay in place until erased, like in a std::deque.
+ */
+template <typename T> class SlotMap {
+public:
+  /// Stores `value` in a free slot and returns its id
+  template <typename... Args> auto emplace(Args&&... args) -> std::uint64_t
+  {
+    std::uint32_t index = 0;
+    if (free_slots_.empty()) {
+      index = static_cast<std::uint32_t>(slots_.size());
+      slots_.emplace_back();
+    } else {
+      index = free_slots_.back();
+      free_slots_.pop_back();
+    }
+    Slot& slot = slots_[index];
+    slot.value.emplace(std::forward<Args>(args)...);
+    ++size_;
+    return std::uint64_t{slot.generation} << 32 | index;
+  }
+
+  /// Destroys the value of `id` and returns it, or returns nothing if `id`
+  /// resolves to no value
+  auto erase(std::uint64_t id) -> std::optional<T>
+  {
+    Slot* const slot = find(id);
+    if (slot == nullptr) { return std::nullopt; }
+
+    std::optional<T> value = std::move(slot->value);
+    slot->value.reset();
+    // A generation that wraps around to 0 would resolve again, so the slot
+    // retires instead
+    if (++slot->generation != 0) {
+      free_slots_.push_back(static_cast<std::uint32_t>(id));
+    }
+    --size_;
+    return value;
+  }
+
+  /// The value of `id`, or nullptr if it was erased or never existed
+  [[nodiscard]] auto get(std::uint64_t id) noexcept -> T*
+  {
+    Slot* const slot = find(id);
+    return slot != nullptr ? &*slot->value : nullptr;
+  }
+  [[nodiscard]] auto get(std::uint64_t id) const noexcept -> const T*
+  {
+    return const_cast<SlotMap&>(*this).get(id);
+  }
+
+  [[nodiscard]] auto contains(std::uint64_t id) const noexcept -> bool
+  {
+    return get(id) != nullptr;
+  }
+
+  /// The value of `id`, which must be valid
+  [[nodiscard]] auto operator[](std::uint64_t id) noexcept -> T&
+  {
+    T* const value = get(id);
+    BEYOND_ASSERT(value != nullptr);
+    return *value;
+  }
+
+  [[nodiscard]] auto size() const noexcept -> std::size_t { return size_; }
+
+private:
+  struct Slot {
+    std::optional<T> value;
+    std::uint32_t generation = 1;
+  };
+  std::deque<Slot> slots_;
+  std::vector<std::uint32_t> free_slots_;
+  std::size_t size_ = 0;
+
+  [[nodiscard]] auto find(std::uint64_t id) noexcept -> Slot*
+  {
+    const auto index = static_cast<std::uint32_t>(id);
+    const auto generation = static_cast<std::uint32_t>(id >> 32);
+    if (index >= slots_.size()) { return nullptr; }
+    Slot& slot = slots_[index];
+    if (slot.generation != generation || !slot.value) { return nullptr; }
+    return &slot;
+  }
+};
+
+} // namespace yasr
+
+#endif // YASR_SLOT_MAP_HPP
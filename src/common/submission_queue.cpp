@@ -0,0 +1,125 @@
+#include "submission_queue.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace yasr {
+
+namespace {
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+constexpr bool has_threads = false;
+#else
+constexpr bool has_threads = true;
+#endif
+
+} // anonymous namespace
+
+SubmissionQueue::SubmissionQueue(Executor executor)
+    : executor_{std::move(executor)}
+{
+  if constexpr (has_threads) {
+    thread_ = std::thread{[this] { run(); }};
+  }
+}
+
+SubmissionQueue::~SubmissionQueue()
+{
+  if constexpr (has_threads) {
+    {
+      const std::scoped_lock lock{mutex_};
+      stop_ = true;
+    }
+    job_cv_.notify_one();
+    thread_.join();
+  }
+}
+
+auto SubmissionQueue::submit(CommandBuffer&& commands) -> std::uint64_t
+{
+  if constexpr (!has_threads) {
+    executor_(commands);
+    const std::scoped_lock lock{mutex_};
+    retire(commands);
+    completed_ = ++submitted_;
+    return submitted_;
+  }
+
+  std::uint64_t fence = 0;
+  {
+    const std::scoped_lock lock{mutex_};
+    if (job_count_ == jobs_.size()) {
+      // Unrolls the ring into a larger one
+      std::vector<Job> jobs(std::max<std::size_t>(2 * jobs_.size(), 4));
+      for (std::size_t i = 0; i < job_count_; ++i) {
+        jobs[i] = std::move(jobs_[(first_job_ + i) % jobs_.size()]);
+      }
+      jobs_ = std::move(jobs);
+      first_job_ = 0;
+    }
+    fence = ++submitted_;
+    jobs_[(first_job_ + job_count_) % jobs_.size()] =
+        Job{.commands = std::move(commands), .fence = fence};
+    ++job_count_;
+  }
+  job_cv_.notify_one();
+  return fence;
+}
+
+auto SubmissionQueue::acquire() -> CommandBuffer
+{
+  const std::scoped_lock lock{mutex_};
+  if (retired_.empty()) { return CommandBuffer{}; }
+  CommandBuffer commands = std::move(retired_.back());
+  retired_.pop_back();
+  return commands;
+}
+
+auto SubmissionQueue::is_signaled(std::uint64_t fence) const -> bool
+{
+  const std::scoped_lock lock{mutex_};
+  return completed_ >= fence;
+}
+
+void SubmissionQueue::wait(std::uint64_t fence)
+{
+  std::unique_lock lock{mutex_};
+  done_cv_.wait(lock, [&] { return completed_ >= fence; });
+}
+
+void SubmissionQueue::wait_idle()
+{
+  std::unique_lock lock{mutex_};
+  done_cv_.wait(lock, [&] { return completed_ == submitted_; });
+}
+
+void SubmissionQueue::run()
+{
+  std::unique_lock lock{mutex_};
+  while (true) {
+    job_cv_.wait(lock, [&] { return stop_ || job_count_ > 0; });
+    // Jobs submitted before the destructor still run
+    if (job_count_ == 0) { return; }
+
+    Job& job = jobs_[first_job_];
+    CommandBuffer commands = std::move(job.commands);
+    const std::uint64_t fence = job.fence;
+    first_job_ = (first_job_ + 1) % jobs_.size();
+    --job_count_;
+    lock.unlock();
+    executor_(commands);
+    lock.lock();
+    retire(commands);
+    completed_ = fence;
+    done_cv_.notify_all();
+  }
+}
+
+void SubmissionQueue::retire(CommandBuffer& commands)
+{
+  if (retired_.size() == max_retired) { return; }
+  commands.reset();
+  retired_.push_back(std::move(commands));
+}
+
+} // namespace yasr
@@ -0,0 +1,82 @@
+#ifndef YASR_SUBMISSION_QUEUE_HPP
+#define YASR_SUBMISSION_QUEUE_HPP
+
+#include "yasr.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yasr {
+
+/**
+ * \brief Runs submitted command buffers in order on a thread of its own
+ *
+ * Every submission signals a fence value once it has run. Fence values start
+ * at 1 and grow by one per submission, so a fence is signaled once every
+ * value up to it is. Without thread support, submissions run inside
+ * submit().
+ *
+ * Pending submissions wait in a ring that only grows, and command buffers
+ * that have run are reset and kept for acquire(), so a steady stream of
+ * submissions allocates no memory.
+ */
+class SubmissionQueue {
+public:
+  /// Runs the commands of a submission, on the thread of the queue
+  using Executor = std::function<void(const CommandBuffer&)>;
+
+  explicit SubmissionQueue(Executor executor);
+  /// Runs the pending submissions before returning
+  ~SubmissionQueue();
+
+  SubmissionQueue(const SubmissionQueue&) = delete;
+  auto operator=(const SubmissionQueue&) & -> SubmissionQueue& = delete;
+  SubmissionQueue(SubmissionQueue&&) noexcept = delete;
+  auto operator=(SubmissionQueue&&) & noexcept -> SubmissionQueue& = delete;
+
+  /// Queues `commands` after the earlier submissions and returns its fence
+  /// value
+  auto submit(CommandBuffer&& commands) -> std::uint64_t;
+  /// An empty command buffer, with the storage of one that has run if any
+  [[nodiscard]] auto acquire() -> CommandBuffer;
+
+  [[nodiscard]] auto is_signaled(std::uint64_t fence) const -> bool;
+  void wait(std::uint64_t fence);
+  /// Waits for every submission so far
+  void wait_idle();
+
+private:
+  /// Command buffers kept for acquire() at most, the rest are freed
+  static constexpr std::size_t max_retired = 4;
+
+  struct Job {
+    CommandBuffer commands;
+    std::uint64_t fence = 0;
+  };
+
+  Executor executor_;
+  mutable std::mutex mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  /// A ring of the pending jobs, from `first_job_`
+  std::vector<Job> jobs_;
+  std::size_t first_job_ = 0;
+  std::size_t job_count_ = 0;
+  std::vector<CommandBuffer> retired_;
+  std::uint64_t submitted_ = 0;
+  std::uint64_t completed_ = 0;
+  bool stop_ = false;
+  std::thread thread_;
+
+  void run();
+  /// Resets `commands` and keeps it for acquire(), with the mutex held
+  void retire(CommandBuffer& commands);
+};
+
+} // namespace yasr
+
+#endif // YASR_SUBMISSION_QUEUE_HPP
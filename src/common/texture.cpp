@@ -0,0 +1,175 @@
+#include "texture.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#include <beyond/utils/assert.hpp>
+#include <beyond/utils/bit_cast.hpp>
+
+namespace yasr {
+
+namespace {
+
+[[nodiscard]] auto make_unorm_table() -> std::array<float, 256>
+{
+  std::array<float, 256> table{};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    table[i] = static_cast<float>(i) / 255.f;
+  }
+  return table;
+}
+
+[[nodiscard]] auto make_srgb_table() -> std::array<float, 256>
+{
+  std::array<float, 256> table{};
+  for (std::size_t i = 0; i < table.size(); ++i) {
+    const float c = static_cast<float>(i) / 255.f;
+    table[i] = c <= 0.04045f ? c / 12.92f
+                             : std::pow((c + 0.055f) / 1.055f, 2.4f);
+  }
+  return table;
+}
+
+[[nodiscard]] constexpr auto tile_count(int texels) noexcept -> int
+{
+  return (texels + texture_tile_size - 1) / texture_tile_size;
+}
+
+[[nodiscard]] constexpr auto level_size_in_bytes(int width, int height) noexcept
+    -> std::size_t
+{
+  return static_cast<std::size_t>(tile_count(width) * tile_count(height)) *
+         texture_tile_size * texture_tile_size * 4;
+}
+
+[[nodiscard]] auto encode_unorm(float c) -> std::uint8_t
+{
+  return static_cast<std::uint8_t>(std::lround(std::clamp(c, 0.f, 1.f) * 255));
+}
+
+[[nodiscard]] auto encode(TextureFormat format, float c) -> std::uint8_t
+{
+  if (format == TextureFormat::rgba8_unorm) { return encode_unorm(c); }
+  c = std::clamp(c, 0.f, 1.f);
+  return encode_unorm(c <= 0.0031308f
+                          ? c * 12.92f
+                          : 1.055f * std::pow(c, 1 / 2.4f) - 0.055f);
+}
+
+/// Box filters a row-major linear RGBA image to half its size
+[[nodiscard]] auto downsample(const std::vector<float>& source, int width,
+                              int height) -> std::vector<float>
+{
+  const int half_width = std::max(width / 2, 1);
+  const int half_height = std::max(height / 2, 1);
+  std::vector<float> result(
+      static_cast<std::size_t>(half_width * half_height * 4));
+  for (int y = 0; y < half_height; ++y) {
+    const int y0 = std::min(2 * y, height - 1);
+    const int y1 = std::min(2 * y + 1, height - 1);
+    for (int x = 0; x < half_width; ++x) {
+      const int x0 = std::min(2 * x, width - 1);
+      const int x1 = std::min(2 * x + 1, width - 1);
+      for (int c = 0; c < 4; ++c) {
+        const auto at = [&](int sx, int sy) {
+          return source[static_cast<std::size_t>((sy * width + sx) * 4 + c)];
+        };
+        result[static_cast<std::size_t>((y * half_width + x) * 4 + c)] =
+            (at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1)) * 0.25f;
+      }
+    }
+  }
+  return result;
+}
+
+/// Copies a row-major RGBA8 image into the tiled Morton layout of `level`
+void store_level(const TextureStorage::LevelInfo& level,
+                 const std::uint8_t* row_major, std::vector<std::uint8_t>& out)
+{
+  const int tiles_x = tile_count(level.width);
+  for (int y = 0; y < level.height; ++y) {
+    for (int x = 0; x < level.width; ++x) {
+      std::memcpy(out.data() + level.offset + texel_offset(x, y, tiles_x),
+                  row_major + (y * level.width + x) * 4, 4);
+    }
+  }
+}
+
+} // anonymous namespace
+
+auto channel_to_linear_table(TextureFormat format) noexcept
+    -> const std::array<float, 256>&
+{
+  static const auto unorm_table = make_unorm_table();
+  static const auto srgb_table = make_srgb_table();
+  switch (format) {
+  case TextureFormat::rgba8_unorm:
+    return unorm_table;
+  case TextureFormat::rgba8_srgb:
+    break;
+  }
+  return srgb_table;
+}
+
+TextureStorage::TextureStorage(const TextureDesc& desc) : format{desc.format}
+{
+  BEYOND_ASSERT(desc.width > 0 && desc.height > 0);
+  BEYOND_ASSERT(desc.data.size() ==
+                std::size_t{desc.width} * desc.height * 4);
+
+  int level_width = static_cast<int>(desc.width);
+  int level_height = static_cast<int>(desc.height);
+  std::size_t size = 0;
+  while (std::ssize(levels) < max_mip_levels) {
+    levels.push_back({size, level_width, level_height});
+    size += level_size_in_bytes(level_width, level_height);
+    if (level_width == 1 && level_height == 1) { break; }
+    level_width = std::max(level_width / 2, 1);
+    level_height = std::max(level_height / 2, 1);
+  }
+  texels.resize(size);
+
+  // Level 0 keeps the original bytes, the others are box filtered in linear
+  // space from the level above
+  const auto* source = beyond::bit_cast<const std::uint8_t*>(desc.data.data());
+  const auto& to_linear = channel_to_linear_table(format);
+  std::vector<float> linear(desc.data.size());
+  for (std::size_t i = 0; i < desc.data.size(); ++i) {
+    linear[i] = i % 4 == 3 ? static_cast<float>(source[i]) / 255.f
+                           : to_linear[source[i]];
+  }
+  store_level(levels[0], source, texels);
+
+  std::vector<std::uint8_t> encoded;
+  for (std::size_t i = 1; i < levels.size(); ++i) {
+    linear = downsample(linear, levels[i - 1].width, levels[i - 1].height);
+    encoded.resize(linear.size());
+    for (std::size_t j = 0; j < linear.size(); ++j) {
+      encoded[j] =
+          j % 4 == 3 ? encode_unorm(linear[j]) : encode(format, linear[j]);
+    }
+    store_level(levels[i], encoded.data(), texels);
+  }
+}
+
+auto TextureStorage::view(TextureFilter filter) const noexcept -> TextureView
+{
+  TextureView view{
+      .levels = {},
+      .level_count = static_cast<int>(levels.size()),
+      .to_linear = channel_to_linear_table(format).data(),
+      .filter = filter,
+  };
+  for (std::size_t i = 0; i < levels.size(); ++i) {
+    const auto& level = levels[i];
+    view.levels[i] = MipLevel{
+        .texels = texels.data() + level.offset,
+        .width = level.width,
+        .height = level.height,
+        .tiles_x = tile_count(level.width),
+    };
+  }
+  return view;
+}
+
+} // namespace yasr
@@ -0,0 +1,162 @@
+#ifndef YASR_TEXTURE_HPP
+#define YASR_TEXTURE_HPP
+
+#include "color.hpp"
+#include "yasr.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace yasr {
+
+/// Enough levels for a 32768x32768 texture
+constexpr int max_mip_levels = 16;
+
+/// Texels are stored in square tiles of this size, Morton ordered inside
+constexpr int texture_tile_size = 8;
+
+/// Maps an 8-bit channel of a texture of `format` to a linear float
+[[nodiscard]] auto channel_to_linear_table(TextureFormat format) noexcept
+    -> const std::array<float, 256>&;
+
+/// Offset of texel (x, y) inside its tile, with x in the even and y in the odd
+/// bits of the Z-order curve
+[[nodiscard]] constexpr auto morton_offset(int x, int y) noexcept -> int
+{
+  constexpr std::array<int, texture_tile_size> spread{0,  1,  4,  5,
+                                                      16, 17, 20, 21};
+  return spread[x & (texture_tile_size - 1)] |
+         (spread[y & (texture_tile_size - 1)] << 1);
+}
+
+/// Byte offset of texel (x, y) in a level that is `tiles_x` tiles wide
+[[nodiscard]] constexpr auto texel_offset(int x, int y, int tiles_x) noexcept
+    -> int
+{
+  constexpr int tile_texels = texture_tile_size * texture_tile_size;
+  const int tile = (y / texture_tile_size) * tiles_x + x / texture_tile_size;
+  return (tile * tile_texels + morton_offset(x, y)) * 4;
+}
+
+struct MipLevel {
+  /// RGBA8 texels in tiled Morton order
+  const std::uint8_t* texels = nullptr;
+  int width = 0;
+  int height = 0;
+  int tiles_x = 0;
+
+  [[nodiscard]] auto texel(int x, int y) const noexcept -> const std::uint8_t*
+  {
+    return texels + texel_offset(x, y, tiles_x);
+  }
+};
+
+struct TextureView {
+  std::array<MipLevel, max_mip_levels> levels;
+  int level_count = 0;
+  /// Converts a stored 8-bit channel to a linear float
+  const float* to_linear = nullptr;
+  TextureFilter filter = TextureFilter::trilinear;
+};
+
+/**
+ * \brief Samples a texture at (u, v) with the view's filter
+ *
+ * v = 0 is the bottom row. Coordinates are clamped to the edge of the texture.
+ * \param lod The level of detail, log2 of the texel footprint of a pixel on
+ * level 0. Ignored by the nearest filter, which always samples level 0.
+ */
+[[nodiscard]] inline auto sample(const TextureView& texture, float u, float v,
+                                 float lod) noexcept -> RGB
+{
+  const auto fetch = [&](const MipLevel& level, int x, int y) {
+    const std::uint8_t* texel = level.texel(x, y);
+    return RGB{texture.to_linear[texel[0]], texture.to_linear[texel[1]],
+               texture.to_linear[texel[2]]};
+  };
+
+  const auto bilinear = [&](const MipLevel& level) {
+    const float x = u * static_cast<float>(level.width) - 0.5f;
+    const float y = (1.f - v) * static_cast<float>(level.height) - 0.5f;
+    const float x_floor = std::floor(x);
+    const float y_floor = std::floor(y);
+    const float fx = x - x_floor;
+    const float fy = y - y_floor;
+    const int x0 = std::clamp(static_cast<int>(x_floor), 0, level.width - 1);
+    const int y0 = std::clamp(static_cast<int>(y_floor), 0, level.height - 1);
+    const int x1 = std::clamp(static_cast<int>(x_floor) + 1, 0, level.width - 1);
+    const int y1 =
+        std::clamp(static_cast<int>(y_floor) + 1, 0, level.height - 1);
+
+    const RGB c00 = fetch(level, x0, y0);
+    const RGB c10 = fetch(level, x1, y0);
+    const RGB c01 = fetch(level, x0, y1);
+    const RGB c11 = fetch(level, x1, y1);
+    const auto lerp2 = [&](float a, float b, float c, float d) {
+      const float top = a + (b - a) * fx;
+      const float bottom = c + (d - c) * fx;
+      return top + (bottom - top) * fy;
+    };
+    return RGB{lerp2(c00.r, c10.r, c01.r, c11.r),
+               lerp2(c00.g, c10.g, c01.g, c11.g),
+               lerp2(c00.b, c10.b, c01.b, c11.b)};
+  };
+
+  const float max_lod = static_cast<float>(texture.level_count - 1);
+  switch (texture.filter) {
+  case TextureFilter::nearest: {
+    const MipLevel& level = texture.levels[0];
+    const int x = std::clamp(static_cast<int>(u * static_cast<float>(level.width)),
+                             0, level.width - 1);
+    const int y =
+        std::clamp(static_cast<int>((1.f - v) * static_cast<float>(level.height)),
+                   0, level.height - 1);
+    return fetch(level, x, y);
+  }
+  case TextureFilter::bilinear: {
+    const int level = static_cast<int>(std::clamp(lod + 0.5f, 0.f, max_lod));
+    return bilinear(texture.levels[level]);
+  }
+  case TextureFilter::trilinear:
+    break;
+  }
+
+  const float clamped_lod = std::clamp(lod, 0.f, max_lod);
+  const int level = static_cast<int>(clamped_lod);
+  const float t = clamped_lod - static_cast<float>(level);
+  const RGB fine = bilinear(texture.levels[level]);
+  if (t == 0.f) { return fine; }
+  const RGB coarse = bilinear(texture.levels[level + 1]);
+  return RGB{fine.r + (coarse.r - fine.r) * t, fine.g + (coarse.g - fine.g) * t,
+             fine.b + (coarse.b - fine.b) * t};
+}
+
+/// Device-side storage of a texture, decoded and mipmapped once at creation
+struct TextureStorage {
+  struct LevelInfo {
+    std::size_t offset = 0;
+    int width = 0;
+    int height = 0;
+  };
+
+  TextureFormat format = TextureFormat::rgba8_srgb;
+  std::vector<LevelInfo> levels;
+  std::vector<std::uint8_t> texels;
+
+  TextureStorage() = default;
+  explicit TextureStorage(const TextureDesc& desc);
+
+  [[nodiscard]] auto empty() const noexcept -> bool
+  {
+    return texels.empty();
+  }
+
+  [[nodiscard]] auto view(TextureFilter filter) const noexcept -> TextureView;
+};
+
+} // namespace yasr
+
+#endif // YASR_TEXTURE_HPP
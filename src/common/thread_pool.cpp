@@ -0,0 +1,114 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace yasr {
+
+ThreadPool::ThreadPool(std::uint32_t thread_count)
+{
+  thread_count = std::max(thread_count, 1u);
+  queues_.reserve(thread_count);
+  for (std::uint32_t i = 0; i < thread_count; ++i) {
+    queues_.push_back(std::make_unique<WorkQueue>());
+  }
+
+  workers_.reserve(thread_count - 1);
+  for (std::uint32_t i = 1; i < thread_count; ++i) {
+    workers_.emplace_back([this, i] { worker_loop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard lock{job_mutex_};
+    stop_ = true;
+  }
+  job_cv_.notify_all();
+  for (auto& worker : workers_) { worker.join(); }
+}
+
+void ThreadPool::run(std::size_t count, TaskRef task)
+{
+  if (count == 0) { return; }
+
+  if (workers_.empty()) {
+    for (std::size_t i = 0; i < count; ++i) { task(i); }
+    return;
+  }
+
+  {
+    std::lock_guard lock{job_mutex_};
+    task_ = task;
+    remaining_ = count;
+    const std::size_t stride = queues_.size();
+    for (std::size_t i = 0; i < stride; ++i) {
+      auto& queue = *queues_[i];
+      std::lock_guard queue_lock{queue.mutex};
+      queue.front = i;
+      queue.back = i < count ? i + (count - i + stride - 1) / stride * stride
+                             : i;
+    }
+    ++generation_;
+  }
+  job_cv_.notify_all();
+
+  run_tasks(0);
+
+  std::unique_lock lock{job_mutex_};
+  done_cv_.wait(lock, [this] { return remaining_ == 0; });
+  task_ = TaskRef{};
+}
+
+void ThreadPool::worker_loop(std::size_t worker_index)
+{
+  std::uint64_t seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock lock{job_mutex_};
+      job_cv_.wait(lock, [&] {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) { return; }
+      seen_generation = generation_;
+    }
+    run_tasks(worker_index);
+  }
+}
+
+void ThreadPool::run_tasks(std::size_t worker_index)
+{
+  while (const auto item = pop_or_steal(worker_index)) {
+    task_(*item);
+    if (remaining_.fetch_sub(1) == 1) {
+      std::lock_guard lock{job_mutex_};
+      done_cv_.notify_all();
+    }
+  }
+}
+
+auto ThreadPool::pop_or_steal(std::size_t worker_index)
+    -> std::optional<std::size_t>
+{
+  {
+    auto& own = *queues_[worker_index];
+    std::lock_guard lock{own.mutex};
+    if (own.front != own.back) {
+      const std::size_t item = own.front;
+      own.front += queues_.size();
+      return item;
+    }
+  }
+
+  for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+    auto& victim = *queues_[(worker_index + offset) % queues_.size()];
+    std::lock_guard lock{victim.mutex};
+    if (victim.front != victim.back) {
+      victim.back -= queues_.size();
+      return victim.back;
+    }
+  }
+  return std::nullopt;
+}
+
+} // namespace yasr
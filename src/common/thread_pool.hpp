@@ -0,0 +1,95 @@
+#ifndef YASR_THREAD_POOL_HPP
+#define YASR_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace yasr {
+
+/**
+ * \brief A fork-join thread pool with per-worker work-stealing queues
+ *
+ * The thread calling parallel_for() participates as worker 0, so a pool
+ * created with a thread count of 1 spawns no threads at all. Running tasks
+ * allocates no memory.
+ */
+class ThreadPool {
+public:
+  explicit ThreadPool(std::uint32_t thread_count);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) & -> ThreadPool& = delete;
+  ThreadPool(ThreadPool&&) noexcept = delete;
+  auto operator=(ThreadPool&&) & noexcept -> ThreadPool& = delete;
+
+  [[nodiscard]] auto thread_count() const noexcept -> std::uint32_t
+  {
+    return static_cast<std::uint32_t>(queues_.size());
+  }
+
+  /**
+   * \brief Invokes task(i) for every i in [0, count) and waits for all of them
+   *
+   * Tasks are distributed round-robin to the worker queues up front, idle
+   * workers then steal from the back of the other queues.
+   */
+  template <typename Task> void parallel_for(std::size_t count, Task&& task)
+  {
+    run(count, TaskRef{
+                   .task = &task,
+                   .invoke =
+                       [](const void* erased, std::size_t i) {
+                         (*static_cast<const std::remove_reference_t<Task>*>(
+                             erased))(i);
+                       },
+               });
+  }
+
+private:
+  /// The task of parallel_for(), referenced without copying it
+  struct TaskRef {
+    const void* task = nullptr;
+    void (*invoke)(const void* task, std::size_t i) = nullptr;
+
+    void operator()(std::size_t i) const { invoke(task, i); }
+  };
+
+  /// The items of a worker, `front`, `front + stride` and so on up to
+  /// before `back`, where stride is the number of workers
+  struct WorkQueue {
+    std::mutex mutex;
+    std::size_t front = 0;
+    std::size_t back = 0;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex job_mutex_;
+  std::condition_variable job_cv_;
+  std::condition_variable done_cv_;
+  std::uint64_t generation_ = 0;
+  bool stop_ = false;
+
+  TaskRef task_;
+  std::atomic<std::size_t> remaining_ = 0;
+
+  void run(std::size_t count, TaskRef task);
+  void worker_loop(std::size_t worker_index);
+  void run_tasks(std::size_t worker_index);
+  [[nodiscard]] auto pop_or_steal(std::size_t worker_index)
+      -> std::optional<std::size_t>;
+};
+
+} // namespace yasr
+
+#endif // YASR_THREAD_POOL_HPP
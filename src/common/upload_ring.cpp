@@ -0,0 +1,53 @@
+#include "upload_ring.hpp"
+
+#include <algorithm>
+
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+UploadRing::UploadRing(Device& device, const UploadRingDesc& desc)
+    : device_{device},
+      // Keeps every region aligned
+      frame_size_{(desc.frame_size + alignment - 1) / alignment * alignment},
+      fences_(desc.frame_count)
+{
+  BEYOND_ASSERT(desc.frame_count > 0);
+  buffer_ = device_.create_buffer(
+      BufferDesc{.data = {}, .size = frame_size_ * desc.frame_count});
+  memory_ = device_.map_buffer(buffer_);
+}
+
+UploadRing::~UploadRing()
+{
+  for (const Fence fence : fences_) { device_.wait(fence); }
+  device_.destroy_buffer(buffer_);
+}
+
+void UploadRing::begin_frame()
+{
+  current_ = (current_ + 1) % fences_.size();
+  used_ = 0;
+  device_.wait(fences_[current_]);
+  fences_[current_] = Fence{};
+}
+
+void UploadRing::end_frame(Fence fence) noexcept
+{
+  fences_[current_] = fence;
+}
+
+auto UploadRing::allocate_bytes(std::size_t size) -> Upload<std::byte>
+{
+  BEYOND_ASSERT(size <= remaining());
+  const std::size_t offset = current_ * frame_size_ + used_;
+  used_ = std::min(frame_size_,
+                   used_ + (size + alignment - 1) / alignment * alignment);
+  return Upload<std::byte>{
+      .buffer = buffer_,
+      .offset = offset,
+      .data = memory_.subspan(offset, size),
+  };
+}
+
+} // namespace yasr
@@ -0,0 +1,103 @@
+#ifndef YASR_UPLOAD_RING_HPP
+#define YASR_UPLOAD_RING_HPP
+
+#include "yasr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include <beyond/utils/bit_cast.hpp>
+
+namespace yasr {
+
+struct UploadRingDesc {
+  /// Bytes the allocations of a frame can take
+  std::size_t frame_size = std::size_t{1} << 20;
+  /// Frames in flight at once, each with a region of its own
+  std::uint32_t frame_count = 2;
+};
+
+/// Memory of an UploadRing to write, and where draws find it
+template <typename T> struct Upload {
+  /// The buffer of the ring, which holds `data` from `offset`. Bind it with
+  /// `offset` and the size of `data`.
+  Buffer buffer;
+  std::size_t offset = 0;
+  /// Valid until the ring reuses the region of its frame
+  std::span<T> data;
+};
+
+/**
+ * \brief Streams data written anew every frame, such as the vertices and
+ * indices of animated or generated meshes
+ *
+ * A single buffer of device memory, mapped with Device::map_buffer(), is
+ * split into a region per frame in flight. Allocations are carved from the
+ * region of the current frame in order, and draws bind them by their offset
+ * in the buffer. Once a frame has been submitted, its region is reused
+ * frame_count frames later, after waiting for the fence of that submission.
+ * Allocating takes no lock and creates no resource.
+ *
+ * Not thread-safe.
+ */
+class UploadRing {
+public:
+  static constexpr std::size_t alignment = 64;
+
+  explicit UploadRing(Device& device, const UploadRingDesc& desc = {});
+  /// Waits for the frames in flight and destroys the buffer
+  ~UploadRing();
+
+  UploadRing(const UploadRing&) = delete;
+  auto operator=(const UploadRing&) & -> UploadRing& = delete;
+  UploadRing(UploadRing&&) noexcept = delete;
+  auto operator=(UploadRing&&) & noexcept -> UploadRing& = delete;
+
+  /// Moves on to the region of the next frame, after waiting for the
+  /// submission that last read it
+  void begin_frame();
+  /// Marks the allocations of the current frame as read by the submission
+  /// of `fence`. Fence{} suits draws of immediate calls, which have run.
+  void end_frame(Fence fence) noexcept;
+
+  /// `size` bytes aligned to `alignment`, which must fit in what remains of
+  /// the frame
+  [[nodiscard]] auto allocate_bytes(std::size_t size) -> Upload<std::byte>;
+
+  /// Room for `count` objects of T, left uninitialized
+  template <typename T>
+  [[nodiscard]] auto allocate(std::size_t count) -> Upload<T>
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= alignment);
+    const Upload<std::byte> upload = allocate_bytes(count * sizeof(T));
+    return Upload<T>{
+        .buffer = upload.buffer,
+        .offset = upload.offset,
+        .data = {beyond::bit_cast<T*>(upload.data.data()), count},
+    };
+  }
+
+  /// Bytes left in the region of the current frame
+  [[nodiscard]] auto remaining() const noexcept -> std::size_t
+  {
+    return frame_size_ - used_;
+  }
+
+private:
+  Device& device_;
+  std::size_t frame_size_ = 0;
+  Buffer buffer_;
+  std::span<std::byte> memory_;
+  /// The submission that last read the region of each frame
+  std::vector<Fence> fences_;
+  std::size_t current_ = 0;
+  std::size_t used_ = 0;
+};
+
+} // namespace yasr
+
+#endif // YASR_UPLOAD_RING_HPP
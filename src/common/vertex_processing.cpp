@@ -0,0 +1,188 @@
+#include "vertex_processing.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include <beyond/utils/assert.hpp>
+
+namespace yasr {
+
+void PostTransformVertices::resize(std::size_t count)
+{
+  x.resize(count);
+  y.resize(count);
+  z.resize(count);
+  inv_w.resize(count);
+  clip_flags.resize(count);
+}
+
+void VertexCache::build(std::span<const std::uint32_t> indices,
+                        [[maybe_unused]] std::size_t vertex_count)
+{
+  // Sized by the largest index rather than the vertex buffer, so draws of a
+  // small part of a shared buffer stay cheap
+  const std::uint32_t max_index =
+      indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+  BEYOND_ASSERT(indices.empty() || max_index < vertex_count);
+  slots_.assign(indices.empty() ? 0 : std::size_t{max_index} + 1,
+                invalid_slot);
+  unique_vertices_.clear();
+
+  for (const auto index : indices) {
+    if (slots_[index] == invalid_slot) {
+      slots_[index] = static_cast<std::uint32_t>(unique_vertices_.size());
+      unique_vertices_.push_back(index);
+    }
+  }
+}
+
+namespace {
+
+/// Transforms `count` <= vertex_batch_size unique vertices starting at
+/// `first` into the slots from `out_first`. Every loop runs over all lanes, so
+/// the compiler can keep a batch in SIMD registers.
+void transform_batch(const beyond::Mat4& mvp, std::span<const Vertex> vertices,
+                     std::span<const std::uint32_t> unique_vertices,
+                     std::size_t first, std::size_t count,
+                     const Rect& viewport, GuardBand band,
+                     PostTransformVertices& out, std::size_t out_first)
+{
+  constexpr std::size_t lanes = vertex_batch_size;
+  using Lanes = std::array<float, lanes>;
+
+  Lanes px{}, py{}, pz{};
+  for (std::size_t i = 0; i < count; ++i) {
+    const beyond::Point3& pos = vertices[unique_vertices[first + i]].pos;
+    px[i] = pos.x;
+    py[i] = pos.y;
+    pz[i] = pos.z;
+  }
+
+  const auto row = [&](int r, Lanes& result) {
+    const float m0 = mvp(r, 0);
+    const float m1 = mvp(r, 1);
+    const float m2 = mvp(r, 2);
+    const float m3 = mvp(r, 3);
+    for (std::size_t i = 0; i < lanes; ++i) {
+      result[i] = m0 * px[i] + m1 * py[i] + m2 * pz[i] + m3;
+    }
+  };
+  Lanes clip_x, clip_y, clip_z, clip_w;
+  row(0, clip_x);
+  row(1, clip_y);
+  row(2, clip_z);
+  row(3, clip_w);
+
+  Lanes screen_x, screen_y, screen_z, inv_w;
+  std::array<std::uint8_t, lanes> flags{};
+  for (std::size_t i = 0; i < lanes; ++i) {
+    const ScreenVertex screen =
+        to_screen(clip_x[i], clip_y[i], clip_z[i], clip_w[i], viewport);
+    screen_x[i] = screen.pos.x;
+    screen_y[i] = screen.pos.y;
+    screen_z[i] = screen.pos.z;
+    inv_w[i] = screen.inv_w;
+    flags[i] = clip_flags(clip_x[i], clip_y[i], clip_z[i], clip_w[i], band);
+  }
+
+  const auto offset = static_cast<std::ptrdiff_t>(out_first);
+  std::copy_n(screen_x.begin(), count, out.x.begin() + offset);
+  std::copy_n(screen_y.begin(), count, out.y.begin() + offset);
+  std::copy_n(screen_z.begin(), count, out.z.begin() + offset);
+  std::copy_n(inv_w.begin(), count, out.inv_w.begin() + offset);
+  std::copy_n(flags.begin(), count, out.clip_flags.begin() + offset);
+}
+
+} // anonymous namespace
+
+auto bounding_sphere(std::span<const Vertex> vertices,
+                     std::span<const std::uint32_t> unique_vertices) noexcept
+    -> BoundingSphere
+{
+  if (unique_vertices.empty()) { return BoundingSphere{}; }
+
+  beyond::Point3 min = vertices[unique_vertices[0]].pos;
+  beyond::Point3 max = min;
+  for (const std::uint32_t index : unique_vertices) {
+    const beyond::Point3& pos = vertices[index].pos;
+    min = {std::min(min.x, pos.x), std::min(min.y, pos.y),
+           std::min(min.z, pos.z)};
+    max = {std::max(max.x, pos.x), std::max(max.y, pos.y),
+           std::max(max.z, pos.z)};
+  }
+
+  const beyond::Vec3 center{(min.x + max.x) / 2, (min.y + max.y) / 2,
+                            (min.z + max.z) / 2};
+  float radius_squared = 0;
+  for (const std::uint32_t index : unique_vertices) {
+    const beyond::Point3& pos = vertices[index].pos;
+    const float dx = pos.x - center.x;
+    const float dy = pos.y - center.y;
+    const float dz = pos.z - center.z;
+    radius_squared = std::max(radius_squared, dx * dx + dy * dy + dz * dz);
+  }
+  return BoundingSphere{.center = center, .radius = std::sqrt(radius_squared)};
+}
+
+auto wireframe_indices(std::span<const std::uint32_t> indices)
+    -> std::vector<std::uint32_t>
+{
+  // Both ends in one key, the smaller index first
+  std::vector<std::uint64_t> edges;
+  edges.reserve(indices.size());
+  for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+    for (std::size_t j = 0; j < 3; ++j) {
+      const std::uint32_t a = indices[i + j];
+      const std::uint32_t b = indices[i + (j + 1) % 3];
+      edges.push_back(std::uint64_t{std::min(a, b)} << 32 | std::max(a, b));
+    }
+  }
+  std::ranges::sort(edges);
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  std::vector<std::uint32_t> lines;
+  lines.reserve(2 * edges.size());
+  for (const std::uint64_t edge : edges) {
+    lines.push_back(static_cast<std::uint32_t>(edge >> 32));
+    lines.push_back(static_cast<std::uint32_t>(edge));
+  }
+  return lines;
+}
+
+void transform_vertices(std::span<const beyond::Mat4> instance_mvps,
+                        std::span<const Vertex> vertices,
+                        std::span<const std::uint32_t> unique_vertices,
+                        const Rect& viewport, PostTransformVertices& out,
+                        std::size_t first_slot, ThreadPool& thread_pool)
+{
+  const std::size_t unique_count = unique_vertices.size();
+  const std::size_t total = instance_mvps.size() * unique_count;
+  BEYOND_ASSERT(out.x.size() >= first_slot + total);
+  const GuardBand band = guard_band(viewport);
+
+  // Tasks cover a range of (instance, vertex) pairs, split into batches at
+  // the end of every instance
+  constexpr std::size_t batches_per_task = 128;
+  constexpr std::size_t vertices_per_task =
+      batches_per_task * vertex_batch_size;
+  thread_pool.parallel_for(
+      (total + vertices_per_task - 1) / vertices_per_task,
+      [&](std::size_t task) {
+        const std::size_t last = std::min((task + 1) * vertices_per_task,
+                                          total);
+        for (std::size_t item = task * vertices_per_task; item < last;) {
+          const std::size_t instance = item / unique_count;
+          const std::size_t first = item % unique_count;
+          const std::size_t count = std::min(
+              {vertex_batch_size, last - item, unique_count - first});
+          transform_batch(instance_mvps[instance], vertices, unique_vertices,
+                          first, count, viewport, band, out,
+                          first_slot + item);
+          item += count;
+        }
+      });
+}
+
+} // namespace yasr
@@ -0,0 +1,114 @@
+#ifndef YASR_VERTEX_PROCESSING_HPP
+#define YASR_VERTEX_PROCESSING_HPP
+
+#include "clipping.hpp"
+#include "rasterizer.hpp"
+#include "yasr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <beyond/math/matrix.hpp>
+
+namespace yasr {
+
+class ThreadPool;
+
+/// Number of vertices transformed together, one per SIMD lane
+constexpr std::size_t vertex_batch_size = 8;
+
+/**
+ * \brief Positions after the vertex stage, stored as a structure of arrays
+ *
+ * Entry i holds the screen-space position and 1/w of cache slot i.
+ */
+struct PostTransformVertices {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> inv_w;
+  /// Planes each vertex lies outside of, see clip_flags()
+  std::vector<std::uint8_t> clip_flags;
+
+  void resize(std::size_t count);
+};
+
+/**
+ * \brief Post-transform vertex cache of one draw
+ *
+ * Gives every vertex referenced by the index buffer a slot, so each vertex is
+ * transformed once per draw however many triangles share it.
+ */
+class VertexCache {
+public:
+  static constexpr std::uint32_t invalid_slot =
+      std::numeric_limits<std::uint32_t>::max();
+
+  /// Assigns slots in order of first use to the vertices that `indices`
+  /// references, out of a buffer of `vertex_count` vertices
+  void build(std::span<const std::uint32_t> indices, std::size_t vertex_count);
+
+  [[nodiscard]] auto slot(std::uint32_t index) const noexcept -> std::uint32_t
+  {
+    return slots_[index];
+  }
+
+  /// The vertex index of every slot
+  [[nodiscard]] auto unique_vertices() const noexcept
+      -> std::span<const std::uint32_t>
+  {
+    return unique_vertices_;
+  }
+
+private:
+  std::vector<std::uint32_t> slots_;
+  std::vector<std::uint32_t> unique_vertices_;
+};
+
+/// The bounding sphere of the vertices of `unique_vertices`
+[[nodiscard]] auto bounding_sphere(std::span<const Vertex> vertices,
+                                   std::span<const std::uint32_t>
+                                       unique_vertices) noexcept
+    -> BoundingSphere;
+
+/// The distinct edges of the triangles of `indices` as Topology::lines
+/// indices, each edge once whichever triangles share it
+[[nodiscard]] auto wireframe_indices(std::span<const std::uint32_t> indices)
+    -> std::vector<std::uint32_t>;
+
+/**
+ * \brief Transforms the unique vertices of the instances of a draw to screen
+ * space
+ *
+ * Instance k is transformed by instance_mvps[k] into the slots from
+ * first_slot + k * unique_vertices.size() of `out`, which must hold them.
+ * Vertices are gathered into batches of vertex_batch_size lanes that are
+ * transformed, classified against the frustum and the guard band of
+ * `viewport`, divided by w and mapped to `viewport` together. Small meshes
+ * share a task between several instances.
+ */
+void transform_vertices(std::span<const beyond::Mat4> instance_mvps,
+                        std::span<const Vertex> vertices,
+                        std::span<const std::uint32_t> unique_vertices,
+                        const Rect& viewport, PostTransformVertices& out,
+                        std::size_t first_slot, ThreadPool& thread_pool);
+
+/// Transforms the unique vertices of a single instance by `mvp` into the
+/// first slots of `out`
+inline void transform_vertices(const beyond::Mat4& mvp,
+                               std::span<const Vertex> vertices,
+                               std::span<const std::uint32_t> unique_vertices,
+                               const Rect& viewport, PostTransformVertices& out,
+                               ThreadPool& thread_pool)
+{
+  out.resize(unique_vertices.size());
+  transform_vertices(std::span{&mvp, 1}, vertices, unique_vertices, viewport,
+                     out, 0, thread_pool);
+}
+
+} // namespace yasr
+
+#endif // YASR_VERTEX_PROCESSING_HPP
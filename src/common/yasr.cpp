@@ -1,246 +1,1241 @@
 #include "yasr.hpp"
+#include "buffer_allocator.hpp"
+#include "clipping.hpp"
+#include "deferred.hpp"
+#include "framebuffer.hpp"
+#include "pipeline.hpp"
+#include "rasterizer.hpp"
+#include "slot_map.hpp"
+#include "submission_queue.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+#include "vertex_processing.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <variant>
 
-#include <beyond/math/transform.hpp>
 #include <beyond/math/vector.hpp>
 #include <beyond/utils/conversion.hpp>
 
-#include <stb_image.h>
+namespace yasr {
+
+struct BufferStorage {
+  /// The block of the buffer allocator, empty for external memory
+  std::span<std::byte> block;
+  std::span<const std::byte> data;
+};
 
-namespace {
+/// The bindings and states of the bind and set calls. The immediate calls and
+/// every submission have their own.
+struct BindState {
+  command::BindVertexBuffer vertex_buffer;
+  command::BindIndexBuffer index_buffer;
+  Buffer constant_buffer;
+  Buffer instance_buffer;
+  Texture texture;
+  Framebuffer framebuffer;
+  Pipeline pipeline;
+  TextureFilter texture_filter = TextureFilter::trilinear;
+  CullMode cull_mode = CullMode::back;
+  ShadingMode shading_mode = ShadingMode::immediate;
+  Topology topology = Topology::triangles;
+  LineStyle line_style;
+  Camera camera;
+  Region viewport;
+  Region scissor;
+};
 
-[[maybe_unused]] auto line(beyond::IPoint2 p0, beyond::IPoint2 p1, Image& image,
-                           const RGB& color) -> void
+template <typename... Visitors> struct Overloaded : Visitors... {
+  using Visitors::operator()...;
+};
+
+/// `direction` transformed by the linear part of `transform`
+[[nodiscard]] auto transform_direction(const beyond::Mat4& transform,
+                                       const beyond::Vec3& direction) noexcept
+    -> beyond::Vec3
 {
-  using beyond::to_f32;
-  using beyond::to_i32;
-
-  bool steep = false;
-  if (std::abs(p0.x - p1.x) <
-      std::abs(p0.y - p1.y)) { // if the line is steep, we transpose the image
-    p0.xy = p0.yx;
-    p1.xy = p1.yx;
-    steep = true;
-  }
-  if (p0.x > p1.x) { // make it left−to−right
-    std::swap(p0, p1);
-  }
-  for (int x = p0.x; x <= p1.x; x++) {
-    const auto t = to_f32(x - p0.x) / to_f32(p1.x - p0.x);
-    const auto y = to_i32(std::round(p0.y * (1.f - t) + p1.y * t));
-    if (steep) {
-      if (y >= 0 && y < image.width() && x >= 0 && x < image.height()) {
-        image.unsafe_at(y, x) = color; // if transposed, de−transpose
-      }
-    } else {
-      if (x >= 0 && x < image.width() && y >= 0 && y < image.height()) {
-        image.unsafe_at(x, y) = color;
-      }
-    }
-  }
+  const auto row = [&](int r) {
+    return transform(r, 0) * direction.x + transform(r, 1) * direction.y +
+           transform(r, 2) * direction.z;
+  };
+  return beyond::Vec3{row(0), row(1), row(2)};
 }
 
-constexpr auto normalized_to_screen(const beyond::Vec3& pt)
+/// The direction towards the directional light of the built-in shading, in
+/// world space
+[[nodiscard]] auto sun_direction() noexcept -> beyond::Vec3
 {
-  return beyond::Point3{(pt.x + 1.f) * width / 2,
-                        height - (pt.y + 1.f) * height / 2, -pt.z};
+  return beyond::normalize(beyond::Vec3{0, 1, 5});
 }
 
-[[nodiscard]] auto barycentric(beyond::IPoint2 a, beyond::IPoint2 b,
-                               beyond::IPoint2 c, beyond::IPoint2 p)
-    -> beyond::Vec3
+/// The number of indices that form a primitive of `topology`
+[[nodiscard]] constexpr auto indices_per_primitive(Topology topology) noexcept
+    -> std::size_t
 {
-  const auto u = cross(beyond::Vec3(c.x - a.x, b.x - a.x, a.x - p.x),
-                       beyond::Vec3(c.y - a.y, b.y - a.y, a.y - p.y));
-  // Returns negative values for degenerated triangle
-  if (std::abs(u.z) < 1e-2) {
-    return beyond::Vec3(-1, 1, 1);
+  switch (topology) {
+  case Topology::triangles: return 3;
+  case Topology::lines: return 2;
+  case Topology::points: return 1;
   }
-  return beyond::Vec3(1.f - (u.x + u.y) / u.z, u.y / u.z, u.x / u.z);
+  return 1;
 }
 
-[[nodiscard]] auto barycentric_interpolate(beyond::Vec3 coord, float a, float b,
-                                           float c)
+/// The vertices, indices and instance transforms bound for a draw
+struct DrawBuffers {
+  std::span<const Vertex> vertices;
+  std::span<const std::uint32_t> indices;
+  /// Empty without an instance buffer
+  std::span<const beyond::Mat4> instance_transforms;
+};
+
+/// The pixels of `region` in `framebuffer`, all of them for a region with no
+/// area
+[[nodiscard]] auto region_rect(const Region& region,
+                               const FramebufferStorage& framebuffer) noexcept
+    -> Rect
 {
-  return coord.x * a + coord.y * b + coord.z * c;
+  if (region.width == 0 || region.height == 0) {
+    return Rect{{0, 0}, {framebuffer.width(), framebuffer.height()}};
+  }
+  return Rect{{region.x, region.y},
+              {region.x + static_cast<int>(region.width),
+               region.y + static_cast<int>(region.height)}};
 }
 
-void triangle(const std::array<beyond::Point3, 3>& pts,
-              const std::array<beyond::Vec2, 3>& uvs,
-              std::vector<float>& depth_buffer, Image& image,
-              const float* diffuse_texture, int diffuse_texture_width,
-              int diffuse_texture_height, int diffuse_texture_channels,
-              const RGB color)
-{
-  using beyond::to_f32;
-  using beyond::to_i32;
+struct CPUDevice : Device {
+  // Resources stay in place in their slot maps while the device creates
+  // more. The mutex guards the tables against a submission running
+  // concurrently.
+  std::mutex resource_mutex;
+  BufferAllocator buffer_allocator;
+  SlotMap<BufferStorage> buffers;
+  SlotMap<TextureStorage> textures;
+  SlotMap<FramebufferStorage> framebuffers;
+  /// Pipeline{} stands for the built-in shading and has no slot
+  SlotMap<std::unique_ptr<PipelineProgram>> pipelines;
 
-  const float diffuse_texture_width_f = to_f32(diffuse_texture_width);
-  const float diffuse_texture_height_f = to_f32(diffuse_texture_height);
+  BindState immediate_state;
 
-  const beyond::IVec2 bbox_upper_bound{image.width() - 1, image.height() - 1};
-  beyond::IVec2 bboxmin{bbox_upper_bound};
-  beyond::IVec2 bboxmax{0, 0};
-  for (int i = 0; i < 3; ++i) {
-    for (int j = 0; j < 2; ++j) {
-      bboxmin[j] = std::clamp(bboxmin[j], 0, to_i32(pts[i][j]));
-      bboxmax[j] =
-          std::clamp(bboxmax[j], to_i32(pts[i][j]), bbox_upper_bound[j]);
+  ThreadPool thread_pool;
+  /// The draws of one draw call, a multi-draw has several. Their instances
+  /// share the vertex cache of the draw.
+  struct DrawGroup {
+    std::span<const std::uint32_t> indices;
+    /// The vertex buffer from the vertex offset of the draw
+    std::span<const Vertex> vertices;
+    VertexCache* vertex_cache = nullptr;
+    /// The instances that passed culling by bounding sphere, in
+    /// draw_instances
+    std::size_t first_instance = 0;
+    std::size_t instance_count = 0;
+  };
+  /// An instance of a draw group, which owns a range of the post-transform
+  /// vertices and of the triangles of the draw call
+  struct DrawInstance {
+    beyond::Mat4 model;
+    beyond::Mat4 mvp;
+    std::size_t group = 0;
+    std::size_t first_slot = 0;
+    std::size_t first_triangle = 0;
+    std::size_t triangle_count = 0;
+    /// Every vertex lies outside one plane of the view frustum
+    bool culled = false;
+  };
+  std::vector<VertexCache> vertex_caches;
+  std::vector<DrawGroup> draw_groups;
+  std::vector<DrawInstance> draw_instances;
+  /// Model or model-view-projection transforms of the instances of a group
+  std::vector<beyond::Mat4> instance_matrices;
+  std::vector<DrawIndexedIndirectCommand> indirect_commands;
+  PostTransformVertices post_transform_vertices;
+  /// Triangles set up by one task, in submission order. Clipping can turn a
+  /// triangle into several.
+  struct SetupBatch {
+    std::vector<TriangleSetup> primitives;
+    PipelineStats stats;
+  };
+  std::vector<SetupBatch> setup_batches;
+  std::vector<std::vector<const TriangleSetup*>> tile_bins;
+  std::vector<PipelineStats> tile_stats;
+  /// The visibility buffer of the framebuffer of a draw with
+  /// ShadingMode::visibility_buffer, which every draw leaves at no_triangle
+  std::vector<std::uint32_t> visibility;
+  /// The point lights of a lighting pass that reach the viewport, and the
+  /// ones whose bounds overlap each tile
+  std::vector<ViewLight> view_lights;
+  std::vector<std::vector<const ViewLight*>> light_bins;
+  mutable std::mutex stats_mutex;
+  PipelineStats frame_stats;
+  Profiler frame_profiler;
+
+  // Declared last, so it finishes the pending submissions before the state
+  // they use is destroyed
+  SubmissionQueue submissions{[this](const CommandBuffer& commands) {
+    BindState state;
+    for (const Command& command : commands.commands()) {
+      execute(state, command, commands.data());
     }
+  }};
+
+  explicit CPUDevice(std::uint32_t thread_count) : thread_pool{thread_count}
+  {
   }
 
-  const auto to_int_xy = [](beyond::Point3 pt) {
-    return beyond::IPoint2{to_i32(pt.x), to_i32(pt.y)};
-  };
+  auto create_buffer(BufferDesc desc) -> Buffer override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    if (desc.memory == BufferMemory::external) {
+      return Buffer{.id = buffers.emplace(
+                        BufferStorage{.block = {}, .data = desc.data})};
+    }
+    const std::span<std::byte> block =
+        buffer_allocator.allocate(std::max(desc.size, desc.data.size()));
+    // Pooled blocks keep the bytes of their last buffer
+    const auto tail = std::ranges::copy(desc.data, block.begin()).out;
+    std::fill(tail, block.end(), std::byte{0});
+    return Buffer{
+        .id = buffers.emplace(BufferStorage{.block = block, .data = block})};
+  }
 
-  for (int x = bboxmin.x; x < bboxmax.x; ++x) {
-    for (int y = bboxmin.y; y < bboxmax.y; ++y) {
-      if (x >= image.width() || x < 0 || y >= image.height() || y < 0) {
-        continue;
-      }
+  void destroy_buffer(Buffer buffer) override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    const std::optional<BufferStorage> storage = buffers.erase(buffer.id);
+    BEYOND_ASSERT(storage.has_value());
+    if (storage) { buffer_allocator.deallocate(storage->block); }
+  }
 
-      const auto index = y * image.width() + x;
-
-      const beyond::Vec3 bc_screen = barycentric(
-          to_int_xy(pts[0]), to_int_xy(pts[1]), to_int_xy(pts[2]), {x, y});
-      if (bc_screen.x < 0 || bc_screen.y < 0 || bc_screen.z < 0)
-        continue;
-
-      const auto u =
-          barycentric_interpolate(bc_screen, uvs[0].x, uvs[1].x, uvs[2].x);
-      const auto v =
-          barycentric_interpolate(bc_screen, uvs[0].y, uvs[1].y, uvs[2].y);
-      const auto z =
-          barycentric_interpolate(bc_screen, pts[0].z, pts[1].z, pts[2].z);
-
-      if (depth_buffer[index] < z) {
-        depth_buffer[index] = z;
-        const int texture_x = std::max(u * diffuse_texture_width_f, 0.f);
-        const int texture_y = diffuse_texture_height_f -
-                              std::max(v * diffuse_texture_height_f, 0.f);
-        const float* target_pixels =
-            diffuse_texture + (texture_y * diffuse_texture_width + texture_x) *
-                                  diffuse_texture_channels;
-        RGB final_color{
-            color.r * target_pixels[0],
-            color.g * target_pixels[1],
-            color.b * target_pixels[2],
-        };
+  void update_buffer(Buffer buffer, std::size_t offset,
+                     std::span<const std::byte> data) override
+  {
+    submissions.wait_idle();
+    execute(immediate_state,
+            command::UpdateBuffer{.buffer = buffer,
+                                  .offset = offset,
+                                  .data_offset = 0,
+                                  .size = data.size()},
+            data);
+  }
 
-        // Gamma correction
-        final_color.r = std::pow(final_color.r, 1 / 2.2);
-        final_color.g = std::pow(final_color.g, 1 / 2.2);
-        final_color.b = std::pow(final_color.b, 1 / 2.2);
-        image.unsafe_at(x, y) = final_color;
-      }
-    }
+  auto map_buffer(Buffer buffer) -> std::span<std::byte> override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    return device_memory(buffer);
   }
-}
-} // anonymous namespace
 
-namespace yasr {
+  auto create_texture(TextureDesc desc) -> Texture override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    return Texture{.id = textures.emplace(desc)};
+  }
 
-using BufferData = std::vector<std::byte>;
+  void destroy_texture(Texture texture) override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    [[maybe_unused]] const bool erased =
+        textures.erase(texture.id).has_value();
+    BEYOND_ASSERT(erased);
+  }
 
-struct CPUDevice : Device {
-  std::vector<BufferData> buffers;
-  std::uint64_t current_vertex_buffer_index = 1;
-  std::uint64_t current_index_buffer_index = 2;
+  auto create_framebuffer(FramebufferDesc desc) -> Framebuffer override
+  {
+    const std::scoped_lock lock{resource_mutex};
+    BEYOND_ASSERT(desc.sample_count == 1 ||
+                  desc.sample_count == msaa_sample_count);
+    BEYOND_ASSERT(!desc.g_buffer || desc.sample_count == 1);
+    return Framebuffer{.id = framebuffers.emplace(
+                           static_cast<int>(desc.width),
+                           static_cast<int>(desc.height), desc.format,
+                           static_cast<int>(desc.sample_count),
+                           desc.g_buffer)};
+  }
 
-  auto create_buffer(BufferDesc desc) -> Buffer override
+  void destroy_framebuffer(Framebuffer framebuffer) override
   {
-    buffers.emplace_back(desc.data.begin(), desc.data.end());
-    return Buffer{.id = buffers.size() - 1};
+    const std::scoped_lock lock{resource_mutex};
+    [[maybe_unused]] const bool erased =
+        framebuffers.erase(framebuffer.id).has_value();
+    BEYOND_ASSERT(erased);
   }
 
-  void destroy_buffer(Buffer buffer) override
+  auto create_pipeline(std::unique_ptr<PipelineProgram> program)
+      -> Pipeline override
   {
-    buffers[buffer.id].clear();
+    BEYOND_ASSERT(program != nullptr);
+    const std::scoped_lock lock{resource_mutex};
+    return Pipeline{.id = pipelines.emplace(std::move(program))};
   }
 
-  void bind_vertex_buffer(Buffer vertex_buffer) override
+  void destroy_pipeline(Pipeline pipeline) override
   {
-    BEYOND_ASSERT(!buffers[current_vertex_buffer_index].empty());
-    current_vertex_buffer_index = vertex_buffer.id;
+    const std::scoped_lock lock{resource_mutex};
+    [[maybe_unused]] const bool erased =
+        pipelines.erase(pipeline.id).has_value();
+    BEYOND_ASSERT(erased);
   }
-  void bind_index_buffer(Buffer index_buffer) override
+
+  auto framebuffer_storage(Framebuffer framebuffer) -> FramebufferStorage&
+  {
+    const std::scoped_lock lock{resource_mutex};
+    return framebuffers[framebuffer.id];
+  }
+
+  /// The bytes of a valid buffer, call with the resource lock held
+  auto buffer_data(Buffer buffer) -> std::span<const std::byte>
+  {
+    return buffers[buffer.id].data;
+  }
+
+  /// The bytes of a bound range of a buffer, call with the resource lock held
+  auto buffer_range(Buffer buffer, std::size_t offset, std::size_t size)
+      -> std::span<const std::byte>
+  {
+    const std::span<const std::byte> data = buffer_data(buffer);
+    BEYOND_ASSERT(offset <= data.size());
+    BEYOND_ASSERT(size == whole_size || size <= data.size() - offset);
+    return data.subspan(offset, size);
+  }
+
+  /// The writable bytes of a valid buffer of device memory, call with the
+  /// resource lock held
+  auto device_memory(Buffer buffer) -> std::span<std::byte>
+  {
+    const BufferStorage& storage = buffers[buffer.id];
+    BEYOND_ASSERT(storage.block.size() == storage.data.size());
+    return storage.block;
+  }
+
+  auto framebuffer_image(Framebuffer framebuffer) -> const Image& override
+  {
+    auto& storage = framebuffer_storage(framebuffer);
+    const ScopedTimer timer{frame_profiler, PipelineStage::resolve};
+    storage.resolve_color();
+    return storage.color();
+  }
+
+  auto framebuffer_color(Framebuffer framebuffer) -> ColorView override
+  {
+    auto& storage = framebuffer_storage(framebuffer);
+    const ScopedTimer timer{frame_profiler, PipelineStage::resolve};
+    storage.resolve_color();
+    return storage.color_view();
+  }
+
+  void bind_framebuffer(Framebuffer framebuffer) override
+  {
+    execute(immediate_state, command::BindFramebuffer{framebuffer});
+  }
+  void bind_vertex_buffer(Buffer vertex_buffer, std::size_t offset,
+                          std::size_t size) override
+  {
+    execute(immediate_state,
+            command::BindVertexBuffer{vertex_buffer, offset, size});
+  }
+  void bind_index_buffer(Buffer index_buffer, std::size_t offset,
+                         std::size_t size) override
+  {
+    execute(immediate_state,
+            command::BindIndexBuffer{index_buffer, offset, size});
+  }
+  void bind_texture(Texture texture) override
+  {
+    execute(immediate_state, command::BindTexture{texture});
+  }
+  void bind_constant_buffer(Buffer constant_buffer) override
+  {
+    execute(immediate_state, command::BindConstantBuffer{constant_buffer});
+  }
+  void bind_instance_buffer(Buffer instance_buffer) override
+  {
+    execute(immediate_state, command::BindInstanceBuffer{instance_buffer});
+  }
+  void bind_pipeline(Pipeline pipeline) override
+  {
+    execute(immediate_state, command::BindPipeline{pipeline});
+  }
+  void set_texture_filter(TextureFilter filter) override
+  {
+    execute(immediate_state, command::SetTextureFilter{filter});
+  }
+  void set_cull_mode(CullMode mode) override
+  {
+    execute(immediate_state, command::SetCullMode{mode});
+  }
+  void set_shading_mode(ShadingMode mode) override
+  {
+    execute(immediate_state, command::SetShadingMode{mode});
+  }
+  void set_topology(Topology topology) override
+  {
+    execute(immediate_state, command::SetTopology{topology});
+  }
+  void set_line_style(const LineStyle& style) override
+  {
+    execute(immediate_state, command::SetLineStyle{style});
+  }
+  void set_camera(const Camera& camera) override
+  {
+    execute(immediate_state, command::SetCamera{camera});
+  }
+  void set_viewport(const Region& viewport) override
+  {
+    execute(immediate_state, command::SetViewport{viewport});
+  }
+  void set_scissor(const Region& scissor) override
+  {
+    execute(immediate_state, command::SetScissor{scissor});
+  }
+
+  void clear(const ClearValue& value) override
+  {
+    submissions.wait_idle();
+    execute(immediate_state, command::Clear{value});
+  }
+
+  void draw_indexed() override
   {
-    BEYOND_ASSERT(!buffers[current_index_buffer_index].empty());
-    current_index_buffer_index = index_buffer.id;
+    submissions.wait_idle();
+    execute(immediate_state, command::DrawIndexed{});
   }
 
-  void draw_indexed(Image& image, std::vector<float> depth_buffer) override
+  void draw_indexed_instanced(std::uint32_t instance_count) override
+  {
+    submissions.wait_idle();
+    execute(immediate_state, command::DrawIndexedInstanced{instance_count});
+  }
+
+  void draw_indexed_indirect(Buffer argument_buffer,
+                             std::uint32_t draw_count) override
+  {
+    submissions.wait_idle();
+    execute(immediate_state,
+            command::DrawIndexedIndirect{argument_buffer, draw_count});
+  }
+
+  void shade_lights(Buffer light_buffer, std::uint32_t light_count) override
+  {
+    submissions.wait_idle();
+    execute(immediate_state, command::ShadeLights{light_buffer, light_count});
+  }
+
+  auto submit(CommandBuffer&& commands) -> Fence override
+  {
+    return Fence{.id = submissions.submit(std::move(commands))};
+  }
+
+  auto acquire_command_buffer() -> CommandBuffer override
+  {
+    return submissions.acquire();
+  }
+
+  auto is_signaled(Fence fence) const -> bool override
+  {
+    return submissions.is_signaled(fence.id);
+  }
+
+  void wait(Fence fence) override
+  {
+    submissions.wait(fence.id);
+  }
+
+  /// Applies a bind or a state change to `state`, or runs a clear, a draw or
+  /// a buffer update with it. Buffer updates read their bytes from `data`.
+  void execute(BindState& state, const Command& command,
+               std::span<const std::byte> data = {})
+  {
+    std::visit(
+        Overloaded{
+            [&](const command::BindFramebuffer& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(framebuffers.contains(bind.framebuffer.id));
+              state.framebuffer = bind.framebuffer;
+            },
+            [&](const command::BindVertexBuffer& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(buffers.contains(bind.buffer.id));
+              BEYOND_ASSERT(bind.offset % alignof(Vertex) == 0);
+              state.vertex_buffer = bind;
+            },
+            [&](const command::BindIndexBuffer& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(buffers.contains(bind.buffer.id));
+              BEYOND_ASSERT(bind.offset % alignof(std::uint32_t) == 0);
+              state.index_buffer = bind;
+            },
+            [&](const command::BindTexture& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(textures.contains(bind.texture.id));
+              state.texture = bind.texture;
+            },
+            [&](const command::BindConstantBuffer& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(buffers.contains(bind.buffer.id));
+              state.constant_buffer = bind.buffer;
+            },
+            [&](const command::BindInstanceBuffer& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(bind.buffer.id == 0 ||
+                            buffers.contains(bind.buffer.id));
+              state.instance_buffer = bind.buffer;
+            },
+            [&](const command::BindPipeline& bind) {
+              const std::scoped_lock lock{resource_mutex};
+              BEYOND_ASSERT(bind.pipeline.id == 0 ||
+                            pipelines.contains(bind.pipeline.id));
+              state.pipeline = bind.pipeline;
+            },
+            [&](const command::SetTextureFilter& set) {
+              state.texture_filter = set.filter;
+            },
+            [&](const command::SetCullMode& set) {
+              state.cull_mode = set.mode;
+            },
+            [&](const command::SetShadingMode& set) {
+              state.shading_mode = set.mode;
+            },
+            [&](const command::SetTopology& set) {
+              state.topology = set.topology;
+            },
+            [&](const command::SetLineStyle& set) {
+              state.line_style = set.style;
+            },
+            [&](const command::SetCamera& set) { state.camera = set.camera; },
+            [&](const command::SetViewport& set) {
+              state.viewport = set.viewport;
+            },
+            [&](const command::SetScissor& set) {
+              state.scissor = set.scissor;
+            },
+            [&](const command::Clear& clear) {
+              FramebufferStorage& framebuffer =
+                  framebuffer_storage(state.framebuffer);
+              framebuffer.clear(clear.value);
+            },
+            [&](const command::DrawIndexed&) { draw_all_indices(state, 1); },
+            [&](const command::DrawIndexedInstanced& instanced) {
+              draw_all_indices(state, instanced.instance_count);
+            },
+            [&](const command::DrawIndexedIndirect& indirect) {
+              // Copied, so the draws stay valid if the argument buffer is
+              // destroyed meanwhile
+              std::unique_lock lock{resource_mutex};
+              const std::span<const std::byte> arguments =
+                  buffer_data(indirect.argument_buffer);
+              const std::size_t size =
+                  indirect.draw_count * sizeof(DrawIndexedIndirectCommand);
+              BEYOND_ASSERT(size <= arguments.size());
+              indirect_commands.resize(indirect.draw_count);
+              std::memcpy(indirect_commands.data(), arguments.data(), size);
+              lock.unlock();
+              draw(state, indirect_commands);
+            },
+            [&](const command::ShadeLights& shade) {
+              shade_lights(state, shade);
+            },
+            [&](const command::UpdateBuffer& update) {
+              BEYOND_ASSERT(update.data_offset + update.size <= data.size());
+              const std::scoped_lock lock{resource_mutex};
+              const std::span<std::byte> memory = device_memory(update.buffer);
+              BEYOND_ASSERT(update.offset + update.size <= memory.size());
+              std::ranges::copy(data.subspan(update.data_offset, update.size),
+                                memory.subspan(update.offset).begin());
+            },
+        },
+        command);
+  }
+
+  /// Draws the whole index buffer with the bindings and states of `state`
+  void draw_all_indices(const BindState& state, std::uint32_t instance_count)
+  {
+    std::size_t index_count = 0;
+    {
+      const std::scoped_lock lock{resource_mutex};
+      index_count =
+          buffer_range(state.index_buffer.buffer, state.index_buffer.offset,
+                       state.index_buffer.size)
+              .size() /
+          sizeof(std::uint32_t);
+    }
+    // A trailing partial primitive is ignored
+    index_count -= index_count % indices_per_primitive(state.topology);
+    const DrawIndexedIndirectCommand command{
+        .index_count = static_cast<std::uint32_t>(index_count),
+        .instance_count = instance_count,
+    };
+    draw(state, std::span{&command, 1});
+  }
+
+  /// The buffers bound in `state`, with the resource mutex held
+  auto draw_buffers(const BindState& state) -> DrawBuffers
   {
     using beyond::bit_cast;
+
+    const std::span<const std::byte> vertex_buffer =
+        buffer_range(state.vertex_buffer.buffer, state.vertex_buffer.offset,
+                     state.vertex_buffer.size);
+    const std::span<const std::byte> index_buffer =
+        buffer_range(state.index_buffer.buffer, state.index_buffer.offset,
+                     state.index_buffer.size);
+    DrawBuffers draw_buffers{
+        .vertices = {bit_cast<const Vertex*>(vertex_buffer.data()),
+                     vertex_buffer.size() / sizeof(Vertex)},
+        .indices = {bit_cast<const std::uint32_t*>(index_buffer.data()),
+                    index_buffer.size() / sizeof(std::uint32_t)},
+        .instance_transforms = {},
+    };
+    if (state.instance_buffer.id != 0) {
+      const std::span<const std::byte> instance_buffer =
+          buffer_data(state.instance_buffer);
+      draw_buffers.instance_transforms = {
+          bit_cast<const beyond::Mat4*>(instance_buffer.data()),
+          instance_buffer.size() / sizeof(beyond::Mat4)};
+    }
+    return draw_buffers;
+  }
+
+  /// Runs the draws of `commands` with the bindings and states of `state`,
+  /// with a single pass of binning and rasterization
+  void draw(const BindState& state,
+            std::span<const DrawIndexedIndirectCommand> commands)
+  {
+    using beyond::to_f32;
+
+    if (state.topology != Topology::triangles) {
+      draw_lines(state, commands);
+      return;
+    }
+
+    // Look up the bound resources, which stay in place once the lock is
+    // released
+    std::unique_lock resource_lock{resource_mutex};
+    const DrawBuffers bound = draw_buffers(state);
+    const std::span<const Vertex> vertices = bound.vertices;
+    const std::span<const std::uint32_t> indices = bound.indices;
+    const std::span<const beyond::Mat4> instance_transforms =
+        bound.instance_transforms;
+
+    const beyond::Vec3 light_dir = sun_direction();
+
+    // A null program selects the built-in shading, which needs a texture
+    PipelineProgram* const pipeline =
+        state.pipeline.id != 0 ? pipelines[state.pipeline.id].get() : nullptr;
+    const TextureStorage* const texture = textures.get(state.texture.id);
+    BEYOND_ASSERT(pipeline != nullptr || texture != nullptr);
+    const TextureView diffuse_texture =
+        texture != nullptr ? texture->view(state.texture_filter)
+                           : TextureView{};
+
+    FramebufferStorage& framebuffer = framebuffers[state.framebuffer.id];
+    const ColorTarget color_target = framebuffer.color_target();
+    std::vector<float>& depth_buffer = framebuffer.depth();
+    std::vector<float>& coarse_depth = framebuffer.coarse_depth();
+    // The G-buffer takes the albedo and normal of the built-in shading
+    const bool g_buffer = framebuffer.has_g_buffer();
+    BEYOND_ASSERT(!g_buffer || pipeline == nullptr);
+    const GBufferTarget g_buffer_target =
+        g_buffer ? framebuffer.g_buffer_target() : GBufferTarget{};
+    const bool visibility_buffer =
+        state.shading_mode == ShadingMode::visibility_buffer &&
+        framebuffer.sample_count() == 1 && !g_buffer;
+    VisibilityTarget visibility_target;
+    if (visibility_buffer) {
+      visibility.resize(static_cast<std::size_t>(framebuffer.width()) *
+                            static_cast<std::size_t>(framebuffer.height()),
+                        no_triangle);
+      visibility_target = {.width = framebuffer.width(),
+                           .height = framebuffer.height(),
+                           .triangle = visibility.data()};
+    }
+
+    std::span<const std::byte> constants;
+    if (pipeline != nullptr) {
+      constants = buffer_data(state.constant_buffer);
+    }
+    resource_lock.unlock();
+
+    // Vertices are placed in the viewport, and triangles only cover pixels of
+    // the scissor inside it
+    const Rect viewport = region_rect(state.viewport, framebuffer);
+    BEYOND_ASSERT(viewport.min.x >= 0 && viewport.min.y >= 0 &&
+                  viewport.max.x <= framebuffer.width() &&
+                  viewport.max.y <= framebuffer.height());
+    const Rect scissor =
+        intersect(viewport, region_rect(state.scissor, framebuffer));
+
+    const beyond::Mat4 view_proj = view_projection(
+        state.camera, to_f32(viewport.max.x - viewport.min.x) /
+                          to_f32(viewport.max.y - viewport.min.y));
+    // Normals of the G-buffer are in view space, where lighting happens
+    const beyond::Mat4 view =
+        g_buffer ? beyond::look_at(state.camera.eye, state.camera.target,
+                                   state.camera.up)
+                 : beyond::Mat4{};
+    PipelineStats draw_stats;
+
+    // Instance culling and vertex processing. The instances of a draw share
+    // its vertex cache and bounding sphere, and are transformed together.
+    std::size_t triangle_count = 0;
+    {
+      const ScopedTimer timer{frame_profiler, PipelineStage::vertex};
+      if (vertex_caches.size() < commands.size()) {
+        vertex_caches.resize(commands.size());
+      }
+      draw_groups.clear();
+      draw_instances.clear();
+      std::size_t slot_count = 0;
+      for (std::size_t d = 0; d < commands.size(); ++d) {
+        const DrawIndexedIndirectCommand& command = commands[d];
+        BEYOND_ASSERT(command.index_count % 3 == 0 &&
+                      std::size_t{command.first_index} + command.index_count <=
+                          indices.size());
+        BEYOND_ASSERT(command.vertex_offset >= 0 &&
+                      static_cast<std::size_t>(command.vertex_offset) <=
+                          vertices.size());
+        DrawGroup& group = draw_groups.emplace_back(DrawGroup{
+            .indices =
+                indices.subspan(command.first_index, command.index_count),
+            .vertices = vertices.subspan(
+                static_cast<std::size_t>(command.vertex_offset)),
+            .vertex_cache = &vertex_caches[d],
+            .first_instance = draw_instances.size(),
+        });
+        group.vertex_cache->build(group.indices, group.vertices.size());
+        const std::span<const std::uint32_t> unique_vertices =
+            group.vertex_cache->unique_vertices();
+        const std::size_t group_triangles = group.indices.size() / 3;
+        draw_stats.instances_submitted += command.instance_count;
+        draw_stats.triangles_submitted +=
+            std::uint64_t{command.instance_count} * group_triangles;
+
+        // Pipelines place their vertices themselves, their instances are
+        // culled by the clip flags of their vertices below
+        const BoundingSphere sphere =
+            pipeline == nullptr ? bounding_sphere(group.vertices,
+                                                  unique_vertices)
+                                : BoundingSphere{};
+        for (std::uint32_t i = 0; i < command.instance_count; ++i) {
+          const std::size_t instance = std::size_t{command.first_instance} + i;
+          BEYOND_ASSERT(instance_transforms.empty() ||
+                        instance < instance_transforms.size());
+          const beyond::Mat4 model = instance_transforms.empty()
+                                         ? beyond::Mat4::identity()
+                                         : instance_transforms[instance];
+          const beyond::Mat4 mvp = instance_transforms.empty()
+                                       ? view_proj
+                                       : view_proj * model;
+          if (pipeline == nullptr && outside_frustum(mvp, sphere)) {
+            ++draw_stats.instances_culled;
+            draw_stats.triangles_culled += group_triangles;
+            continue;
+          }
+          draw_instances.push_back(DrawInstance{
+              .model = model,
+              .mvp = mvp,
+              .group = d,
+              .first_slot = slot_count,
+              .first_triangle = triangle_count,
+              .triangle_count = group_triangles,
+          });
+          slot_count += unique_vertices.size();
+          triangle_count += group_triangles;
+        }
+        group.instance_count = draw_instances.size() - group.first_instance;
+      }
+
+      post_transform_vertices.resize(slot_count);
+      for (const DrawGroup& group : draw_groups) {
+        if (group.instance_count == 0) { continue; }
+        const std::span<const DrawInstance> instances{
+            draw_instances.data() + group.first_instance,
+            group.instance_count};
+        instance_matrices.clear();
+        for (const DrawInstance& instance : instances) {
+          instance_matrices.push_back(pipeline != nullptr ? instance.model
+                                                          : instance.mvp);
+        }
+        if (pipeline != nullptr) {
+          pipeline->shade_vertices(
+              DrawInputs{
+                  .vertices = group.vertices,
+                  .vertex_cache = *group.vertex_cache,
+                  .constants = constants,
+                  .texture = diffuse_texture,
+                  .viewport = viewport,
+                  .instance_transforms = instance_matrices,
+                  .first_slot = instances.front().first_slot,
+              },
+              post_transform_vertices, thread_pool);
+        } else {
+          transform_vertices(instance_matrices, group.vertices,
+                             group.vertex_cache->unique_vertices(), viewport,
+                             post_transform_vertices,
+                             instances.front().first_slot, thread_pool);
+        }
+        draw_stats.input_vertices += instances.size() * group.indices.size();
+        draw_stats.vertices_processed +=
+            instances.size() * group.vertex_cache->unique_vertices().size();
+      }
+
+      // Instances with every vertex outside one plane of the frustum
+      for (DrawInstance& instance : draw_instances) {
+        const std::size_t slot_end =
+            instance.first_slot +
+            draw_groups[instance.group].vertex_cache->unique_vertices().size();
+        std::uint8_t all_outside = clip_frustum;
+        for (std::size_t slot = instance.first_slot; slot < slot_end; ++slot) {
+          all_outside &= post_transform_vertices.clip_flags[slot];
+        }
+        if ((all_outside & clip_frustum) != 0 && instance.triangle_count > 0) {
+          instance.culled = true;
+          ++draw_stats.instances_culled;
+          draw_stats.triangles_culled += instance.triangle_count;
+        }
+      }
+    }
+    const auto& post = post_transform_vertices;
+
+    // Primitive assembly, clipping and triangle setup, split into batches of
+    // triangles that can span several instances
+    constexpr std::size_t triangles_per_batch = 256;
+    const GuardBand band = guard_band(viewport);
+    {
+      const ScopedTimer timer{frame_profiler, PipelineStage::setup};
+      setup_batches.resize((triangle_count + triangles_per_batch - 1) /
+                           triangles_per_batch);
+      if (pipeline != nullptr) { pipeline->begin_setup(setup_batches.size()); }
+      thread_pool.parallel_for(setup_batches.size(), [&](std::size_t batch) {
+        SetupBatch& output = setup_batches[batch];
+        output.primitives.clear();
+        output.stats = {};
+        const std::size_t first = batch * triangles_per_batch;
+        const std::size_t last =
+            std::min(first + triangles_per_batch, triangle_count);
+        // Instances are sorted by their first triangle
+        auto instance = std::prev(std::upper_bound(
+            draw_instances.begin(), draw_instances.end(), first,
+            [](std::size_t triangle, const DrawInstance& candidate) {
+              return triangle < candidate.first_triangle;
+            }));
+        for (std::size_t t = first; t < last; ++t) {
+          while (t >= instance->first_triangle + instance->triangle_count) {
+            ++instance;
+          }
+          if (instance->culled) { continue; }
+          const DrawGroup& group = draw_groups[instance->group];
+          const std::size_t local_triangle = t - instance->first_triangle;
+
+          std::array<std::uint32_t, 3> triangle;
+          AssembledTriangle assembled;
+          std::uint8_t any_outside = 0;
+          std::uint8_t all_outside = clip_frustum;
+          for (std::size_t j = 0; j < 3; ++j) {
+            triangle[j] = group.indices[3 * local_triangle + j];
+            assembled.slots[j] = static_cast<std::uint32_t>(
+                instance->first_slot +
+                group.vertex_cache->slot(triangle[j]));
+            const std::uint8_t flags = post.clip_flags[assembled.slots[j]];
+            any_outside |= flags;
+            all_outside &= flags;
+          }
+          // Entirely outside one plane of the view frustum
+          if ((all_outside & clip_frustum) != 0) {
+            ++output.stats.triangles_culled;
+            continue;
+          }
+
+          // The built-in shading lights every triangle by its face normal,
+          // turned by the model transform of the instance
+          const Vertex& v0 = group.vertices[triangle[0]];
+          const Vertex& v1 = group.vertices[triangle[1]];
+          const Vertex& v2 = group.vertices[triangle[2]];
+          RGB color;
+          std::uint32_t packed_normal = 0;
+          if (pipeline == nullptr) {
+            beyond::Vec3 edge0 = v1.pos - v0.pos;
+            beyond::Vec3 edge1 = v2.pos - v1.pos;
+            if (!instance_transforms.empty()) {
+              edge0 = transform_direction(instance->model, edge0);
+              edge1 = transform_direction(instance->model, edge1);
+            }
+            const auto normal = beyond::normalize(beyond::cross(edge0, edge1));
+            if (g_buffer) {
+              color = RGB(1, 1, 1);
+              packed_normal = pack_normal(
+                  beyond::normalize(transform_direction(view, normal)));
+            } else {
+              const float intensity =
+                  std::min(beyond::dot(normal, light_dir), 1.f);
+              color = RGB(intensity, intensity, intensity);
+            }
+          }
+
+          const std::size_t first_primitive = output.primitives.size();
+          const auto emit = [&] {
+            auto setup =
+                setup_triangle(assembled.screen, scissor, color,
+                               state.cull_mode);
+            if (!setup) { return; }
+            setup->normal = packed_normal;
+            if (pipeline != nullptr) {
+              setup->varyings =
+                  pipeline->triangle_varyings(batch, assembled, *setup);
+            }
+            output.primitives.push_back(*setup);
+          };
+
+          if ((any_outside & clip_needed) == 0) {
+            for (std::size_t j = 0; j < 3; ++j) {
+              const std::uint32_t slot = assembled.slots[j];
+              assembled.screen[j] = ScreenVertex{
+                  .pos = {post.x[slot], post.y[slot], post.z[slot]},
+                  .inv_w = post.inv_w[slot],
+                  .uv = pipeline == nullptr
+                            ? group.vertices[triangle[j]].texcoord
+                            : beyond::Vec2{},
+              };
+            }
+            emit();
+          } else {
+            ++output.stats.triangles_clipped;
+            const auto clip_position = [&](std::size_t j) {
+              return pipeline != nullptr
+                         ? pipeline->clip_position(assembled.slots[j])
+                         : transform_to_clip(instance->mvp,
+                                             group.vertices[triangle[j]].pos);
+            };
+            const ClipPolygon polygon = clip_triangle(
+                {clip_position(0), clip_position(1), clip_position(2)}, band);
+            const auto project = [&](const ClipVertex& vertex) {
+              ScreenVertex screen =
+                  to_screen(vertex.pos.x, vertex.pos.y, vertex.pos.z,
+                            vertex.pos.w, viewport);
+              screen.uv = {interpolate(v0.texcoord.x, v1.texcoord.x,
+                                       v2.texcoord.x, vertex.weights),
+                           interpolate(v0.texcoord.y, v1.texcoord.y,
+                                       v2.texcoord.y, vertex.weights)};
+              return screen;
+            };
+            assembled.clipped = true;
+            for (std::size_t i = 1; i + 1 < polygon.size; ++i) {
+              const std::array fan{&polygon.vertices[0], &polygon.vertices[i],
+                                   &polygon.vertices[i + 1]};
+              for (std::size_t j = 0; j < 3; ++j) {
+                assembled.screen[j] = project(*fan[j]);
+                assembled.weights[j] = fan[j]->weights;
+              }
+              emit();
+            }
+          }
+          if (output.primitives.size() == first_primitive) {
+            ++output.stats.triangles_culled;
+          }
+        }
+      });
+    }
+
+    // Binning. Triangles are appended in submission order, so every pixel
+    // sees the same sequence of depth tests as a single-threaded draw would.
+    const int tile_count_x = framebuffer.tile_count_x();
+    {
+      const ScopedTimer timer{frame_profiler, PipelineStage::binning};
+      tile_bins.resize(framebuffer.tile_count());
+      tile_stats.assign(framebuffer.tile_count(), PipelineStats{});
+      for (auto& bin : tile_bins) { bin.clear(); }
+
+      for (const SetupBatch& batch : setup_batches) {
+        draw_stats += batch.stats;
+        for (const TriangleSetup& primitive : batch.primitives) {
+          const Rect& bbox = primitive.bounds;
+          for (int tile_y = bbox.min.y / tile_size;
+               tile_y <= (bbox.max.y - 1) / tile_size; ++tile_y) {
+            for (int tile_x = bbox.min.x / tile_size;
+                 tile_x <= (bbox.max.x - 1) / tile_size; ++tile_x) {
+              tile_bins[static_cast<std::size_t>(tile_y * tile_count_x +
+                                                 tile_x)]
+                  .push_back(&primitive);
+            }
+          }
+        }
+      }
+    }
+
+    // Each tile owns a disjoint region of the image and depth buffer. Tiles
+    // that no triangle touches keep their clear pending.
+    {
+      const ScopedTimer timer{frame_profiler, PipelineStage::raster};
+      thread_pool.parallel_for(tile_bins.size(), [&](std::size_t tile_index) {
+        if (tile_bins[tile_index].empty()) { return; }
+        framebuffer.resolve_clear(tile_index);
+        const Rect tile = framebuffer.tile_rect(tile_index);
+        PipelineStats stats;
+        if (visibility_buffer) {
+          // Depth and the nearest triangle first, then every visible pixel
+          // is shaded once
+          const std::vector<const TriangleSetup*>& bin =
+              tile_bins[tile_index];
+          for (std::size_t i = 0; i < bin.size(); ++i) {
+            rasterize_triangle(*bin[i], static_cast<std::uint32_t>(i), tile,
+                               depth_buffer, coarse_depth, visibility_target,
+                               stats);
+          }
+          if (pipeline != nullptr) {
+            pipeline->shade_visible(bin, tile, visibility_target,
+                                    color_target, stats);
+          } else {
+            shade_visible(bin, tile, visibility_target, color_target,
+                          diffuse_texture, stats);
+          }
+        } else if (framebuffer.sample_count() == 1) {
+          for (const TriangleSetup* primitive : tile_bins[tile_index]) {
+            if (pipeline != nullptr) {
+              rasterize_triangle(*primitive, tile, depth_buffer, coarse_depth,
+                                 color_target, pipeline->run_rasterizer(),
+                                 pipeline, stats);
+            } else if (g_buffer) {
+              rasterize_triangle(*primitive, tile, depth_buffer, coarse_depth,
+                                 g_buffer_target, diffuse_texture, stats);
+            } else {
+              rasterize_triangle(*primitive, tile, depth_buffer, coarse_depth,
+                                 color_target, diffuse_texture, stats);
+            }
+          }
+        } else {
+          const SampleTarget samples = framebuffer.sample_target(tile_index);
+          for (const TriangleSetup* primitive : tile_bins[tile_index]) {
+            if (pipeline != nullptr) {
+              rasterize_triangle(*primitive, tile, samples, coarse_depth,
+                                 pipeline->multisampled_run_rasterizer(),
+                                 pipeline, stats);
+            } else {
+              rasterize_triangle(*primitive, tile, samples, coarse_depth,
+                                 diffuse_texture, stats);
+            }
+          }
+          // Resolved while the samples of the tile are still in cache
+          framebuffer.resolve_samples(tile_index);
+        }
+        // Immediate shading shades every fragment that passes the depth test
+        if (!visibility_buffer) {
+          stats.fragments_shaded = stats.fragments_passed;
+        }
+        tile_stats[tile_index] = stats;
+      });
+    }
+
+    for (const auto& stats : tile_stats) { draw_stats += stats; }
+    const std::scoped_lock lock{stats_mutex};
+    frame_stats += draw_stats;
+  }
+
+  /// Runs the draws of `commands` as lines or points, see Topology and
+  /// LineStyle. They are drawn in order on this thread, with no binning.
+  void draw_lines(const BindState& state,
+                  std::span<const DrawIndexedIndirectCommand> commands)
+  {
     using beyond::to_f32;
 
-    const auto& vertex_buffer = buffers[current_vertex_buffer_index];
-    const auto& index_buffer = buffers[current_index_buffer_index];
-
-    const std::span<const Vertex> vertices{
-        bit_cast<const Vertex*>(vertex_buffer.data()),
-        bit_cast<const Vertex*>(vertex_buffer.data() + vertex_buffer.size())};
-    const std::span<const uint32_t> indices{
-        bit_cast<const uint32_t*>(index_buffer.data()),
-        bit_cast<const uint32_t*>(index_buffer.data() + index_buffer.size())};
-
-    using beyond::float_constants::pi;
-
-    const auto view = beyond::look_at(beyond::Vec3{1.f, 0.8f, 3.f},
-                                      beyond::Vec3{0.f, 0.f, 0.f},
-                                      beyond::Vec3{0.f, 1.f, 0.f});
-
-    const auto proj = beyond::perspective(
-        beyond::Radian(pi / 3.f), to_f32(width) / to_f32(height), 0.1f, 100.f);
-
-    const auto light_dir = beyond::normalize(beyond::Vec3{0, 1, 5});
-
-    constexpr const char* diffuse_texture_filename =
-        "assets/textures/african_head_diffuse.tga";
-
-    float* diffuse_texture_ = nullptr;
-    int diffuse_texture_width_ = 0;
-    int diffuse_texture_height_ = 0;
-    int diffuse_texture_channels_ = 0;
-    diffuse_texture_ =
-        stbi_loadf(diffuse_texture_filename, &diffuse_texture_width_,
-                   &diffuse_texture_height_, &diffuse_texture_channels_, 0);
-
-    for (std::size_t i = 0; i < indices.size(); i += 3) {
-      const std::array triangle_indices{indices[i], indices[i + 1],
-                                        indices[i + 2]};
-
-      std::array<beyond::Point3, 3> world_coords;
-      std::array<beyond::Point3, 3> screen_coords;
-      std::array<beyond::Vec2, 3> uvs;
-      for (std::size_t j = 0; j < 3; ++j) {
-        world_coords[j] =
-            *bit_cast<beyond::Point3*>(&vertices[triangle_indices[j]].pos);
-
-        const beyond::Vec4 normalized_coord =
-            proj * view * beyond::Vec4{world_coords[j], 1};
-        screen_coords[j] =
-            normalized_to_screen(normalized_coord.xyz / normalized_coord.w);
-        uvs[j] =
-            *bit_cast<beyond::Vec2*>(&vertices[triangle_indices[j]].texcoord);
+    std::unique_lock resource_lock{resource_mutex};
+    const DrawBuffers bound = draw_buffers(state);
+    const std::span<const Vertex> vertices = bound.vertices;
+    const std::span<const std::uint32_t> indices = bound.indices;
+    const std::span<const beyond::Mat4> instance_transforms =
+        bound.instance_transforms;
+    FramebufferStorage& framebuffer = framebuffers[state.framebuffer.id];
+    BEYOND_ASSERT(framebuffer.sample_count() == 1 &&
+                  !framebuffer.has_g_buffer());
+    resource_lock.unlock();
+
+    const Rect viewport = region_rect(state.viewport, framebuffer);
+    BEYOND_ASSERT(viewport.min.x >= 0 && viewport.min.y >= 0 &&
+                  viewport.max.x <= framebuffer.width() &&
+                  viewport.max.y <= framebuffer.height());
+    const Rect scissor =
+        intersect(viewport, region_rect(state.scissor, framebuffer));
+    const beyond::Mat4 view_proj = view_projection(
+        state.camera, to_f32(viewport.max.x - viewport.min.x) /
+                          to_f32(viewport.max.y - viewport.min.y));
+    const ColorTarget color_target = framebuffer.color_target();
+    const std::vector<float>& depth_buffer = framebuffer.depth();
+    const LineStyle& style = state.line_style;
+    const std::size_t per_primitive = indices_per_primitive(state.topology);
+
+    const ScopedTimer timer{frame_profiler, PipelineStage::raster};
+    if (scissor.empty()) { return; }
+    // Lines can cross any tile of the scissor
+    const int tile_count_x = framebuffer.tile_count_x();
+    for (int tile_y = scissor.min.y / tile_size;
+         tile_y <= (scissor.max.y - 1) / tile_size; ++tile_y) {
+      for (int tile_x = scissor.min.x / tile_size;
+           tile_x <= (scissor.max.x - 1) / tile_size; ++tile_x) {
+        framebuffer.resolve_clear(
+            static_cast<std::size_t>(tile_y * tile_count_x + tile_x));
       }
+    }
+
+    PipelineStats draw_stats;
+    for (const DrawIndexedIndirectCommand& command : commands) {
+      BEYOND_ASSERT(command.index_count % per_primitive == 0 &&
+                    std::size_t{command.first_index} + command.index_count <=
+                        indices.size());
+      BEYOND_ASSERT(command.vertex_offset >= 0 &&
+                    static_cast<std::size_t>(command.vertex_offset) <=
+                        vertices.size());
+      const std::span<const std::uint32_t> draw_indices =
+          indices.subspan(command.first_index, command.index_count);
+      const std::span<const Vertex> draw_vertices =
+          vertices.subspan(static_cast<std::size_t>(command.vertex_offset));
+      draw_stats.instances_submitted += command.instance_count;
+      draw_stats.input_vertices +=
+          std::uint64_t{command.instance_count} * draw_indices.size();
+
+      for (std::uint32_t i = 0; i < command.instance_count; ++i) {
+        const std::size_t instance = std::size_t{command.first_instance} + i;
+        BEYOND_ASSERT(instance_transforms.empty() ||
+                      instance < instance_transforms.size());
+        const beyond::Mat4 mvp =
+            instance_transforms.empty()
+                ? view_proj
+                : view_proj * instance_transforms[instance];
+        const auto clip_position = [&](std::uint32_t index) {
+          BEYOND_ASSERT(index < draw_vertices.size());
+          return transform_to_clip(mvp, draw_vertices[index].pos);
+        };
+        const auto project = [&](const beyond::Vec4& pos) {
+          return to_screen(pos.x, pos.y, pos.z, pos.w, viewport).pos;
+        };
 
-      const auto normal =
-          beyond::normalize(beyond::cross(world_coords[1] - world_coords[0],
-                                          world_coords[2] - world_coords[1]));
-      float intensity = beyond::dot(normal, light_dir);
-      intensity = std::min(intensity, 1.f);
-      triangle(screen_coords, uvs, depth_buffer, image, diffuse_texture_,
-               diffuse_texture_width_, diffuse_texture_height_,
-               diffuse_texture_channels_, RGB(intensity, intensity, intensity));
+        if (state.topology == Topology::lines) {
+          for (std::size_t j = 0; j < draw_indices.size(); j += 2) {
+            beyond::Vec4 from = clip_position(draw_indices[j]);
+            beyond::Vec4 to = clip_position(draw_indices[j + 1]);
+            if (!clip_line_near(from, to)) { continue; }
+            rasterize_line(project(from), project(to), scissor, depth_buffer,
+                           color_target, style.color, style.depth_test,
+                           draw_stats);
+          }
+        } else {
+          for (const std::uint32_t index : draw_indices) {
+            const beyond::Vec4 pos = clip_position(index);
+            // Behind the near plane
+            if (pos.z < -pos.w) { continue; }
+            rasterize_point(project(pos), scissor, depth_buffer, color_target,
+                            style.color, style.depth_test, draw_stats);
+          }
+        }
+      }
     }
+
+    const std::scoped_lock lock{stats_mutex};
+    frame_stats += draw_stats;
+  }
+
+  /// Lights the G-buffer of the framebuffer of `state`, see
+  /// Device::shade_lights()
+  void shade_lights(const BindState& state, const command::ShadeLights& shade)
+  {
+    std::unique_lock resource_lock{resource_mutex};
+    FramebufferStorage& framebuffer = framebuffers[state.framebuffer.id];
+    BEYOND_ASSERT(framebuffer.has_g_buffer());
+    const Rect viewport = region_rect(state.viewport, framebuffer);
+    const LightingView view = make_lighting_view(state.camera, viewport);
+
+    // Copied out of the buffer, in view space
+    view_lights.clear();
+    if (shade.light_count != 0) {
+      const std::span<const std::byte> light_data =
+          buffer_data(shade.light_buffer);
+      BEYOND_ASSERT(shade.light_count * sizeof(PointLight) <=
+                    light_data.size());
+      const std::span<const PointLight> lights{
+          beyond::bit_cast<const PointLight*>(light_data.data()),
+          shade.light_count};
+      for (const PointLight& light : lights) {
+        if (auto view_light = make_view_light(light, view)) {
+          view_lights.push_back(*view_light);
+        }
+      }
+    }
+    resource_lock.unlock();
+
+    const ColorTarget color_target = framebuffer.color_target();
+    const GBufferTarget g_buffer = framebuffer.g_buffer_target();
+    const std::vector<float>& depth_buffer = framebuffer.depth();
+    const float clear_depth = framebuffer.clear_depth();
+    const beyond::Vec3 sun =
+        beyond::normalize(transform_direction(view.view, sun_direction()));
+
+    const ScopedTimer timer{frame_profiler, PipelineStage::lighting};
+    PipelineStats pass_stats;
+    const int tile_count_x = framebuffer.tile_count_x();
+    light_bins.resize(framebuffer.tile_count());
+    tile_stats.assign(framebuffer.tile_count(), PipelineStats{});
+    for (auto& bin : light_bins) { bin.clear(); }
+    for (const ViewLight& light : view_lights) {
+      const Rect& bounds = light.bounds;
+      for (int tile_y = bounds.min.y / tile_size;
+           tile_y <= (bounds.max.y - 1) / tile_size; ++tile_y) {
+        for (int tile_x = bounds.min.x / tile_size;
+             tile_x <= (bounds.max.x - 1) / tile_size; ++tile_x) {
+          light_bins[static_cast<std::size_t>(tile_y * tile_count_x + tile_x)]
+              .push_back(&light);
+          ++pass_stats.lights_binned;
+        }
+      }
+    }
+
+    // Tiles that no draw touched since the clear hold only the clear color
+    thread_pool.parallel_for(light_bins.size(), [&](std::size_t tile_index) {
+      if (!framebuffer.depth_resolved(tile_index)) { return; }
+      const Rect tile = intersect(framebuffer.tile_rect(tile_index), viewport);
+      if (tile.empty()) { return; }
+      shade_tile(tile, view, sun, light_bins[tile_index], depth_buffer,
+                 clear_depth, g_buffer, color_target, tile_stats[tile_index]);
+    });
+
+    for (const auto& stats : tile_stats) { pass_stats += stats; }
+    const std::scoped_lock lock{stats_mutex};
+    frame_stats += pass_stats;
+  }
+
+  void begin_frame() override
+  {
+    {
+      const std::scoped_lock lock{stats_mutex};
+      frame_stats = {};
+    }
+    frame_profiler.begin_frame();
+  }
+
+  auto pipeline_stats() const -> PipelineStats override
+  {
+    const std::scoped_lock lock{stats_mutex};
+    return frame_stats;
+  }
+
+  auto profiler() -> Profiler& override
+  {
+    return frame_profiler;
   }
 };
 
-[[nodiscard]] auto Device::create() -> std::unique_ptr<Device>
+[[nodiscard]] auto Device::create(const DeviceDesc& desc)
+    -> std::unique_ptr<Device>
 {
-  return std::make_unique<CPUDevice>();
+  std::uint32_t thread_count = desc.thread_count;
+  if (thread_count == 0) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    thread_count = 1;
+#else
+    thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+#endif
+  }
+  return std::make_unique<CPUDevice>(thread_count);
 }
 
 } // namespace yasr
\ No newline at end of file
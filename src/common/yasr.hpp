@@ -1,16 +1,22 @@
 #ifndef YASR_HPP
 #define YASR_HPP
 
+#include "color_target.hpp"
 #include "image.hpp"
+#include "profiler.hpp"
 
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <span>
+#include <variant>
+#include <vector>
 
+#include <beyond/math/angle.hpp>
+#include <beyond/math/constants.hpp>
+#include <beyond/math/matrix.hpp>
 #include <beyond/math/point.hpp>
-
-constexpr int width = 1200;
-constexpr int height = 800;
+#include <beyond/math/vector.hpp>
 
 struct Vertex {
   beyond::Point3 pos;
@@ -29,22 +35,631 @@ namespace yasr {
   };
 
 struct Device;
+class PipelineProgram;
 
+// Handles with an id of 0 refer to no resource. A destroyed resource's handle
+// stays invalid even after the device reuses its storage for a new resource.
 DEFINE_HANDLE(Buffer)
+DEFINE_HANDLE(Texture)
+DEFINE_HANDLE(Framebuffer)
+DEFINE_HANDLE(Pipeline)
+/// Signaled once a submitted command buffer has run. Fence{} is always
+/// signaled.
+DEFINE_HANDLE(Fence)
+
+/// Where the bytes of a buffer live
+enum class BufferMemory {
+  /// The device copies the data into 64-byte aligned storage of its own
+  device,
+  /// The buffer reads the caller's memory without copying it. The memory
+  /// must outlive the buffer, and stay unchanged while a draw reads it.
+  external,
+};
 
 struct BufferDesc {
   std::span<const std::byte> data;
+  BufferMemory memory = BufferMemory::device;
+  /// Bytes of device memory to reserve, if more than `data` has. The bytes
+  /// past `data` start zeroed, so a buffer filled later with
+  /// Device::update_buffer() or Device::map_buffer() needs no initial data.
+  std::size_t size = 0;
+};
+
+/// Size of a bound range that reaches the end of its buffer
+inline constexpr std::size_t whole_size = std::dynamic_extent;
+
+enum class TextureFormat {
+  rgba8_unorm,
+  /// RGB channels are sRGB encoded and decoded to linear when sampled
+  rgba8_srgb,
+};
+
+enum class TextureFilter {
+  /// Point sampling of the full-resolution level
+  nearest,
+  /// Bilinear filtering of the closest mip level
+  bilinear,
+  /// Bilinear filtering of the two closest mip levels, blended
+  trilinear,
+};
+
+/// Triangles discarded by their winding. Front faces are counter-clockwise in
+/// normalized device coordinates, as in OpenGL.
+enum class CullMode {
+  none,
+  front,
+  back,
+};
+
+/// When the fragments of a draw are shaded
+enum class ShadingMode {
+  /// As soon as they pass the depth test, even if a later triangle of the
+  /// draw hides them
+  immediate,
+  /**
+   * After a depth pass over the whole draw, which stores the nearest
+   * triangle of every pixel in a visibility buffer. Each pixel is then shaded
+   * once per draw, with the same result. Only for single-sampled
+   * framebuffers without a G-buffer, others shade immediately.
+   */
+  visibility_buffer,
+};
+
+/// How draws assemble their indices into primitives
+enum class Topology {
+  /// Every 3 indices form a triangle
+  triangles,
+  /// Every 2 indices form a line, drawn one pixel wide
+  lines,
+  /// Every index is a point, drawn as a single pixel
+  points,
+};
+
+/**
+ * \brief The look of lines and points
+ *
+ * Lines and points ignore the pipeline, the texture and the shading mode and
+ * are drawn in a flat color. They never write depth, and pass the depth test
+ * slightly behind the stored depth, so the edges of a filled draw can be
+ * drawn over it.
+ */
+struct LineStyle {
+  /// Linear color, encoded to the format of the attachment like shaded colors
+  RGB color{1, 1, 1};
+  bool depth_test = true;
+};
+
+struct TextureDesc {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  TextureFormat format = TextureFormat::rgba8_srgb;
+  /// Tightly packed rows of 4 bytes per texel, top row first
+  std::span<const std::byte> data;
+};
+
+struct FramebufferDesc {
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+  ColorFormat format = ColorFormat::rgb32_float;
+  /// 1, or 4 for multisample anti-aliasing. Multisampled framebuffers test
+  /// coverage and depth at every sample but shade each pixel once, and every
+  /// draw resolves the samples of the tiles it touched into the color
+  /// attachment.
+  std::uint32_t sample_count = 1;
+  /// Adds a G-buffer of packed normals and albedo for deferred shading.
+  /// Draws with the built-in shading then fill the G-buffer and the depth
+  /// attachment, and Device::shade_lights() lights them into the color
+  /// attachment. Only for single-sampled framebuffers.
+  bool g_buffer = false;
+};
+
+/// A rectangle of pixels, from the top-left corner of the framebuffer. A
+/// region with no area stands for the whole framebuffer.
+struct Region {
+  std::int32_t x = 0;
+  std::int32_t y = 0;
+  std::uint32_t width = 0;
+  std::uint32_t height = 0;
+};
+
+struct ClearValue {
+  /// Linear color, encoded to the format of the attachment like shaded colors
+  RGB color;
+  /// Larger depth values are closer to the camera
+  float depth = -std::numeric_limits<float>::infinity();
+};
+
+/// A light of deferred shading, see Device::shade_lights()
+struct PointLight {
+  beyond::Vec3 position;
+  /// Linear color, scaled by the intensity of the light
+  RGB color;
+  /// The light fades out smoothly and stops at this distance
+  float radius = 1;
+};
+
+/**
+ * \brief Arguments of one draw of Device::draw_indexed_indirect()
+ *
+ * Laid out like VkDrawIndexedIndirectCommand. Indices past the last whole
+ * primitive of the topology are ignored. Index i of the draw reads
+ * vertex vertex_offset + indices[first_index + i], and its instances read
+ * the transforms first_instance to first_instance + instance_count - 1 of the
+ * bound instance buffer.
+ */
+struct DrawIndexedIndirectCommand {
+  std::uint32_t index_count = 0;
+  std::uint32_t instance_count = 1;
+  std::uint32_t first_index = 0;
+  std::int32_t vertex_offset = 0;
+  std::uint32_t first_instance = 0;
+};
+
+/// A perspective camera, the defaults frame the sample model
+struct Camera {
+  beyond::Vec3 eye{1.f, 0.8f, 3.f};
+  beyond::Vec3 target{0.f, 0.f, 0.f};
+  beyond::Vec3 up{0.f, 1.f, 0.f};
+  /// Vertical field of view, the aspect ratio follows the viewport
+  beyond::Radian fov_y{beyond::float_constants::pi / 3.f};
+  float z_near = 0.1f;
+  float z_far = 100.f;
+};
+
+/**
+ * \brief Counters of the work done by the draws of a frame
+ *
+ * Modeled on the pipeline statistics queries of GPU APIs.
+ */
+struct PipelineStats {
+  /// Instances of the draws, a plain draw counts as one
+  std::uint64_t instances_submitted = 0;
+  /// Instances dropped as a whole for lying outside the view frustum, before
+  /// any of their triangles was assembled
+  std::uint64_t instances_culled = 0;
+
+  /// Indices read by primitive assembly
+  std::uint64_t input_vertices = 0;
+  /// Vertices run through the vertex stage, once per distinct index of a draw
+  std::uint64_t vertices_processed = 0;
+  std::uint64_t triangles_submitted = 0;
+  /// Triangles dropped before rasterization: of culled instances, outside the
+  /// view frustum, facing away by the cull mode, degenerate or between pixel
+  /// centres
+  std::uint64_t triangles_culled = 0;
+  /// Triangles that crossed the near plane or the guard band and were clipped
+  std::uint64_t triangles_clipped = 0;
+
+  /// Triangles rejected as a whole by the hierarchical depth test, counted
+  /// once per screen tile they touch
+  std::uint64_t hiz_triangles_culled = 0;
+  /// 8x8 pixel blocks of the remaining triangles rejected
+  std::uint64_t hiz_blocks_culled = 0;
+  /// Pixels of the triangles' bounding boxes that were never rasterized
+  std::uint64_t hiz_pixels_culled = 0;
+
+  /// Covered pixels that reached the depth test
+  std::uint64_t fragments_tested = 0;
+  /// Fragments that passed the depth test, and were shaded unless shading
+  /// with a visibility buffer
+  std::uint64_t fragments_passed = 0;
+  /// Fragments the shading ran on
+  std::uint64_t fragments_shaded = 0;
+  /// Texels read by shading, a trilinear lookup counts as 8
+  std::uint64_t texels_fetched = 0;
+
+  /// Point lights of deferred shading sorted into the screen tiles their
+  /// bounds overlap, counted once per tile
+  std::uint64_t lights_binned = 0;
+  /// Binned lights outside the depth range of the pixels of their tile
+  std::uint64_t lights_culled = 0;
+
+  auto operator+=(const PipelineStats& other) noexcept -> PipelineStats&
+  {
+    instances_submitted += other.instances_submitted;
+    instances_culled += other.instances_culled;
+    input_vertices += other.input_vertices;
+    vertices_processed += other.vertices_processed;
+    triangles_submitted += other.triangles_submitted;
+    triangles_culled += other.triangles_culled;
+    triangles_clipped += other.triangles_clipped;
+    hiz_triangles_culled += other.hiz_triangles_culled;
+    hiz_blocks_culled += other.hiz_blocks_culled;
+    hiz_pixels_culled += other.hiz_pixels_culled;
+    fragments_tested += other.fragments_tested;
+    fragments_passed += other.fragments_passed;
+    fragments_shaded += other.fragments_shaded;
+    texels_fetched += other.texels_fetched;
+    lights_binned += other.lights_binned;
+    lights_culled += other.lights_culled;
+    return *this;
+  }
+
+  /// Fraction of the input vertices whose transform was reused
+  [[nodiscard]] auto vertex_reuse() const noexcept -> double
+  {
+    if (input_vertices == 0) { return 0.0; }
+    return 1.0 - static_cast<double>(vertices_processed) /
+                     static_cast<double>(input_vertices);
+  }
+};
+
+/// The commands a CommandBuffer records, one per recording call
+namespace command {
+
+struct BindFramebuffer {
+  Framebuffer framebuffer;
+};
+struct BindVertexBuffer {
+  Buffer buffer;
+  std::size_t offset = 0;
+  std::size_t size = whole_size;
+};
+struct BindIndexBuffer {
+  Buffer buffer;
+  std::size_t offset = 0;
+  std::size_t size = whole_size;
+};
+struct BindTexture {
+  Texture texture;
+};
+struct BindConstantBuffer {
+  Buffer buffer;
+};
+struct BindInstanceBuffer {
+  Buffer buffer;
+};
+struct BindPipeline {
+  Pipeline pipeline;
+};
+struct SetTextureFilter {
+  TextureFilter filter = TextureFilter::trilinear;
+};
+struct SetCullMode {
+  CullMode mode = CullMode::back;
+};
+struct SetShadingMode {
+  ShadingMode mode = ShadingMode::immediate;
+};
+struct SetTopology {
+  Topology topology = Topology::triangles;
+};
+struct SetLineStyle {
+  LineStyle style;
+};
+struct SetCamera {
+  Camera camera;
+};
+struct SetViewport {
+  Region viewport;
+};
+struct SetScissor {
+  Region scissor;
+};
+struct Clear {
+  ClearValue value;
+};
+struct DrawIndexed {
+};
+struct DrawIndexedInstanced {
+  std::uint32_t instance_count = 1;
+};
+struct DrawIndexedIndirect {
+  Buffer argument_buffer;
+  std::uint32_t draw_count = 0;
+};
+struct ShadeLights {
+  Buffer light_buffer;
+  std::uint32_t light_count = 0;
+};
+struct UpdateBuffer {
+  Buffer buffer;
+  std::size_t offset = 0;
+  /// Where the bytes start in CommandBuffer::data()
+  std::size_t data_offset = 0;
+  std::size_t size = 0;
+};
+
+} // namespace command
+
+using Command = std::variant<
+    command::BindFramebuffer, command::BindVertexBuffer,
+    command::BindIndexBuffer, command::BindTexture, command::BindConstantBuffer,
+    command::BindInstanceBuffer, command::BindPipeline,
+    command::SetTextureFilter, command::SetCullMode, command::SetShadingMode,
+    command::SetTopology, command::SetLineStyle, command::SetCamera,
+    command::SetViewport, command::SetScissor, command::Clear,
+    command::DrawIndexed, command::DrawIndexedInstanced,
+    command::DrawIndexedIndirect, command::ShadeLights, command::UpdateBuffer>;
+
+/**
+ * \brief Binds, state changes and draws recorded for Device::submit()
+ *
+ * The recording calls mirror the immediate calls of Device. Every submission
+ * starts from the default bindings and states, and leaves those of the
+ * immediate calls alone.
+ */
+class CommandBuffer {
+public:
+  void bind_framebuffer(Framebuffer framebuffer)
+  {
+    commands_.emplace_back(command::BindFramebuffer{framebuffer});
+  }
+  void bind_vertex_buffer(Buffer vertex_buffer, std::size_t offset = 0,
+                          std::size_t size = whole_size)
+  {
+    commands_.emplace_back(
+        command::BindVertexBuffer{vertex_buffer, offset, size});
+  }
+  void bind_index_buffer(Buffer index_buffer, std::size_t offset = 0,
+                         std::size_t size = whole_size)
+  {
+    commands_.emplace_back(
+        command::BindIndexBuffer{index_buffer, offset, size});
+  }
+  void bind_texture(Texture texture)
+  {
+    commands_.emplace_back(command::BindTexture{texture});
+  }
+  void bind_constant_buffer(Buffer constant_buffer)
+  {
+    commands_.emplace_back(command::BindConstantBuffer{constant_buffer});
+  }
+  void bind_instance_buffer(Buffer instance_buffer)
+  {
+    commands_.emplace_back(command::BindInstanceBuffer{instance_buffer});
+  }
+  void bind_pipeline(Pipeline pipeline)
+  {
+    commands_.emplace_back(command::BindPipeline{pipeline});
+  }
+  void set_texture_filter(TextureFilter filter)
+  {
+    commands_.emplace_back(command::SetTextureFilter{filter});
+  }
+  void set_cull_mode(CullMode mode)
+  {
+    commands_.emplace_back(command::SetCullMode{mode});
+  }
+  void set_shading_mode(ShadingMode mode)
+  {
+    commands_.emplace_back(command::SetShadingMode{mode});
+  }
+  void set_topology(Topology topology)
+  {
+    commands_.emplace_back(command::SetTopology{topology});
+  }
+  void set_line_style(const LineStyle& style)
+  {
+    commands_.emplace_back(command::SetLineStyle{style});
+  }
+  void set_camera(const Camera& camera)
+  {
+    commands_.emplace_back(command::SetCamera{camera});
+  }
+  void set_viewport(const Region& viewport)
+  {
+    commands_.emplace_back(command::SetViewport{viewport});
+  }
+  void set_scissor(const Region& scissor)
+  {
+    commands_.emplace_back(command::SetScissor{scissor});
+  }
+  void clear(const ClearValue& value)
+  {
+    commands_.emplace_back(command::Clear{value});
+  }
+  void draw_indexed()
+  {
+    commands_.emplace_back(command::DrawIndexed{});
+  }
+  void draw_indexed_instanced(std::uint32_t instance_count)
+  {
+    commands_.emplace_back(command::DrawIndexedInstanced{instance_count});
+  }
+  void draw_indexed_indirect(Buffer argument_buffer, std::uint32_t draw_count)
+  {
+    commands_.emplace_back(
+        command::DrawIndexedIndirect{argument_buffer, draw_count});
+  }
+  void shade_lights(Buffer light_buffer, std::uint32_t light_count)
+  {
+    commands_.emplace_back(command::ShadeLights{light_buffer, light_count});
+  }
+  /// Copies `data` into the command buffer, which writes it to `buffer` at
+  /// `offset` when the submission reaches this command
+  void update_buffer(Buffer buffer, std::size_t offset,
+                     std::span<const std::byte> data)
+  {
+    commands_.emplace_back(command::UpdateBuffer{.buffer = buffer,
+                                                 .offset = offset,
+                                                 .data_offset = data_.size(),
+                                                 .size = data.size()});
+    data_.insert(data_.end(), data.begin(), data.end());
+  }
+
+  /// Drops the recorded commands and keeps their storage
+  void reset() noexcept
+  {
+    commands_.clear();
+    data_.clear();
+  }
+
+  [[nodiscard]] auto commands() const noexcept -> std::span<const Command>
+  {
+    return commands_;
+  }
+  /// The bytes of the recorded buffer updates
+  [[nodiscard]] auto data() const noexcept -> std::span<const std::byte>
+  {
+    return data_;
+  }
+
+private:
+  std::vector<Command> commands_;
+  std::vector<std::byte> data_;
+};
+
+struct DeviceDesc {
+  /// Number of threads used for rasterization, 0 means one per hardware thread
+  std::uint32_t thread_count = 0;
 };
 
 struct Device {
-  [[nodiscard]] static auto create() -> std::unique_ptr<Device>;
+  [[nodiscard]] static auto create(const DeviceDesc& desc = {})
+      -> std::unique_ptr<Device>;
 
   [[nodiscard]] virtual auto create_buffer(BufferDesc desc) -> Buffer = 0;
   virtual void destroy_buffer(Buffer buffer) = 0;
+  /**
+   * \brief Copies `data` into a buffer of device memory at `offset`
+   *
+   * Only the bytes of `data` are copied, and they must fit in the buffer.
+   * Waits for the submissions so far, like draw_indexed(), so the draws of
+   * earlier submissions read the old bytes. Recording the update in a
+   * CommandBuffer orders it without waiting.
+   */
+  virtual void update_buffer(Buffer buffer, std::size_t offset,
+                             std::span<const std::byte> data) = 0;
+  /**
+   * \brief The storage of a buffer of device memory, for writing in place
+   *
+   * Does not wait for the submissions, so bytes that a pending submission
+   * may read must not be written until its fence is signaled. UploadRing
+   * takes care of that for data written anew every frame. The span stays
+   * valid until the buffer is destroyed.
+   */
+  [[nodiscard]] virtual auto map_buffer(Buffer buffer)
+      -> std::span<std::byte> = 0;
+
+  [[nodiscard]] virtual auto create_texture(TextureDesc desc) -> Texture = 0;
+  virtual void destroy_texture(Texture texture) = 0;
+
+  [[nodiscard]] virtual auto create_framebuffer(FramebufferDesc desc)
+      -> Framebuffer = 0;
+  virtual void destroy_framebuffer(Framebuffer framebuffer) = 0;
+
+  /// Takes ownership of a program made by make_pipeline()
+  [[nodiscard]] virtual auto
+  create_pipeline(std::unique_ptr<PipelineProgram> program) -> Pipeline = 0;
+  virtual void destroy_pipeline(Pipeline pipeline) = 0;
+
+  /// Color attachment of an rgb32_float framebuffer, valid until its next draw
+  /// or clear. A framebuffer a submission renders to can be read once the
+  /// fence of the submission is signaled.
+  [[nodiscard]] virtual auto framebuffer_image(Framebuffer framebuffer)
+      -> const Image& = 0;
+  /// Color attachment of a framebuffer of any format, valid until its next
+  /// draw or clear
+  [[nodiscard]] virtual auto framebuffer_color(Framebuffer framebuffer)
+      -> ColorView = 0;
+
+  virtual void bind_framebuffer(Framebuffer framebuffer) = 0;
+  void bind_vertex_buffer(Buffer vertex_buffer)
+  {
+    bind_vertex_buffer(vertex_buffer, 0, whole_size);
+  }
+  void bind_index_buffer(Buffer index_buffer)
+  {
+    bind_index_buffer(index_buffer, 0, whole_size);
+  }
+  /**
+   * \brief Binds `size` bytes of a buffer from `offset`, so that draws read
+   * a range of a larger buffer such as the memory of an UploadRing
+   *
+   * `size` can be whole_size for the rest of the buffer. The offset must be
+   * aligned to Vertex, or to the indices.
+   */
+  virtual void bind_vertex_buffer(Buffer vertex_buffer, std::size_t offset,
+                                  std::size_t size) = 0;
+  virtual void bind_index_buffer(Buffer index_buffer, std::size_t offset,
+                                 std::size_t size) = 0;
+  virtual void bind_texture(Texture texture) = 0;
+  /// Binds the uniforms of the bound pipeline
+  virtual void bind_constant_buffer(Buffer constant_buffer) = 0;
+  /// Binds tightly packed beyond::Mat4 model transforms, one per instance.
+  /// Without an instance buffer, or with Buffer{}, every instance is drawn
+  /// untransformed.
+  virtual void bind_instance_buffer(Buffer instance_buffer) = 0;
+  /// Pipeline{} selects the built-in textured and lit shading, which uses the
+  /// camera and the texture filter. Pipelines get their transforms from the
+  /// constant buffer and sample the texture as they like.
+  virtual void bind_pipeline(Pipeline pipeline) = 0;
+  virtual void set_texture_filter(TextureFilter filter) = 0;
+  /// Defaults to CullMode::back
+  virtual void set_cull_mode(CullMode mode) = 0;
+  /// Defaults to ShadingMode::immediate
+  virtual void set_shading_mode(ShadingMode mode) = 0;
+  /// Defaults to Topology::triangles. Lines and points can only be drawn into
+  /// single-sampled framebuffers without a G-buffer.
+  virtual void set_topology(Topology topology) = 0;
+  virtual void set_line_style(const LineStyle& style) = 0;
+  virtual void set_camera(const Camera& camera) = 0;
+  /// The pixels normalized device coordinates map to, which must lie inside
+  /// the bound framebuffer when drawing. Region{}, the default, covers the
+  /// whole framebuffer.
+  virtual void set_viewport(const Region& viewport) = 0;
+  /// The pixels draws may write, on top of the viewport. Region{}, the
+  /// default, covers the whole framebuffer.
+  virtual void set_scissor(const Region& scissor) = 0;
+
+  /// Clears the color and depth attachments of the whole bound framebuffer,
+  /// regardless of the viewport and scissor. Waits for the submissions so
+  /// far, like draw_indexed().
+  virtual void clear(const ClearValue& value) = 0;
+  /// Draws the whole index buffer as one instance
+  virtual void draw_indexed() = 0;
+  /**
+   * \brief Draws the whole index buffer `instance_count` times
+   *
+   * The instances share the vertex cache, the bindings and a single binning
+   * and raster pass. Instances outside the view frustum are dropped before
+   * their triangles are assembled.
+   */
+  virtual void draw_indexed_instanced(std::uint32_t instance_count) = 0;
+  /// Draws like draw_indexed_instanced() for each of the `draw_count`
+  /// DrawIndexedIndirectCommand at the start of `argument_buffer`
+  virtual void draw_indexed_indirect(Buffer argument_buffer,
+                                     std::uint32_t draw_count) = 0;
+  /**
+   * \brief Lights the G-buffer of the bound framebuffer into its color
+   * attachment
+   *
+   * Shades with the built-in directional light and the first `light_count`
+   * tightly packed PointLight of `light_buffer`, which can be Buffer{} for no
+   * point lights. The lights are culled against the screen tiles by their
+   * bounds and by the depth range of the pixels of each tile, and every
+   * pixel a draw covered is shaded once, with the camera and viewport of the
+   * draws. The other pixels keep the clear color.
+   */
+  virtual void shade_lights(Buffer light_buffer,
+                            std::uint32_t light_count) = 0;
+
+  /**
+   * \brief Queues `commands` after the earlier submissions and returns
+   * without waiting for them
+   *
+   * Submissions run in order on a thread of the device, which hands the
+   * stages of their draws to the worker threads. Meanwhile the caller can
+   * present the frame of an earlier submission. The resources a submission
+   * uses must stay alive until its fence is signaled. Once it has run, the
+   * storage of `commands` goes back to acquire_command_buffer().
+   */
+  [[nodiscard]] virtual auto submit(CommandBuffer&& commands) -> Fence = 0;
+  /// An empty command buffer to record a submission, which reuses the
+  /// storage of a submission that has run when there is one
+  [[nodiscard]] virtual auto acquire_command_buffer() -> CommandBuffer = 0;
+  /// Whether the submission of `fence` and every earlier one have run
+  [[nodiscard]] virtual auto is_signaled(Fence fence) const -> bool = 0;
+  virtual void wait(Fence fence) = 0;
 
-  virtual void bind_vertex_buffer(Buffer vertex_buffer) = 0;
-  virtual void bind_index_buffer(Buffer index_buffer) = 0;
-  virtual void draw_indexed(Image& image, std::vector<float> depth_buffer) = 0;
+  /// Resets the pipeline statistics and the profiler's stage times
+  virtual void begin_frame() = 0;
+  /// Counters of the draws since begin_frame(), including those of pending
+  /// submissions that have run so far
+  [[nodiscard]] virtual auto pipeline_stats() const -> PipelineStats = 0;
+  /// Times of the pipeline stages, applications can record the present stage
+  [[nodiscard]] virtual auto profiler() -> Profiler& = 0;
 
   Device() = default;
   virtual ~Device() = default;
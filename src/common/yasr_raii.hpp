@@ -1,8 +1,12 @@
 #ifndef YASR_RAII_HPP
 #define YASR_RAII_HPP
 
+#include "pipeline.hpp"
 #include "yasr.hpp"
 
+#include <memory>
+#include <utility>
+
 namespace yasr {
 
 template <typename Resource, void (Device::*deleter)(Resource)>
@@ -32,6 +36,11 @@ struct UniqueResource {
   }
   auto operator=(UniqueResource&& other) & noexcept -> UniqueResource&
   {
+    if (this == &other) { return *this; }
+    // The replaced resource is destroyed, like by a std::unique_ptr
+    if (device_) {
+      (device_->*deleter)(resource_);
+    }
     device_ = std::exchange(other.device_, nullptr);
     resource_ = std::exchange(other.resource_, {});
     return *this;
@@ -54,6 +63,41 @@ struct UniqueBuffer : UniqueResource<Buffer, &Device::destroy_buffer> {
   return UniqueBuffer{device, device.create_buffer(desc)};
 }
 
+struct UniqueTexture : UniqueResource<Texture, &Device::destroy_texture> {
+  using UniqueResource::UniqueResource;
+};
+
+[[nodiscard]] inline auto create_unique_texture(Device& device,
+                                                const TextureDesc& desc)
+    -> UniqueTexture
+{
+  return UniqueTexture{device, device.create_texture(desc)};
+}
+
+struct UniqueFramebuffer
+    : UniqueResource<Framebuffer, &Device::destroy_framebuffer> {
+  using UniqueResource::UniqueResource;
+};
+
+[[nodiscard]] inline auto create_unique_framebuffer(Device& device,
+                                                    const FramebufferDesc& desc)
+    -> UniqueFramebuffer
+{
+  return UniqueFramebuffer{device, device.create_framebuffer(desc)};
+}
+
+struct UniquePipeline : UniqueResource<Pipeline, &Device::destroy_pipeline> {
+  using UniqueResource::UniqueResource;
+};
+
+[[nodiscard]] inline auto
+create_unique_pipeline(Device& device,
+                       std::unique_ptr<PipelineProgram> program)
+    -> UniquePipeline
+{
+  return UniquePipeline{device, device.create_pipeline(std::move(program))};
+}
+
 } // namespace yasr
 
 #endif // YASR_RAII_HPP
@@ -0,0 +1,528 @@
+#include "image_io.hpp"
+#include "mesh_cache.hpp"
+#include "pipeline.hpp"
+#include "vertex_processing.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <beyond/math/constants.hpp>
+#include <beyond/utils/bit_cast.hpp>
+#include <beyond/utils/panic.hpp>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+
+constexpr const char* usage = R"(Usage: headless [options]
+
+Renders frames offscreen and writes them to files or to stdout.
+
+Options:
+  --model PATH       OBJ model [assets/model/african_head.obj]
+  --texture PATH     Diffuse texture [assets/textures/african_head_diffuse.tga]
+  --width N          Frame width [1200]
+  --height N         Frame height [800]
+  --eye X,Y,Z        Camera position [1,0.8,3]
+  --target X,Y,Z     Point the camera looks at [0,0,0]
+  --fov DEGREES      Vertical field of view [60]
+  --cull MODE        none, front or back [back]
+  --samples N        Samples per pixel, 1 or 4 for multisample anti-aliasing
+                     [1]
+  --shading MODE     textured, the built-in lit shading, or normals, a shader
+                     pipeline showing the interpolated normals [textured]
+  --lights N         Deferred shading with N colored point lights circling
+                     the target, 0 for forward shading. Needs textured
+                     shading and 1 sample [0]
+  --visibility-buffer
+                     Rasterize the depth and nearest triangle of every pixel
+                     first, then shade each pixel once
+  --wireframe        Draw the edges of the triangles as white lines over the
+                     model. Needs 1 sample and no point lights
+  --orbit DEGREES    Rotation of the camera around the target between frames [0]
+  --frames N         Number of frames [1]
+  --threads N        Rasterization threads, 0 for one per hardware thread [0]
+  --output PATH      .png, .ppm or .exr file [frame_####.png]. A run of # is
+                     replaced by the zero-padded frame number. "-" streams
+                     packed 8-bit RGB frames to stdout, for example to
+                     ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH -i -
+  --stats            Log the pipeline statistics and stage times of every
+                     frame. The present time is that of the previous frame,
+                     which is encoded while the next one renders
+  --trace PATH       Write the stage timings as a Chrome trace, viewable in
+                     chrome://tracing or ui.perfetto.dev
+  --help             Show this message
+)";
+
+struct Options {
+  std::string model = "assets/model/african_head.obj";
+  std::string texture = "assets/textures/african_head_diffuse.tga";
+  std::uint32_t width = 1200;
+  std::uint32_t height = 800;
+  yasr::Camera camera;
+  yasr::CullMode cull_mode = yasr::CullMode::back;
+  std::uint32_t sample_count = 1;
+  bool shade_normals = false;
+  std::uint32_t light_count = 0;
+  yasr::ShadingMode shading_mode = yasr::ShadingMode::immediate;
+  bool wireframe = false;
+  float orbit_degrees = 0;
+  std::uint32_t frame_count = 1;
+  std::uint32_t thread_count = 0;
+  std::string output = "frame_####.png";
+  bool stats = false;
+  std::string trace;
+};
+
+auto parse_vec3(std::string_view text) -> std::optional<beyond::Vec3>
+{
+  std::array<float, 3> values{};
+  const std::string string{text};
+  const char* begin = string.c_str();
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    char* end = nullptr;
+    values[i] = std::strtof(begin, &end);
+    const char expected = i + 1 < values.size() ? ',' : '\0';
+    if (end == begin || *end != expected) { return std::nullopt; }
+    begin = end + 1;
+  }
+  return beyond::Vec3{values[0], values[1], values[2]};
+}
+
+auto parse_number(std::string_view text) -> std::optional<float>
+{
+  const std::string string{text};
+  char* end = nullptr;
+  const float value = std::strtof(string.c_str(), &end);
+  if (string.empty() || *end != '\0') { return std::nullopt; }
+  return value;
+}
+
+auto parse_count(std::string_view text) -> std::optional<std::uint32_t>
+{
+  const std::string string{text};
+  char* end = nullptr;
+  const unsigned long value = std::strtoul(string.c_str(), &end, 10);
+  if (string.empty() || *end != '\0' || value > UINT32_MAX) {
+    return std::nullopt;
+  }
+  return static_cast<std::uint32_t>(value);
+}
+
+/// Returns nullopt and reports the problem if the command line is invalid
+auto parse_options(int argc, char** argv) -> std::optional<Options>
+{
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view name = argv[i];
+    if (name == "--help") {
+      std::fputs(usage, stdout);
+      std::exit(0);
+    }
+    if (name == "--stats") {
+      options.stats = true;
+      continue;
+    }
+    if (name == "--visibility-buffer") {
+      options.shading_mode = yasr::ShadingMode::visibility_buffer;
+      continue;
+    }
+    if (name == "--wireframe") {
+      options.wireframe = true;
+      continue;
+    }
+    if (i + 1 == argc) {
+      spdlog::error("Missing value of {}", name);
+      return std::nullopt;
+    }
+    const std::string_view value = argv[++i];
+
+    bool valid = true;
+    const auto set_count = [&](std::uint32_t& count) {
+      const auto parsed = parse_count(value);
+      valid = parsed.has_value();
+      if (parsed) { count = *parsed; }
+    };
+    const auto set_vec3 = [&](beyond::Vec3& vector) {
+      const auto parsed = parse_vec3(value);
+      valid = parsed.has_value();
+      if (parsed) { vector = *parsed; }
+    };
+
+    if (name == "--model") {
+      options.model = value;
+    } else if (name == "--texture") {
+      options.texture = value;
+    } else if (name == "--width") {
+      set_count(options.width);
+    } else if (name == "--height") {
+      set_count(options.height);
+    } else if (name == "--eye") {
+      set_vec3(options.camera.eye);
+    } else if (name == "--target") {
+      set_vec3(options.camera.target);
+    } else if (name == "--fov") {
+      const auto degrees = parse_number(value);
+      valid = degrees.has_value();
+      if (degrees) {
+        options.camera.fov_y =
+            beyond::Radian{*degrees * beyond::float_constants::pi / 180.f};
+      }
+    } else if (name == "--cull") {
+      if (value == "none") {
+        options.cull_mode = yasr::CullMode::none;
+      } else if (value == "front") {
+        options.cull_mode = yasr::CullMode::front;
+      } else if (value == "back") {
+        options.cull_mode = yasr::CullMode::back;
+      } else {
+        valid = false;
+      }
+    } else if (name == "--samples") {
+      set_count(options.sample_count);
+      valid = valid && (options.sample_count == 1 ||
+                        options.sample_count == yasr::msaa_sample_count);
+    } else if (name == "--shading") {
+      valid = value == "textured" || value == "normals";
+      options.shade_normals = value == "normals";
+    } else if (name == "--lights") {
+      set_count(options.light_count);
+    } else if (name == "--orbit") {
+      const auto degrees = parse_number(value);
+      valid = degrees.has_value();
+      if (degrees) { options.orbit_degrees = *degrees; }
+    } else if (name == "--frames") {
+      set_count(options.frame_count);
+    } else if (name == "--threads") {
+      set_count(options.thread_count);
+    } else if (name == "--output") {
+      options.output = value;
+    } else if (name == "--trace") {
+      options.trace = value;
+    } else {
+      spdlog::error("Unknown option {}", name);
+      return std::nullopt;
+    }
+
+    if (!valid) {
+      spdlog::error("Invalid value {} of {}", value, name);
+      return std::nullopt;
+    }
+  }
+
+  if (options.width == 0 || options.height == 0) {
+    spdlog::error("The frame size must not be empty");
+    return std::nullopt;
+  }
+  if (options.light_count > 0 &&
+      (options.shade_normals || options.sample_count != 1)) {
+    spdlog::error("Point lights need textured shading and 1 sample");
+    return std::nullopt;
+  }
+  if (options.wireframe &&
+      (options.light_count > 0 || options.sample_count != 1)) {
+    spdlog::error("Wireframes need 1 sample and no point lights");
+    return std::nullopt;
+  }
+  if (options.output != "-" && !yasr::image_file_format(options.output)) {
+    spdlog::error("Unknown image format of {}", options.output);
+    return std::nullopt;
+  }
+  if (options.frame_count > 1 && options.output != "-" &&
+      options.output.find('#') == std::string::npos) {
+    spdlog::error("The output of several frames needs a # in its path");
+    return std::nullopt;
+  }
+  return options;
+}
+
+/// Replaces the first run of '#' in `pattern` by the zero-padded `frame`
+auto frame_path(const std::string& pattern, std::uint32_t frame) -> std::string
+{
+  const auto first = pattern.find('#');
+  if (first == std::string::npos) { return pattern; }
+  const auto last = std::min(pattern.find_first_not_of('#', first),
+                             pattern.size());
+
+  std::string number = std::to_string(frame);
+  if (number.size() < last - first) {
+    number.insert(0, last - first - number.size(), '0');
+  }
+  return pattern.substr(0, first) + number + pattern.substr(last);
+}
+
+/// The camera of `frame`, rotated around the target's vertical axis
+auto orbit_camera(const Options& options, std::uint32_t frame) -> yasr::Camera
+{
+  yasr::Camera camera = options.camera;
+  const float angle = options.orbit_degrees * static_cast<float>(frame) *
+                      beyond::float_constants::pi / 180.f;
+  const beyond::Vec3 offset = camera.eye - camera.target;
+  const float cos_angle = std::cos(angle);
+  const float sin_angle = std::sin(angle);
+  camera.eye = camera.target + beyond::Vec3{
+                                   offset.x * cos_angle + offset.z * sin_angle,
+                                   offset.y,
+                                   offset.z * cos_angle - offset.x * sin_angle,
+                               };
+  return camera;
+}
+
+/// Point lights of different hues, evenly spaced on a ring around the target
+auto make_point_lights(const Options& options) -> std::vector<yasr::PointLight>
+{
+  const std::uint32_t count = options.light_count;
+  constexpr float ring_radius = 1.2f;
+  std::vector<yasr::PointLight> lights;
+  lights.reserve(count);
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const float turn = static_cast<float>(i) / static_cast<float>(count);
+    const float angle = 2 * beyond::float_constants::pi * turn;
+    const auto hue = [&](float offset) {
+      return 0.5f + 0.5f * std::cos(2 * beyond::float_constants::pi *
+                                    (turn + offset));
+    };
+    lights.push_back(yasr::PointLight{
+        .position = options.camera.target +
+                    beyond::Vec3{ring_radius * std::cos(angle), 0,
+                                 ring_radius * std::sin(angle)},
+        .color = RGB{hue(0), hue(1.f / 3), hue(2.f / 3)},
+        .radius = 1,
+    });
+  }
+  return lights;
+}
+
+struct NormalUniforms {
+  beyond::Mat4 mvp;
+};
+
+struct NormalVaryings {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+};
+
+/// A pipeline that maps the interpolated normal to a color
+auto make_normal_pipeline() -> std::unique_ptr<yasr::PipelineProgram>
+{
+  return yasr::make_pipeline<NormalUniforms, NormalVaryings>(
+      [](const Vertex& vertex, const NormalUniforms& uniforms) {
+        return yasr::ShadedVertex<NormalVaryings>{
+            .position = yasr::transform_to_clip(uniforms.mvp, vertex.pos),
+            .varyings = {vertex.normal.x, vertex.normal.y, vertex.normal.z},
+        };
+      },
+      [](const NormalVaryings& normal, const NormalUniforms& /*uniforms*/,
+         const yasr::TextureView& /*texture*/) {
+        return RGB{normal.x * 0.5f + 0.5f, normal.y * 0.5f + 0.5f,
+                   normal.z * 0.5f + 0.5f};
+      });
+}
+
+auto load_texture(yasr::Device& device, const std::string& filename)
+    -> yasr::UniqueTexture
+{
+  int texture_width = 0;
+  int texture_height = 0;
+  int texture_channels = 0;
+  stbi_uc* texels = stbi_load(filename.c_str(), &texture_width,
+                              &texture_height, &texture_channels, 4);
+  if (texels == nullptr) {
+    beyond::panic(fmt::format("Cannot load texture {}: {}", filename,
+                              stbi_failure_reason()));
+  }
+  auto texture = yasr::create_unique_texture(
+      device,
+      yasr::TextureDesc{
+          .width = static_cast<std::uint32_t>(texture_width),
+          .height = static_cast<std::uint32_t>(texture_height),
+          .format = yasr::TextureFormat::rgba8_srgb,
+          .data = std::span(beyond::bit_cast<std::byte*>(texels),
+                            static_cast<std::size_t>(texture_width) *
+                                texture_height * 4)});
+  stbi_image_free(texels);
+  return texture;
+}
+
+void log_frame_stats(std::uint32_t frame, const yasr::PipelineStats& stats,
+                     const yasr::Profiler::StageTimes& times)
+{
+  std::string stages;
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    stages += fmt::format(
+        " {} {:.3f}", yasr::stage_name(static_cast<yasr::PipelineStage>(i)),
+        std::chrono::duration<double, std::milli>(times[i]).count());
+  }
+  spdlog::info("Frame {}: {} triangles, {} culled, {} clipped, {} culled by "
+               "Hi-Z, {} of {} fragments passed, {} shaded, {} texels, {} of "
+               "{} binned lights culled; ms:{}",
+               frame, stats.triangles_submitted, stats.triangles_culled,
+               stats.triangles_clipped, stats.hiz_triangles_culled,
+               stats.fragments_passed, stats.fragments_tested,
+               stats.fragments_shaded, stats.texels_fetched,
+               stats.lights_culled, stats.lights_binned, stages);
+}
+
+} // anonymous namespace
+
+auto main(int argc, char** argv) -> int
+{
+  // stdout may carry the frames, so logs go to stderr
+  spdlog::set_default_logger(spdlog::stderr_color_mt("headless"));
+
+  const std::optional<Options> parsed = parse_options(argc, argv);
+  if (!parsed) {
+    std::fputs(usage, stderr);
+    return EXIT_FAILURE;
+  }
+  const Options& options = *parsed;
+  const bool stream = options.output == "-";
+#ifdef _WIN32
+  if (stream) { _setmode(_fileno(stdout), _O_BINARY); }
+#endif
+
+  const auto device = yasr::Device::create(
+      yasr::DeviceDesc{.thread_count = options.thread_count});
+  yasr::Profiler& profiler = device->profiler();
+  profiler.set_tracing(!options.trace.empty());
+
+  const yasr::CachedMesh mesh = yasr::load_cached_mesh(options.model);
+  auto vertex_buffer = yasr::create_unique_buffer(
+      *device, yasr::BufferDesc{.data = std::as_bytes(mesh.vertices())});
+  auto index_buffer = yasr::create_unique_buffer(
+      *device, yasr::BufferDesc{.data = std::as_bytes(mesh.indices())});
+  auto diffuse_texture = load_texture(*device, options.texture);
+  const std::vector<std::uint32_t> edges =
+      options.wireframe ? yasr::wireframe_indices(mesh.indices())
+                        : std::vector<std::uint32_t>{};
+  auto edge_buffer = yasr::create_unique_buffer(
+      *device, yasr::BufferDesc{.data = std::as_bytes(std::span{edges})});
+  const std::vector<yasr::PointLight> lights =
+      make_point_lights(options);
+  auto light_buffer = yasr::create_unique_buffer(
+      *device, yasr::BufferDesc{.data = std::as_bytes(std::span{lights})});
+
+  // Frames alternate between two framebuffers, so the previous frame is
+  // encoded while the device renders the next one. Only OpenEXR keeps float
+  // colors.
+  const bool float_output =
+      !stream &&
+      yasr::image_file_format(options.output) == yasr::ImageFileFormat::exr;
+  const yasr::FramebufferDesc framebuffer_desc{
+      .width = options.width,
+      .height = options.height,
+      .format = float_output ? yasr::ColorFormat::rgb32_float
+                             : yasr::ColorFormat::rgba8_srgb,
+      .sample_count = options.sample_count,
+      .g_buffer = options.light_count > 0};
+  std::array framebuffers{
+      yasr::create_unique_framebuffer(*device, framebuffer_desc),
+      yasr::create_unique_framebuffer(*device, framebuffer_desc),
+  };
+  // The uniforms of a frame, alternating like the framebuffers. Each frame
+  // rewrites its buffer from its command buffer.
+  const yasr::BufferDesc constant_buffer_desc{.data = {},
+                                              .size = sizeof(NormalUniforms)};
+  std::array constant_buffers{
+      yasr::create_unique_buffer(*device, constant_buffer_desc),
+      yasr::create_unique_buffer(*device, constant_buffer_desc),
+  };
+  auto normal_pipeline =
+      yasr::create_unique_pipeline(*device, make_normal_pipeline());
+
+  std::vector<std::uint8_t> encoded;
+  const auto present = [&](std::uint32_t frame) {
+    const yasr::ColorView color =
+        device->framebuffer_color(framebuffers[frame % 2]);
+    const yasr::ScopedTimer timer{profiler, yasr::PipelineStage::present};
+    if (stream) {
+      yasr::encode_rgb8(color, encoded);
+      return yasr::write_raw_rgb8(stdout, encoded);
+    }
+    const std::string path = frame_path(options.output, frame);
+    if (!yasr::write_image(path, *yasr::image_file_format(path), color,
+                           encoded)) {
+      spdlog::error("Cannot write {}", path);
+      return false;
+    }
+    return true;
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t frame = 0; frame < options.frame_count; ++frame) {
+    const yasr::Camera camera = orbit_camera(options, frame);
+    const float aspect = static_cast<float>(options.width) /
+                         static_cast<float>(options.height);
+    const NormalUniforms uniforms{.mvp = yasr::view_projection(camera, aspect)};
+    yasr::UniqueBuffer& constant_buffer = constant_buffers[frame % 2];
+
+    yasr::CommandBuffer commands = device->acquire_command_buffer();
+    commands.update_buffer(constant_buffer, 0,
+                           std::as_bytes(std::span{&uniforms, 1}));
+    commands.bind_framebuffer(framebuffers[frame % 2]);
+    commands.bind_vertex_buffer(vertex_buffer);
+    commands.bind_index_buffer(index_buffer);
+    commands.bind_texture(diffuse_texture);
+    commands.set_cull_mode(options.cull_mode);
+    commands.set_shading_mode(options.shading_mode);
+    if (options.shade_normals) { commands.bind_pipeline(normal_pipeline); }
+    commands.bind_constant_buffer(constant_buffer);
+    commands.set_camera(camera);
+    commands.clear(yasr::ClearValue{});
+    commands.draw_indexed();
+    if (options.light_count > 0) {
+      commands.shade_lights(light_buffer, options.light_count);
+    }
+    if (options.wireframe) {
+      commands.bind_index_buffer(edge_buffer);
+      commands.set_topology(yasr::Topology::lines);
+      commands.draw_indexed();
+    }
+
+    device->begin_frame();
+    const yasr::Fence fence = device->submit(std::move(commands));
+    // Presenting the previous frame overlaps this one, so its time is counted
+    // here
+    if (frame > 0 && !present(frame - 1)) { return EXIT_FAILURE; }
+    device->wait(fence);
+    if (options.stats) {
+      log_frame_stats(frame, device->pipeline_stats(), profiler.stage_times());
+    }
+  }
+  if (options.frame_count > 0 && !present(options.frame_count - 1)) {
+    return EXIT_FAILURE;
+  }
+  if (stream) { std::fflush(stdout); }
+  if (!options.trace.empty() && !profiler.write_chrome_trace(options.trace)) {
+    spdlog::error("Cannot write {}", options.trace);
+    return EXIT_FAILURE;
+  }
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  spdlog::info("{} frames of {}x{} in {:.3f} s, {:.1f} frames/s",
+               options.frame_count, options.width, options.height,
+               elapsed.count(), options.frame_count / elapsed.count());
+  return EXIT_SUCCESS;
+}
@@ -1,4 +1,4 @@
-#include "common/app.hpp"
+#include "app.hpp"
 
 #include <functional>
 
@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include "buffer_allocator.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace {
+
+[[nodiscard]] auto is_aligned(const std::byte* memory) -> bool
+{
+  return reinterpret_cast<std::uintptr_t>(memory) %
+             yasr::BufferAllocator::alignment ==
+         0;
+}
+
+} // anonymous namespace
+
+TEST_CASE("BufferAllocator hands out aligned blocks and reuses freed ones")
+{
+  yasr::BufferAllocator allocator;
+  REQUIRE(allocator.allocate(0).empty());
+
+  const auto small = allocator.allocate(100);
+  const auto other = allocator.allocate(128);
+  REQUIRE(small.size() == 100);
+  REQUIRE(is_aligned(small.data()));
+  REQUIRE(is_aligned(other.data()));
+  REQUIRE(other.data() != small.data());
+  REQUIRE(allocator.reserved_bytes() == yasr::BufferAllocator::arena_size);
+
+  allocator.deallocate(small);
+  REQUIRE(allocator.allocate(120).data() == small.data());
+
+  const std::size_t large_size = yasr::BufferAllocator::max_block_size + 1;
+  const auto large = allocator.allocate(large_size);
+  REQUIRE(is_aligned(large.data()));
+  REQUIRE(allocator.reserved_bytes() ==
+          yasr::BufferAllocator::arena_size + large_size);
+  allocator.deallocate(large);
+  REQUIRE(allocator.reserved_bytes() == yasr::BufferAllocator::arena_size);
+}
+
+TEST_CASE("External buffers read the caller's memory without copying")
+{
+  const auto device = yasr::Device::create({.thread_count = 1});
+  const std::array vertices{
+      Vertex{.pos = {-1, -1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+      Vertex{.pos = {1, -1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+      Vertex{.pos = {0, 1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+  };
+  constexpr std::array<std::uint32_t, 3> indices{0, 1, 2};
+  constexpr std::array<std::uint8_t, 4> white_texel{255, 255, 255, 255};
+  std::array<yasr::DrawIndexedIndirectCommand, 1> draws{};
+  draws[0].index_count = 0;
+
+  const auto external = [&](std::span<const std::byte> data) {
+    return yasr::create_unique_buffer(
+        *device, {.data = data, .memory = yasr::BufferMemory::external});
+  };
+  auto vertex_buffer = external(std::as_bytes(std::span{vertices}));
+  auto index_buffer = external(std::as_bytes(std::span{indices}));
+  auto argument_buffer = external(std::as_bytes(std::span{draws}));
+  auto texture = yasr::create_unique_texture(
+      *device, {.width = 1,
+                .height = 1,
+                .data = std::as_bytes(std::span{white_texel})});
+  auto framebuffer =
+      yasr::create_unique_framebuffer(*device, {.width = 8, .height = 8});
+
+  // A copy made at creation would still draw nothing
+  draws[0].index_count = 3;
+
+  device->begin_frame();
+  device->bind_framebuffer(framebuffer);
+  device->bind_vertex_buffer(vertex_buffer);
+  device->bind_index_buffer(index_buffer);
+  device->bind_texture(texture);
+  device->set_cull_mode(yasr::CullMode::none);
+  device->draw_indexed_indirect(argument_buffer, 1);
+  REQUIRE(device->pipeline_stats().triangles_submitted == 1);
+  REQUIRE(device->pipeline_stats().fragments_passed > 0);
+}
@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+
+#include "clipping.hpp"
+
+#include <array>
+
+namespace {
+
+auto clip_vertex(float x, float y, float z, float w) -> beyond::Vec4
+{
+  return beyond::Vec4{x, y, z, w};
+}
+
+} // anonymous namespace
+
+TEST_CASE("clip_flags classifies against the frustum and the guard band")
+{
+  const yasr::GuardBand band{.x = 4, .y = 2};
+  REQUIRE(yasr::clip_flags(0, 0, 0, 1, band) == 0);
+  REQUIRE(yasr::clip_flags(-2, 0, 0, 1, band) == yasr::clip_left);
+  REQUIRE(yasr::clip_flags(0, 3, 0, 1, band) ==
+          (yasr::clip_top | yasr::clip_guard_band));
+  REQUIRE(yasr::clip_flags(0, 0, -2, 1, band) == yasr::clip_near);
+  REQUIRE(yasr::clip_flags(0, 0, 2, 1, band) == yasr::clip_far);
+}
+
+TEST_CASE("guard_band covers at least the viewport")
+{
+  const yasr::GuardBand small = yasr::guard_band({{0, 0}, {1024, 512}});
+  REQUIRE(small.x == 16);
+  REQUIRE(small.y == 32);
+  const yasr::GuardBand large = yasr::guard_band({{0, 0}, {32768, 16}});
+  REQUIRE(large.x == 1);
+}
+
+TEST_CASE("clip_triangle keeps triangles inside the guard band")
+{
+  const std::array triangle{clip_vertex(-1, -1, 0, 1),
+                            clip_vertex(3, -1, 0, 1),
+                            clip_vertex(0, 3, 0, 1)};
+  const yasr::ClipPolygon polygon =
+      yasr::clip_triangle(triangle, {.x = 4, .y = 4});
+  REQUIRE(polygon.size == 3);
+  for (std::size_t i = 0; i < 3; ++i) {
+    REQUIRE(polygon.vertices[i].pos.x == triangle[i].x);
+    REQUIRE(polygon.vertices[i].pos.y == triangle[i].y);
+  }
+}
+
+TEST_CASE("clip_triangle cuts off the part behind the near plane")
+{
+  // The last vertex is behind the camera, with w < 0
+  const yasr::GuardBand band{.x = 4, .y = 4};
+  const std::array triangle{clip_vertex(0, 0, 0, 1), clip_vertex(1, 0, 0, 1),
+                            clip_vertex(0, 1, -3, -1)};
+  const yasr::ClipPolygon polygon = yasr::clip_triangle(triangle, band);
+  REQUIRE(polygon.size == 4);
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    const auto& [pos, weights] = polygon.vertices[i];
+    CAPTURE(i);
+    REQUIRE(pos.w > 0);
+    REQUIRE(pos.z + pos.w >= Approx(0).margin(1e-6));
+    // The weights reproduce the clipped position
+    REQUIRE(yasr::interpolate(triangle[0].w, triangle[1].w, triangle[2].w,
+                              weights) == Approx(pos.w));
+  }
+
+  const std::array behind{clip_vertex(0, 0, -3, -1), clip_vertex(1, 0, -3, -1),
+                          clip_vertex(0, 1, -3, -1)};
+  REQUIRE(yasr::clip_triangle(behind, band).size == 0);
+}
+
+TEST_CASE("clip_triangle brings huge triangles inside the guard band")
+{
+  const yasr::GuardBand band{.x = 2, .y = 2};
+  const std::array triangle{clip_vertex(-100, -100, 0, 1),
+                            clip_vertex(100, -100, 0, 1),
+                            clip_vertex(0, 100, 0, 1)};
+  const yasr::ClipPolygon polygon = yasr::clip_triangle(triangle, band);
+  REQUIRE(polygon.size >= 3);
+  for (std::size_t i = 0; i < polygon.size; ++i) {
+    const auto& pos = polygon.vertices[i].pos;
+    CAPTURE(i);
+    REQUIRE(std::abs(pos.x) <= Approx(band.x * pos.w));
+    REQUIRE(std::abs(pos.y) <= Approx(band.y * pos.w));
+  }
+}
+
+TEST_CASE("outside_frustum rejects spheres behind a single plane")
+{
+  const beyond::Mat4 identity = beyond::Mat4::identity();
+  REQUIRE_FALSE(yasr::outside_frustum(identity, {.center = {0, 0, 0},
+                                                 .radius = 0.5f}));
+  REQUIRE(yasr::outside_frustum(identity, {.center = {3, 0, 0},
+                                           .radius = 1}));
+  REQUIRE_FALSE(yasr::outside_frustum(identity, {.center = {1.5f, 0, 0},
+                                                 .radius = 1}));
+  REQUIRE(yasr::outside_frustum(identity, {.center = {0, 0, -2.5f},
+                                           .radius = 1}));
+}
+
+TEST_CASE("clip_line_near moves the end behind the near plane onto it")
+{
+  beyond::Vec4 a = clip_vertex(0, 0, 0, 1);
+  beyond::Vec4 b = clip_vertex(2, 0, -3, 1);
+  REQUIRE(yasr::clip_line_near(a, b));
+  REQUIRE(a.x == 0.f);
+  REQUIRE(b.x == Approx(2.f / 3));
+  REQUIRE(b.z == Approx(-1));
+
+  beyond::Vec4 c = clip_vertex(0, 0, -2, 1);
+  beyond::Vec4 d = clip_vertex(1, 0, -3, 1);
+  REQUIRE_FALSE(yasr::clip_line_near(c, d));
+}
+
+TEST_CASE("clip_line keeps the part of a line inside the rectangle")
+{
+  const yasr::Rect rect{{0, 0}, {10, 10}};
+
+  beyond::Point3 a{-5, 5, 0};
+  beyond::Point3 b{15, 5, 1};
+  REQUIRE(yasr::clip_line(a, b, rect));
+  REQUIRE(a.x == 0.f);
+  REQUIRE(a.z == Approx(0.25f));
+  REQUIRE(b.x == 10.f);
+  REQUIRE(b.z == Approx(0.75f));
+
+  // Across a corner of the rectangle, outside it
+  beyond::Point3 c{-5, 4, 0};
+  beyond::Point3 d{4, -5, 0};
+  REQUIRE_FALSE(yasr::clip_line(c, d, rect));
+
+  beyond::Point3 e{2, 3, 0};
+  beyond::Point3 f{7, 8, 0};
+  REQUIRE(yasr::clip_line(e, f, rect));
+  REQUIRE(e.x == 2.f);
+  REQUIRE(f.y == 8.f);
+}
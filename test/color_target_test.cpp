@@ -0,0 +1,72 @@
+#include <catch2/catch.hpp>
+
+#include "color_target.hpp"
+#include "framebuffer.hpp"
+#include "image_io.hpp"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+TEST_CASE("The sRGB table is within one code of the exact encoding")
+{
+  constexpr int steps = 100000;
+  for (int i = 0; i <= steps; ++i) {
+    const float c = static_cast<float>(i) / steps;
+    const long exact = std::lround(yasr::encode_srgb(c) * 255);
+    const long table = yasr::encode_srgb8(c);
+    REQUIRE(std::abs(exact - table) <= 1);
+  }
+
+  REQUIRE(yasr::encode_srgb8(-1.f) == 0);
+  REQUIRE(yasr::encode_srgb8(2.f) == 255);
+  REQUIRE(yasr::encode_srgb8(std::numeric_limits<float>::quiet_NaN()) == 0);
+}
+
+TEST_CASE("8-bit color targets store and load encoded colors")
+{
+  const auto format = GENERATE(yasr::ColorFormat::rgba8_srgb,
+                               yasr::ColorFormat::bgra8_srgb);
+  std::array<std::uint32_t, 4> pixels{};
+  const yasr::ColorTarget target{
+      .format = format, .width = 2, .height = 2, .pixels = pixels.data()};
+  target.store(1, 1, RGB{1, 0, 0.5f});
+
+  const RGB color = target.view().load(1, 1);
+  REQUIRE(color.r == 1.f);
+  REQUIRE(color.g == 0.f);
+  REQUIRE(color.b == Approx(yasr::encode_srgb(0.5f)).margin(1 / 255.f));
+  REQUIRE(target.view().load(0, 0).r == 0.f);
+}
+
+TEST_CASE("RGBA8 pixels lie in memory in RGBA order")
+{
+  const std::uint32_t pixel =
+      yasr::pack_rgba8(yasr::ColorFormat::rgba8_srgb, 1, 2, 3, 4);
+  const auto bytes = std::bit_cast<std::array<std::uint8_t, 4>>(pixel);
+  REQUIRE(bytes == std::array<std::uint8_t, 4>{1, 2, 3, 4});
+}
+
+TEST_CASE("Packed framebuffers encode to the same bytes as float ones")
+{
+  const yasr::ClearValue clear{.color = RGB(0.2f, 0.5f, 0.8f)};
+  yasr::FramebufferStorage float_framebuffer{3, 2};
+  yasr::FramebufferStorage packed_framebuffer{3, 2,
+                                              yasr::ColorFormat::bgra8_srgb};
+  float_framebuffer.clear(clear);
+  packed_framebuffer.clear(clear);
+  float_framebuffer.resolve_all_clears();
+  packed_framebuffer.resolve_all_clears();
+
+  std::vector<std::uint8_t> from_float;
+  std::vector<std::uint8_t> from_packed;
+  yasr::encode_rgb8(float_framebuffer.color_view(), from_float);
+  yasr::encode_rgb8(packed_framebuffer.color_view(), from_packed);
+  REQUIRE(from_float.size() == 3 * 2 * 3);
+  for (std::size_t i = 0; i < from_float.size(); ++i) {
+    REQUIRE(std::abs(from_float[i] - from_packed[i]) <= 1);
+  }
+}
@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+
+#include "render_test_util.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using yasr::test::QuadScene;
+using yasr::test::same_pixels;
+
+constexpr std::uint32_t frame_size = 32;
+
+/// A textured quad in the bottom-left quarter of the frame
+auto make_scene(yasr::Device& device) -> QuadScene
+{
+  return yasr::test::make_quad_scene(device, frame_size,
+                                     {.min = -1, .max = 0});
+}
+
+void record_scene(yasr::CommandBuffer& commands, QuadScene& scene,
+                  yasr::Framebuffer framebuffer)
+{
+  scene.record(commands);
+  commands.bind_framebuffer(framebuffer);
+  commands.set_cull_mode(yasr::CullMode::none);
+  commands.clear(yasr::ClearValue{.color = RGB(0, 0, 1)});
+  commands.draw_indexed();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Submitted command buffers render like immediate calls")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  QuadScene scene = make_scene(*device);
+  auto submitted = yasr::create_unique_framebuffer(
+      *device, {.width = frame_size, .height = frame_size});
+
+  scene.bind(*device);
+  device->set_cull_mode(yasr::CullMode::none);
+  device->clear(yasr::ClearValue{.color = RGB(0, 0, 1)});
+  device->draw_indexed();
+
+  yasr::CommandBuffer commands = device->acquire_command_buffer();
+  record_scene(commands, scene, submitted);
+  device->begin_frame();
+  const yasr::Fence fence = device->submit(std::move(commands));
+  device->wait(fence);
+  REQUIRE(device->is_signaled(fence));
+  REQUIRE(device->pipeline_stats().triangles_submitted == 2);
+  REQUIRE(device->pipeline_stats().fragments_passed > 0);
+
+  const Image& expected = device->framebuffer_image(scene.framebuffer);
+  const Image& image = device->framebuffer_image(submitted);
+  REQUIRE(same_pixels(image, expected));
+}
+
+TEST_CASE("Submissions run in order and keep the immediate bindings")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  REQUIRE(device->is_signaled(yasr::Fence{}));
+
+  QuadScene scene = make_scene(*device);
+  std::vector<yasr::UniqueFramebuffer> framebuffers;
+  std::vector<yasr::Fence> fences;
+  for (int i = 0; i < 3; ++i) {
+    framebuffers.push_back(yasr::create_unique_framebuffer(
+        *device, {.width = frame_size, .height = frame_size}));
+  }
+  device->bind_framebuffer(framebuffers[0]);
+
+  for (auto& framebuffer : framebuffers) {
+    yasr::CommandBuffer commands = device->acquire_command_buffer();
+    record_scene(commands, scene, framebuffer);
+    fences.push_back(device->submit(std::move(commands)));
+  }
+  REQUIRE(fences[0].id < fences[1].id);
+  device->wait(fences.back());
+  for (const yasr::Fence fence : fences) {
+    REQUIRE(device->is_signaled(fence));
+  }
+
+  // The last submission bound another framebuffer, the immediate clear still
+  // targets the one bound by the immediate call
+  device->clear(yasr::ClearValue{.color = RGB(1, 0, 0)});
+  REQUIRE(device->framebuffer_image(framebuffers[0]).unsafe_at(0, 0).r == 1.f);
+  REQUIRE(device->framebuffer_image(framebuffers[1]).unsafe_at(0, 0).r == 0.f);
+}
+
+TEST_CASE("Command buffers that have run are handed out again")
+{
+  const auto device = yasr::Device::create({.thread_count = 1});
+  QuadScene scene = make_scene(*device);
+
+  yasr::CommandBuffer commands = device->acquire_command_buffer();
+  REQUIRE(commands.commands().empty());
+  record_scene(commands, scene, scene.framebuffer);
+  const yasr::Command* const storage = commands.commands().data();
+  device->wait(device->submit(std::move(commands)));
+
+  // Reset, with the storage of the submission
+  const yasr::CommandBuffer recycled = device->acquire_command_buffer();
+  REQUIRE(recycled.commands().empty());
+  REQUIRE(recycled.commands().data() == storage);
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include "rasterizer.hpp"
+#include "render_test_util.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+namespace {
+
+constexpr std::uint32_t frame_size = 64;
+
+/// A gray quad facing the camera, drawn into a G-buffer and lit by `lights`
+auto shade_quad(yasr::Device& device, std::span<const yasr::PointLight> lights)
+    -> Image
+{
+  // Dark enough that the lights do not saturate the color attachment
+  auto scene = yasr::test::make_quad_scene(
+      device, frame_size,
+      {.texel = {128, 128, 128, 255}, .g_buffer = true});
+  auto light_buffer = yasr::create_unique_buffer(
+      device, {.data = std::as_bytes(lights)});
+
+  scene.bind(device);
+  device.set_camera(yasr::Camera{.eye = {0, 0, 3}});
+  device.clear(yasr::ClearValue{});
+  device.draw_indexed();
+  device.shade_lights(light_buffer,
+                      static_cast<std::uint32_t>(lights.size()));
+  return device.framebuffer_image(scene.framebuffer);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Packed normals keep their direction")
+{
+  const std::array normals{
+      beyond::Vec3{0, 0, 1},
+      beyond::Vec3{0, 0, -1},
+      beyond::Vec3{1, 0, 0},
+      beyond::Vec3{0, -1, 0},
+      beyond::Vec3{0.6f, 0, -0.8f},
+      beyond::Vec3{-0.48f, 0.6f, -0.64f},
+  };
+  for (const beyond::Vec3& normal : normals) {
+    const beyond::Vec3 unpacked =
+        yasr::unpack_normal(yasr::pack_normal(normal));
+    REQUIRE(beyond::dot(normal, unpacked) > std::cos(1e-3f));
+  }
+}
+
+TEST_CASE("Deferred shading adds the point lights to the directional light")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  const Image sun_only = shade_quad(*device, {});
+  // The quad covers the middle of the frame, and the background keeps the
+  // clear color
+  REQUIRE(sun_only.unsafe_at(0, 0).r == 0.f);
+  const RGB lit = sun_only.unsafe_at(32, 32);
+  REQUIRE(lit.r > 0.f);
+  REQUIRE(lit.r == lit.g);
+
+  // A red light close to the left of the quad
+  const std::array lights{yasr::PointLight{
+      .position = {-0.8f, 0, 0.3f}, .color = {4, 0, 0}, .radius = 0.6f}};
+  const Image image = shade_quad(*device, lights);
+  const RGB left = image.unsafe_at(17, 32);
+  const RGB right = image.unsafe_at(46, 32);
+  REQUIRE(left.r > left.g);
+  REQUIRE(left.g == Approx(lit.g));
+  REQUIRE(right.r == Approx(lit.r));
+}
+
+TEST_CASE("Deferred shading culls lights by the depth of the pixels")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  // Both lights overlap the tile of the quad on screen, but the second one is
+  // far behind it
+  const std::array lights{
+      yasr::PointLight{
+          .position = {0, 0, 0.5f}, .color = {1, 1, 1}, .radius = 1},
+      yasr::PointLight{
+          .position = {0, 0, -3}, .color = {1, 1, 1}, .radius = 0.5f}};
+  device->begin_frame();
+  static_cast<void>(shade_quad(*device, lights));
+  const yasr::PipelineStats stats = device->pipeline_stats();
+  REQUIRE(stats.lights_binned == 2);
+  REQUIRE(stats.lights_culled == 1);
+}
@@ -0,0 +1,50 @@
+#include <catch2/catch.hpp>
+
+#include "dynamic_resolution.hpp"
+
+#include <cmath>
+
+using Milliseconds = yasr::DynamicResolution::Milliseconds;
+
+namespace {
+
+/// Runs `frames` frames whose time grows with the pixels of the scale
+auto run_frames(yasr::DynamicResolution& resolution,
+                Milliseconds full_resolution_time, int frames) -> float
+{
+  for (int i = 0; i < frames; ++i) {
+    const float scale = resolution.scale();
+    resolution.update(full_resolution_time * scale * scale);
+  }
+  return resolution.scale();
+}
+
+} // anonymous namespace
+
+TEST_CASE("Dynamic resolution scales the pixels to the target frame time")
+{
+  yasr::DynamicResolution resolution{{.target_frame_time = Milliseconds{10}}};
+  REQUIRE(resolution.scale() == 1.f);
+
+  // Twice the target at full resolution, half the pixels hit it
+  const float scale = run_frames(resolution, Milliseconds{20}, 100);
+  REQUIRE(scale * scale == Approx(0.5f).epsilon(0.1));
+  REQUIRE(resolution.scaled(1000) ==
+          static_cast<std::uint32_t>(std::lround(1000 * scale)));
+
+  // Settled within the tolerance
+  REQUIRE(run_frames(resolution, Milliseconds{20}, 100) == scale);
+
+  // Cheaper frames go back to the full resolution, but not above
+  REQUIRE(run_frames(resolution, Milliseconds{5}, 100) == 1.f);
+}
+
+TEST_CASE("Dynamic resolution stays within its bounds")
+{
+  yasr::DynamicResolution resolution{{.target_frame_time = Milliseconds{10},
+                                      .min_scale = 0.25f,
+                                      .max_scale = 0.75f}};
+  REQUIRE(resolution.scale() == 0.75f);
+  REQUIRE(run_frames(resolution, Milliseconds{1000}, 100) == 0.25f);
+  REQUIRE(resolution.scaled(1) == 1);
+}
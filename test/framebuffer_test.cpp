@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include "framebuffer.hpp"
+#include "raster_kernel.hpp"
+
+TEST_CASE("FramebufferStorage tiles cover the attachments")
+{
+  const yasr::FramebufferStorage framebuffer{100, 70};
+  REQUIRE(framebuffer.tile_count_x() == 2);
+  REQUIRE(framebuffer.tile_count() == 4);
+
+  const yasr::Rect last = framebuffer.tile_rect(3);
+  REQUIRE(last.min.x == yasr::tile_size);
+  REQUIRE(last.min.y == yasr::tile_size);
+  REQUIRE(last.max.x == 100);
+  REQUIRE(last.max.y == 70);
+}
+
+TEST_CASE("FramebufferStorage clears are deferred until a tile is resolved")
+{
+  yasr::FramebufferStorage framebuffer{100, 70};
+  framebuffer.clear(yasr::ClearValue{.color = RGB(1, 0, 0), .depth = 0.5f});
+
+  const Image& color = framebuffer.color();
+  const int far_x = yasr::tile_size + 1;
+  const int far_y = yasr::tile_size + 1;
+  const auto far_index = static_cast<std::size_t>(far_y * 100 + far_x);
+
+  SECTION("Only the resolved tile is filled")
+  {
+    framebuffer.resolve_clear(0);
+    REQUIRE(color.unsafe_at(1, 1).r == 1.f);
+    REQUIRE(framebuffer.depth()[101] == 0.5f);
+    REQUIRE(framebuffer.coarse_depth()[0] == 0.5f);
+    REQUIRE(color.unsafe_at(far_x, far_y).r == 0.f);
+    REQUIRE(framebuffer.depth()[far_index] == yasr::ClearValue{}.depth);
+  }
+
+  SECTION("A resolved tile is not cleared again")
+  {
+    framebuffer.resolve_clear(0);
+    framebuffer.color().unsafe_at(1, 1) = RGB(0, 1, 0);
+    framebuffer.resolve_all_clears();
+    REQUIRE(color.unsafe_at(1, 1).g == 1.f);
+    REQUIRE(color.unsafe_at(far_x, far_y).r == 1.f);
+    REQUIRE(framebuffer.depth()[far_index] == 0.5f);
+  }
+}
+
+TEST_CASE("Multisampled framebuffers blend the samples of edge pixels")
+{
+  yasr::FramebufferStorage framebuffer{16, 16, yasr::ColorFormat::rgb32_float,
+                                       yasr::msaa_sample_count};
+  framebuffer.clear(yasr::ClearValue{.color = RGB(0, 0, 0)});
+  framebuffer.resolve_clear(0);
+
+  // A vertical edge through the pixel centres of column 4, which leaves two
+  // of their samples on each side
+  const auto vertex = [](float x, float y) {
+    return yasr::ScreenVertex{.pos = {x, y, 0}, .inv_w = 1, .uv = {}};
+  };
+  const auto setup = yasr::setup_triangle(
+      {vertex(-10, -10), vertex(4.5f, -10), vertex(4.5f, 40)},
+      framebuffer.tile_rect(0), RGB{});
+  REQUIRE(setup);
+
+  yasr::PipelineStats stats;
+  yasr::rasterize_triangle(
+      *setup, framebuffer.tile_rect(0), framebuffer.sample_target(0),
+      framebuffer.coarse_depth(),
+      [](const void*, const yasr::TriangleSetup& triangle,
+         const yasr::Rect& run, const yasr::SampleSteps& steps,
+         const yasr::SampleTarget& target) {
+        return yasr::detail::rasterize_run_multisampled(
+            triangle, run, steps, target,
+            [](float, float) { return RGB{1, 1, 1}; });
+      },
+      nullptr, stats);
+  framebuffer.resolve_samples(0);
+
+  const Image& color = framebuffer.color();
+  REQUIRE(color.unsafe_at(3, 5).r == 1.f);
+  REQUIRE(color.unsafe_at(4, 5).r == Approx(yasr::encode_srgb(0.5f)));
+  REQUIRE(color.unsafe_at(5, 5).r == 0.f);
+  // Every pixel of columns 0 to 4 is shaded once
+  REQUIRE(stats.fragments_passed == 5 * 16);
+}
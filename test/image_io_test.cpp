@@ -0,0 +1,25 @@
+#include <catch2/catch.hpp>
+
+#include "image_io.hpp"
+
+TEST_CASE("image_file_format follows the file extension")
+{
+  using yasr::ImageFileFormat;
+  REQUIRE(yasr::image_file_format("frame.png") == ImageFileFormat::png);
+  REQUIRE(yasr::image_file_format("out/frame_0001.PPM") ==
+          ImageFileFormat::ppm);
+  REQUIRE(yasr::image_file_format("a.b.exr") == ImageFileFormat::exr);
+  REQUIRE(!yasr::image_file_format("frame.jpg").has_value());
+  REQUIRE(!yasr::image_file_format("frame").has_value());
+}
+
+TEST_CASE("encode_rgb8 clamps and packs pixels row by row")
+{
+  Image image{2, 1};
+  image.unsafe_at(0, 0) = RGB(1, 0.5f, 0);
+  image.unsafe_at(1, 0) = RGB(2, -1, 0.25f);
+
+  std::vector<std::uint8_t> rgb8(100);
+  yasr::encode_rgb8(yasr::color_view(image), rgb8);
+  REQUIRE(rgb8 == std::vector<std::uint8_t>{255, 127, 0, 255, 0, 63});
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch.hpp>
+
+#include "render_test_util.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <beyond/math/transform.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace {
+
+using yasr::test::same_pixels;
+
+constexpr std::uint32_t frame_size = 32;
+
+/// Binds a quad drawn with the given instance transforms
+struct InstancedQuad {
+  yasr::test::QuadScene scene;
+  yasr::UniqueBuffer instance_buffer;
+
+  InstancedQuad(yasr::Device& device,
+                std::span<const beyond::Mat4> instance_transforms)
+      : scene{yasr::test::make_quad_scene(device, frame_size,
+                                          {.min = -1, .max = 0})},
+        instance_buffer{yasr::create_unique_buffer(
+            device, {.data = std::as_bytes(instance_transforms)})}
+  {
+  }
+
+  void bind(yasr::Device& device, yasr::Framebuffer framebuffer)
+  {
+    scene.bind(device);
+    device.bind_framebuffer(framebuffer);
+    device.bind_instance_buffer(instance_buffer);
+    device.set_cull_mode(yasr::CullMode::none);
+    device.clear(yasr::ClearValue{.color = RGB(0, 0, 1)});
+  }
+};
+
+} // anonymous namespace
+
+TEST_CASE("Indirect draws render like an instanced draw")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  const std::array transforms{beyond::translate(0, 0, 0),
+                              beyond::translate(0.5f, 0.5f, 0)};
+  InstancedQuad quad{*device, transforms};
+  auto& instanced = quad.scene.framebuffer;
+  auto indirect = yasr::create_unique_framebuffer(
+      *device, {.width = frame_size, .height = frame_size});
+
+  device->begin_frame();
+  quad.bind(*device, instanced);
+  device->draw_indexed_instanced(2);
+  REQUIRE(device->pipeline_stats().instances_submitted == 2);
+  REQUIRE(device->pipeline_stats().triangles_submitted == 4);
+
+  const std::array<yasr::DrawIndexedIndirectCommand, 2> draws{{
+      {.index_count = 6, .instance_count = 1, .first_instance = 0},
+      {.index_count = 6, .instance_count = 1, .first_instance = 1},
+  }};
+  auto argument_buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{draws})});
+  device->begin_frame();
+  quad.bind(*device, indirect);
+  device->draw_indexed_indirect(argument_buffer, draws.size());
+  REQUIRE(device->pipeline_stats().instances_submitted == 2);
+
+  REQUIRE(same_pixels(device->framebuffer_image(indirect),
+                      device->framebuffer_image(instanced)));
+}
+
+TEST_CASE("Instances outside the frustum are culled before shading")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  const std::array transforms{beyond::translate(0, 0, 0),
+                              beyond::translate(100, 0, 0)};
+  InstancedQuad quad{*device, transforms};
+
+  device->begin_frame();
+  quad.bind(*device, quad.scene.framebuffer);
+  device->draw_indexed_instanced(2);
+
+  const yasr::PipelineStats& stats = device->pipeline_stats();
+  REQUIRE(stats.instances_submitted == 2);
+  REQUIRE(stats.instances_culled == 1);
+  REQUIRE(stats.fragments_passed > 0);
+}
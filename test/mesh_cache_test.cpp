@@ -0,0 +1,47 @@
+#include <catch2/catch.hpp>
+
+#include "mesh_cache.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+TEST_CASE("Mesh caches round-trip and are invalidated by the source hash")
+{
+  const yasr::Mesh mesh{
+      .vertices =
+          {
+              Vertex{.pos = {0, 0, 0}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+              Vertex{.pos = {1, 0, 0}, .normal = {0, 0, 1}, .texcoord = {1, 0}},
+              Vertex{.pos = {0, 1, 0}, .normal = {0, 0, 1}, .texcoord = {0, 1}},
+          },
+      .indices = {0, 1, 2},
+  };
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "yasr_test.meshcache")
+          .string();
+  constexpr std::uint64_t source_hash = 42;
+  REQUIRE(yasr::write_mesh_cache(path, mesh, source_hash));
+
+  SECTION("A matching cache maps the mesh")
+  {
+    const auto cached = yasr::CachedMesh::open(path, source_hash);
+    REQUIRE(cached.has_value());
+    REQUIRE(cached->vertices().size() == 3);
+    REQUIRE(cached->vertices()[1].pos.x == 1.f);
+    REQUIRE(cached->vertices()[2].texcoord.y == 1.f);
+    REQUIRE(std::ranges::equal(cached->indices(), mesh.indices));
+  }
+
+  SECTION("A changed source invalidates the cache")
+  {
+    REQUIRE(!yasr::CachedMesh::open(path, source_hash + 1).has_value());
+  }
+
+  SECTION("A truncated cache is rejected")
+  {
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    REQUIRE(!yasr::CachedMesh::open(path, source_hash).has_value());
+  }
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,93 @@
+#include <catch2/catch.hpp>
+
+#include "model.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+namespace {
+
+auto make_vertex(float x, float y) -> Vertex
+{
+  return Vertex{.pos = {x, y, 0}, .normal = {0, 0, 1}, .texcoord = {x, y}};
+}
+
+/// A grid of `n` x `n` quads, indexed row by row
+auto make_grid(std::uint32_t n) -> yasr::Mesh
+{
+  yasr::Mesh mesh;
+  for (std::uint32_t y = 0; y <= n; ++y) {
+    for (std::uint32_t x = 0; x <= n; ++x) {
+      mesh.vertices.push_back(
+          make_vertex(static_cast<float>(x), static_cast<float>(y)));
+    }
+  }
+  for (std::uint32_t y = 0; y < n; ++y) {
+    for (std::uint32_t x = 0; x < n; ++x) {
+      const std::uint32_t v = y * (n + 1) + x;
+      for (const auto i : {v, v + 1, v + n + 1, v + 1, v + n + 2, v + n + 1}) {
+        mesh.indices.push_back(i);
+      }
+    }
+  }
+  return mesh;
+}
+
+/// Triangles rotated so the smallest index comes first, which keeps winding
+auto canonical_triangles(const yasr::Mesh& mesh)
+    -> std::vector<std::array<std::uint32_t, 3>>
+{
+  std::vector<std::array<std::uint32_t, 3>> triangles;
+  for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+    std::array<std::uint32_t, 3> t{mesh.indices[i], mesh.indices[i + 1],
+                                   mesh.indices[i + 2]};
+    std::ranges::rotate(t, std::ranges::min_element(t));
+    triangles.push_back(t);
+  }
+  std::ranges::sort(triangles);
+  return triangles;
+}
+
+} // anonymous namespace
+
+TEST_CASE("weld_vertices merges identical vertices")
+{
+  const std::array corners{make_vertex(0, 0), make_vertex(1, 0),
+                           make_vertex(1, 1), make_vertex(0, 1)};
+  yasr::Mesh quad;
+  for (const auto corner : {0, 1, 2, 0, 2, 3}) {
+    quad.vertices.push_back(corners[static_cast<std::size_t>(corner)]);
+    quad.indices.push_back(static_cast<std::uint32_t>(quad.indices.size()));
+  }
+
+  const yasr::Mesh welded = yasr::weld_vertices(quad);
+  REQUIRE(welded.vertices.size() == 4);
+  REQUIRE(welded.indices == std::vector<std::uint32_t>{0, 1, 2, 0, 2, 3});
+}
+
+TEST_CASE("optimize_vertex_cache reorders triangles for the cache")
+{
+  const yasr::Mesh grid = make_grid(32);
+  yasr::Mesh optimized = grid;
+  yasr::optimize_vertex_cache(optimized.indices, optimized.vertices.size());
+
+  REQUIRE(canonical_triangles(optimized) == canonical_triangles(grid));
+  REQUIRE(yasr::average_cache_miss_ratio(optimized.indices,
+                                         optimized.vertices.size()) <
+          yasr::average_cache_miss_ratio(grid.indices, grid.vertices.size()));
+}
+
+TEST_CASE("optimize_vertex_fetch numbers vertices in order of first use")
+{
+  yasr::Mesh mesh = make_grid(4);
+  std::ranges::reverse(mesh.indices);
+  yasr::optimize_vertex_fetch(mesh);
+
+  std::uint32_t next = 0;
+  for (const auto index : mesh.indices) {
+    REQUIRE(index <= next);
+    if (index == next) { ++next; }
+  }
+  REQUIRE(next == mesh.vertices.size());
+}
@@ -0,0 +1,208 @@
+#include <catch2/catch.hpp>
+
+#include "pipeline.hpp"
+#include "render_test_util.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr int frame_size = 64;
+
+struct Uniforms {
+  RGB color;
+};
+
+struct Varyings {
+  float u = 0;
+  float v = 0;
+};
+
+/// Passes the position through as normalized device coordinates
+auto pass_through(const Vertex& vertex, const Uniforms& /*uniforms*/)
+    -> yasr::ShadedVertex<Varyings>
+{
+  return {.position = {vertex.pos.x, vertex.pos.y, vertex.pos.z, 1},
+          .varyings = {vertex.texcoord.x, vertex.texcoord.y}};
+}
+
+auto make_vertex(float x, float y, float z, float u, float v) -> Vertex
+{
+  return Vertex{.pos = {x, y, z}, .normal = {0, 0, 1}, .texcoord = {u, v}};
+}
+
+/// Draws the bound buffers as triangles with `program` into `framebuffer`
+auto draw_bound(yasr::Device& device, yasr::Framebuffer framebuffer,
+                std::unique_ptr<yasr::PipelineProgram> program,
+                const Uniforms& uniforms, yasr::PipelineStats& stats) -> Image
+{
+  auto constant_buffer = yasr::create_unique_buffer(
+      device, {.data = std::as_bytes(std::span{&uniforms, 1})});
+  auto pipeline = yasr::create_unique_pipeline(device, std::move(program));
+
+  device.bind_constant_buffer(constant_buffer);
+  device.bind_pipeline(pipeline);
+  device.set_cull_mode(yasr::CullMode::none);
+  device.begin_frame();
+  device.clear(yasr::ClearValue{});
+  device.draw_indexed();
+  stats = device.pipeline_stats();
+  return device.framebuffer_image(framebuffer);
+}
+
+/// Draws `vertices` as triangles with `program` into a new framebuffer
+auto draw(std::unique_ptr<yasr::PipelineProgram> program,
+          const std::vector<Vertex>& vertices, const Uniforms& uniforms,
+          yasr::PipelineStats& stats) -> Image
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  std::vector<std::uint32_t> indices(vertices.size());
+  for (std::size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<std::uint32_t>(i);
+  }
+  auto vertex_buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{vertices})});
+  auto index_buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{indices})});
+  auto framebuffer = yasr::create_unique_framebuffer(
+      *device, {.width = frame_size, .height = frame_size});
+
+  device->bind_vertex_buffer(vertex_buffer);
+  device->bind_index_buffer(index_buffer);
+  device->bind_framebuffer(framebuffer);
+  return draw_bound(*device, framebuffer, std::move(program), uniforms, stats);
+}
+
+/// Draws a quad over the whole frame with `program` into a new framebuffer
+auto draw_quad(std::unique_ptr<yasr::PipelineProgram> program,
+               const Uniforms& uniforms, yasr::PipelineStats& stats,
+               std::uint32_t sample_count = 1) -> Image
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  auto scene = yasr::test::make_quad_scene(*device, frame_size,
+                                           {.sample_count = sample_count});
+  scene.bind(*device);
+  return draw_bound(*device, scene.framebuffer, std::move(program), uniforms,
+                    stats);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Pipelines shade with the uniforms of the constant buffer")
+{
+  auto program = yasr::make_pipeline<Uniforms, Varyings>(
+      pass_through,
+      [](const Varyings&, const Uniforms& uniforms, const yasr::TextureView&) {
+        return uniforms.color;
+      });
+  yasr::PipelineStats stats;
+  const Image image =
+      draw_quad(std::move(program), {.color = {0.25f, 0.5f, 1.f}}, stats);
+
+  REQUIRE(stats.fragments_passed == frame_size * frame_size);
+  for (int y = 0; y < frame_size; ++y) {
+    for (int x = 0; x < frame_size; ++x) {
+      const RGB& color = image.unsafe_at(x, y);
+      REQUIRE(color.r == yasr::encode_srgb(0.25f));
+      REQUIRE(color.g == yasr::encode_srgb(0.5f));
+      REQUIRE(color.b == 1.f);
+    }
+  }
+}
+
+TEST_CASE("Multisampled pipelines shade the pixels of shared edges twice")
+{
+  auto program = yasr::make_pipeline<Uniforms, Varyings>(
+      pass_through,
+      [](const Varyings&, const Uniforms& uniforms, const yasr::TextureView&) {
+        return uniforms.color;
+      });
+  yasr::PipelineStats stats;
+  const Image image = draw_quad(std::move(program),
+                                {.color = {0.25f, 0.5f, 1.f}}, stats,
+                                yasr::msaa_sample_count);
+
+  // The samples of the diagonal are split between both triangles, every other
+  // pixel is shaded once
+  REQUIRE(stats.fragments_passed > frame_size * frame_size);
+  REQUIRE(stats.fragments_passed < frame_size * frame_size + 2 * frame_size);
+  for (int y = 0; y < frame_size; ++y) {
+    for (int x = 0; x < frame_size; ++x) {
+      const RGB& color = image.unsafe_at(x, y);
+      REQUIRE(color.r == Approx(yasr::encode_srgb(0.25f)));
+      REQUIRE(color.g == Approx(yasr::encode_srgb(0.5f)));
+      REQUIRE(color.b == Approx(1.f));
+    }
+  }
+}
+
+TEST_CASE("Pipelines interpolate varyings in either winding")
+{
+  const auto fragment_shader = [](const Varyings& varyings, const Uniforms&,
+                                  const yasr::TextureView&) {
+    return RGB{varyings.u, varyings.v, 0};
+  };
+  const std::vector counter_clockwise{make_vertex(-1, -1, 0, 0, 0),
+                                      make_vertex(1, -1, 0, 1, 0),
+                                      make_vertex(-1, 1, 0, 0, 1)};
+  const std::vector clockwise{counter_clockwise[0], counter_clockwise[2],
+                              counter_clockwise[1]};
+
+  yasr::PipelineStats stats;
+  const Image image = draw(
+      yasr::make_pipeline<Uniforms, Varyings>(pass_through, fragment_shader),
+      counter_clockwise, {}, stats);
+  const Image mirrored = draw(
+      yasr::make_pipeline<Uniforms, Varyings>(pass_through, fragment_shader),
+      clockwise, {}, stats);
+
+  // u follows x and v follows y up from the bottom row
+  const float half_pixel = yasr::encode_srgb(0.5f / frame_size);
+  const RGB& corner = image.unsafe_at(0, frame_size - 1);
+  REQUIRE(corner.r == Approx(half_pixel));
+  REQUIRE(corner.g == Approx(half_pixel));
+  const RGB& right = image.unsafe_at(frame_size / 2, frame_size - 1);
+  REQUIRE(right.r == Approx(yasr::encode_srgb(0.5f + 0.5f / frame_size)));
+  REQUIRE(right.g == Approx(half_pixel));
+
+  for (int y = 0; y < frame_size; ++y) {
+    for (int x = 0; x < frame_size; ++x) {
+      REQUIRE(image.unsafe_at(x, y).r == Approx(mirrored.unsafe_at(x, y).r));
+      REQUIRE(image.unsafe_at(x, y).g == Approx(mirrored.unsafe_at(x, y).g));
+    }
+  }
+}
+
+TEST_CASE("Pipelines interpolate the varyings of clipped triangles")
+{
+  // The last vertex lies between the camera and the near plane. The
+  // varyings are constant, so every shaded pixel must see the same value.
+  auto program = yasr::make_pipeline<Uniforms, Varyings>(
+      pass_through,
+      [](const Varyings& varyings, const Uniforms&, const yasr::TextureView&) {
+        return RGB{varyings.u, varyings.v, 1};
+      });
+  const std::vector vertices{make_vertex(-0.5f, -0.5f, 0, 0.5f, 0.25f),
+                             make_vertex(0.5f, -0.5f, 0, 0.5f, 0.25f),
+                             make_vertex(0, 0.5f, -3, 0.5f, 0.25f)};
+  yasr::PipelineStats stats;
+  const Image image = draw(std::move(program), vertices, {}, stats);
+
+  REQUIRE(stats.triangles_clipped == 1);
+  REQUIRE(stats.fragments_passed > 0);
+  std::uint64_t shaded = 0;
+  for (int y = 0; y < frame_size; ++y) {
+    for (int x = 0; x < frame_size; ++x) {
+      const RGB& color = image.unsafe_at(x, y);
+      if (color.b == 0) { continue; }
+      ++shaded;
+      REQUIRE(color.r == Approx(yasr::encode_srgb(0.5f)));
+      REQUIRE(color.g == Approx(yasr::encode_srgb(0.25f)));
+    }
+  }
+  REQUIRE(shaded == stats.fragments_passed);
+}
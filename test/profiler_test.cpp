@@ -0,0 +1,60 @@
+#include <catch2/catch.hpp>
+
+#include "profiler.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+TEST_CASE("Profiler sums the stage times of a frame")
+{
+  using namespace std::chrono_literals;
+  using Clock = yasr::Profiler::Clock;
+
+  yasr::Profiler profiler;
+  const Clock::time_point start = Clock::now();
+  profiler.record(yasr::PipelineStage::raster, start, start + 2ms);
+  profiler.record(yasr::PipelineStage::raster, start, start + 3ms);
+  profiler.record(yasr::PipelineStage::vertex, start, start + 1ms);
+
+  auto times = profiler.stage_times();
+  REQUIRE(times[static_cast<std::size_t>(yasr::PipelineStage::raster)] == 5ms);
+  REQUIRE(times[static_cast<std::size_t>(yasr::PipelineStage::vertex)] == 1ms);
+  REQUIRE(times[static_cast<std::size_t>(yasr::PipelineStage::setup)] ==
+          Clock::duration::zero());
+
+  profiler.begin_frame();
+  times = profiler.stage_times();
+  REQUIRE(times[static_cast<std::size_t>(yasr::PipelineStage::raster)] ==
+          Clock::duration::zero());
+}
+
+TEST_CASE("Profiler writes the traced intervals as Chrome trace events")
+{
+  yasr::Profiler profiler;
+  {
+    const yasr::ScopedTimer timer{profiler, yasr::PipelineStage::setup};
+  }
+  profiler.set_tracing(true);
+  profiler.begin_frame();
+  {
+    const yasr::ScopedTimer timer{profiler, yasr::PipelineStage::binning};
+  }
+
+  const auto path =
+      std::filesystem::temp_directory_path() / "yasr_profiler_test.json";
+  REQUIRE(profiler.write_chrome_trace(path.string()));
+  std::ifstream file{path};
+  std::stringstream contents;
+  contents << file.rdbuf();
+  file.close();
+  const std::string trace = contents.str();
+  std::filesystem::remove(path);
+
+  // Only the interval recorded while tracing is written
+  REQUIRE(trace.starts_with(R"({"displayTimeUnit":"ms","traceEvents":[)"));
+  REQUIRE(trace.find(R"("name":"binning")") != std::string::npos);
+  REQUIRE(trace.find(R"("name":"setup")") == std::string::npos);
+  REQUIRE(trace.find(R"("args":{"frame":1})") != std::string::npos);
+}
@@ -0,0 +1,273 @@
+#include <catch2/catch.hpp>
+
+#include "rasterizer.hpp"
+#include "texture.hpp"
+
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+constexpr yasr::Rect viewport{{0, 0}, {32, 32}};
+
+auto vertex(float x, float y) -> yasr::ScreenVertex
+{
+  return yasr::ScreenVertex{.pos = {x, y, 0}, .inv_w = 1, .uv = {}};
+}
+
+void accumulate_coverage(const yasr::TriangleSetup& setup,
+                         std::vector<int>& coverage)
+{
+  for (int y = setup.bounds.min.y; y < setup.bounds.max.y; ++y) {
+    for (int x = setup.bounds.min.x; x < setup.bounds.max.x; ++x) {
+      const auto& [e0, e1, e2] = setup.edges;
+      if ((e0.at(x, y) | e1.at(x, y) | e2.at(x, y)) >= 0) {
+        ++coverage[y * viewport.max.x + x];
+      }
+    }
+  }
+}
+
+} // anonymous namespace
+
+TEST_CASE("setup_triangle culls triangles by their winding")
+{
+  // Counter-clockwise as seen on the screen, which is front facing
+  const std::array front{vertex(2, 3), vertex(25, 29), vertex(27, 5)};
+  const std::array back{front[0], front[2], front[1]};
+
+  using yasr::CullMode;
+  for (const auto& triangle : {front, back}) {
+    REQUIRE(yasr::setup_triangle(triangle, viewport, RGB{}, CullMode::none));
+  }
+  REQUIRE(yasr::setup_triangle(front, viewport, RGB{}, CullMode::back));
+  REQUIRE(!yasr::setup_triangle(back, viewport, RGB{}, CullMode::back));
+  REQUIRE(!yasr::setup_triangle(front, viewport, RGB{}, CullMode::front));
+  REQUIRE(yasr::setup_triangle(back, viewport, RGB{}, CullMode::front));
+}
+
+TEST_CASE("Triangles sharing an edge cover each pixel exactly once")
+{
+  // Vertices on pixel centres and on sub-pixel positions
+  const float offset = GENERATE(0.5f, 0.f, 0.3125f);
+  const auto a = vertex(2 + offset, 3 + offset);
+  const auto b = vertex(27 + offset, 5 + offset);
+  const auto c = vertex(25 + offset, 29 + offset);
+  const auto d = vertex(4 + offset, 24 + offset);
+
+  std::vector<int> coverage(32 * 32, 0);
+  for (const auto& triangle : {std::array{a, b, c}, std::array{a, c, d}}) {
+    const auto setup = yasr::setup_triangle(triangle, viewport, RGB{});
+    REQUIRE(setup.has_value());
+    accumulate_coverage(*setup, coverage);
+  }
+
+  // Pixel centres strictly inside the quad must be covered exactly once
+  const std::array quad{a.pos, b.pos, c.pos, d.pos};
+  const auto inside_quad = [&](float x, float y) {
+    for (std::size_t i = 0; i < quad.size(); ++i) {
+      const auto& p0 = quad[i];
+      const auto& p1 = quad[(i + 1) % quad.size()];
+      if ((p1.x - p0.x) * (y - p0.y) - (p1.y - p0.y) * (x - p0.x) <= 0.01f) {
+        return false;
+      }
+    }
+    return true;
+  };
+  for (int y = 0; y < 32; ++y) {
+    for (int x = 0; x < 32; ++x) {
+      const int count = coverage[y * 32 + x];
+      REQUIRE(count <= 1);
+      if (inside_quad(static_cast<float>(x) + 0.5f,
+                      static_cast<float>(y) + 0.5f)) {
+        REQUIRE(count == 1);
+      }
+    }
+  }
+}
+
+TEST_CASE("Winding does not change the covered pixels")
+{
+  const auto a = vertex(1.2f, 1.7f);
+  const auto b = vertex(20.6f, 4.1f);
+  const auto c = vertex(9.9f, 17.3f);
+
+  std::vector<int> clockwise(32 * 32, 0);
+  std::vector<int> counter_clockwise(32 * 32, 0);
+  accumulate_coverage(*yasr::setup_triangle({a, b, c}, viewport, RGB{}),
+                      clockwise);
+  accumulate_coverage(*yasr::setup_triangle({a, c, b}, viewport, RGB{}),
+                      counter_clockwise);
+  REQUIRE(clockwise == counter_clockwise);
+}
+
+TEST_CASE("Degenerate triangles are rejected during setup")
+{
+  REQUIRE_FALSE(yasr::setup_triangle(
+                    {vertex(1, 1), vertex(5, 5), vertex(10, 10)}, viewport,
+                    RGB{})
+                    .has_value());
+}
+
+TEST_CASE("All raster kernels produce identical images")
+{
+  constexpr int size = 100;
+  const yasr::Rect screen{{0, 0}, {size, size}};
+
+  std::vector<std::uint8_t> texels(16 * 16 * 4);
+  for (std::size_t i = 0; i < texels.size(); ++i) {
+    texels[i] = static_cast<std::uint8_t>(i * 37);
+  }
+  const yasr::TextureStorage storage{yasr::TextureDesc{
+      .width = 16,
+      .height = 16,
+      .format = yasr::TextureFormat::rgba8_srgb,
+      .data = std::as_bytes(std::span(texels)),
+  }};
+  const auto filter =
+      GENERATE(yasr::TextureFilter::nearest, yasr::TextureFilter::trilinear);
+  const yasr::TextureView texture = storage.view(filter);
+
+  // A fixed pseudo-random sequence of overlapping triangles
+  std::uint32_t state = 12345;
+  const auto random = [&](float range) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / static_cast<float>(1 << 24) *
+           range;
+  };
+  std::vector<yasr::TriangleSetup> triangles;
+  while (triangles.size() < 200) {
+    std::array<yasr::ScreenVertex, 3> vertices;
+    for (auto& v : vertices) {
+      v = yasr::ScreenVertex{.pos = {random(140) - 20, random(140) - 20,
+                                     random(1)},
+                             .inv_w = 0.5f + random(1),
+                             .uv = {random(1), random(1)}};
+    }
+    if (auto setup = yasr::setup_triangle(vertices, screen, RGB{1, 1, 1})) {
+      triangles.push_back(*setup);
+    }
+  }
+
+  const auto render = [&](yasr::RasterKernel kernel) {
+    Image image{size, size};
+    std::vector<float> depth(size * size,
+                             -std::numeric_limits<float>::infinity());
+    // Odd-sized tiles exercise the scalar tails of the SIMD kernels
+    constexpr int tile = 37;
+    yasr::FragmentCounts counts;
+    for (const auto& setup : triangles) {
+      for (int y = 0; y < size; y += tile) {
+        for (int x = 0; x < size; x += tile) {
+          counts += kernel(
+              setup,
+              yasr::Rect{{x, y},
+                         {std::min(x + tile, size), std::min(y + tile, size)}},
+              depth, yasr::color_target(image), texture);
+        }
+      }
+    }
+    std::vector<float> result(depth);
+    for (int i = 0; i < size * size; ++i) {
+      const RGB& c = image.data()[i];
+      result.insert(result.end(), {c.r, c.g, c.b});
+    }
+    // The counts are far below 2^24, so they are exact as floats
+    result.insert(result.end(), {static_cast<float>(counts.tested),
+                                 static_cast<float>(counts.passed)});
+    return result;
+  };
+
+  const auto reference = render(yasr::raster_kernel(yasr::SimdLevel::scalar));
+  for (const auto level :
+       {yasr::SimdLevel::sse41, yasr::SimdLevel::avx2, yasr::SimdLevel::neon,
+        yasr::SimdLevel::wasm_simd128}) {
+    const auto kernel = yasr::raster_kernel(level);
+    if (kernel == nullptr || level > yasr::detect_simd_level()) { continue; }
+    CAPTURE(static_cast<int>(level));
+    REQUIRE(std::memcmp(render(kernel).data(), reference.data(),
+                        reference.size() * sizeof(float)) == 0);
+  }
+}
+
+TEST_CASE("Hierarchical depth culling does not change the image")
+{
+  constexpr int size = 100;
+  const yasr::Rect screen{{0, 0}, {size, size}};
+
+  const std::vector<std::uint8_t> texels(4 * 4 * 4, 200);
+  const yasr::TextureStorage storage{yasr::TextureDesc{
+      .width = 4,
+      .height = 4,
+      .format = yasr::TextureFormat::rgba8_unorm,
+      .data = std::as_bytes(std::span(texels)),
+  }};
+  const yasr::TextureView texture =
+      storage.view(yasr::TextureFilter::bilinear);
+
+  // A slanted occluder over the left part of the screen, then triangles both
+  // in front of and behind it
+  const auto screen_vertex = [](float x, float y, float z) {
+    return yasr::ScreenVertex{.pos = {x, y, z}, .inv_w = 1, .uv = {}};
+  };
+  std::vector<yasr::TriangleSetup> triangles;
+  for (const auto& vertices :
+       {std::array{screen_vertex(-10, -10, 0.6f), screen_vertex(70, -10, 0.5f),
+                   screen_vertex(70, 110, 0.5f)},
+        std::array{screen_vertex(-10, -10, 0.6f), screen_vertex(70, 110, 0.5f),
+                   screen_vertex(-10, 110, 0.6f)}}) {
+    triangles.push_back(*yasr::setup_triangle(vertices, screen, RGB{1, 0, 0}));
+  }
+  std::uint32_t state = 54321;
+  const auto random = [&](float range) {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / static_cast<float>(1 << 24) *
+           range;
+  };
+  while (triangles.size() < 300) {
+    const float z = random(1);
+    std::array<yasr::ScreenVertex, 3> vertices;
+    for (auto& v : vertices) {
+      v = screen_vertex(random(120) - 10, random(120) - 10, z + random(0.05f));
+    }
+    if (auto setup = yasr::setup_triangle(vertices, screen, RGB{0, 1, 0})) {
+      triangles.push_back(*setup);
+    }
+  }
+
+  Image reference_image{size, size};
+  std::vector<float> reference_depth(size * size,
+                                     -std::numeric_limits<float>::infinity());
+  const auto kernel = yasr::raster_kernel(yasr::SimdLevel::scalar);
+  for (const auto& setup : triangles) {
+    kernel(setup, screen, reference_depth, yasr::color_target(reference_image),
+           texture);
+  }
+
+  Image image{size, size};
+  std::vector<float> depth(size * size,
+                           -std::numeric_limits<float>::infinity());
+  std::vector<float> coarse_depth(
+      yasr::hiz_block_count(size) * yasr::hiz_block_count(size),
+      -std::numeric_limits<float>::infinity());
+  yasr::PipelineStats stats;
+  for (const auto& setup : triangles) {
+    for (int y = 0; y < size; y += yasr::tile_size) {
+      for (int x = 0; x < size; x += yasr::tile_size) {
+        const yasr::Rect tile{{x, y},
+                              {std::min(x + yasr::tile_size, size),
+                               std::min(y + yasr::tile_size, size)}};
+        yasr::rasterize_triangle(setup, tile, depth, coarse_depth,
+                                 yasr::color_target(image), texture, stats);
+      }
+    }
+  }
+
+  REQUIRE(stats.hiz_triangles_culled > 0);
+  REQUIRE(stats.hiz_blocks_culled > 0);
+  REQUIRE(std::memcmp(depth.data(), reference_depth.data(),
+                      depth.size() * sizeof(float)) == 0);
+  REQUIRE(std::memcmp(image.data(), reference_image.data(),
+                      depth.size() * sizeof(RGB)) == 0);
+}
@@ -0,0 +1,96 @@
+#ifndef YASR_RENDER_TEST_UTIL_HPP
+#define YASR_RENDER_TEST_UTIL_HPP
+
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace yasr::test {
+
+struct QuadSceneDesc {
+  /// The quad spans [min, max] in x and y at z = 0, facing +z
+  float min = -1;
+  float max = 1;
+  /// The single RGBA texel of the texture
+  std::array<std::uint8_t, 4> texel{255, 255, 255, 255};
+  std::uint32_t sample_count = 1;
+  bool g_buffer = false;
+};
+
+/// A textured quad and a square framebuffer to draw it into
+struct QuadScene {
+  static constexpr std::array<std::uint32_t, 6> indices{0, 1, 2, 0, 2, 3};
+
+  UniqueBuffer vertex_buffer;
+  UniqueBuffer index_buffer;
+  UniqueTexture texture;
+  UniqueFramebuffer framebuffer;
+
+  /// Binds the framebuffer, the buffers and the texture
+  void bind(Device& device)
+  {
+    device.bind_framebuffer(framebuffer);
+    device.bind_vertex_buffer(vertex_buffer);
+    device.bind_index_buffer(index_buffer);
+    device.bind_texture(texture);
+  }
+  /// Records the binds of bind()
+  void record(CommandBuffer& commands)
+  {
+    commands.bind_framebuffer(framebuffer);
+    commands.bind_vertex_buffer(vertex_buffer);
+    commands.bind_index_buffer(index_buffer);
+    commands.bind_texture(texture);
+  }
+};
+
+[[nodiscard]] inline auto make_quad_scene(Device& device,
+                                          std::uint32_t frame_size,
+                                          const QuadSceneDesc& desc = {})
+    -> QuadScene
+{
+  const float min = desc.min;
+  const float max = desc.max;
+  const std::array vertices{
+      Vertex{.pos = {min, min, 0}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+      Vertex{.pos = {max, min, 0}, .normal = {0, 0, 1}, .texcoord = {1, 0}},
+      Vertex{.pos = {max, max, 0}, .normal = {0, 0, 1}, .texcoord = {1, 1}},
+      Vertex{.pos = {min, max, 0}, .normal = {0, 0, 1}, .texcoord = {0, 1}},
+  };
+  return QuadScene{
+      .vertex_buffer = create_unique_buffer(
+          device, {.data = std::as_bytes(std::span{vertices})}),
+      .index_buffer = create_unique_buffer(
+          device, {.data = std::as_bytes(std::span{QuadScene::indices})}),
+      .texture = create_unique_texture(
+          device, {.width = 1,
+                   .height = 1,
+                   .data = std::as_bytes(std::span{desc.texel})}),
+      .framebuffer = create_unique_framebuffer(
+          device, {.width = frame_size,
+                   .height = frame_size,
+                   .sample_count = desc.sample_count,
+                   .g_buffer = desc.g_buffer}),
+  };
+}
+
+/// Whether both images have exactly the same colors
+[[nodiscard]] inline auto same_pixels(const Image& lhs, const Image& rhs)
+    -> bool
+{
+  for (int y = 0; y < lhs.height(); ++y) {
+    for (int x = 0; x < lhs.width(); ++x) {
+      const RGB& a = lhs.unsafe_at(x, y);
+      const RGB& b = rhs.unsafe_at(x, y);
+      if (a.r != b.r || a.g != b.g || a.b != b.b) { return false; }
+    }
+  }
+  return true;
+}
+
+} // namespace yasr::test
+
+#endif // YASR_RENDER_TEST_UTIL_HPP
@@ -0,0 +1,30 @@
+#include <catch2/catch.hpp>
+
+#include "slot_map.hpp"
+
+#include <cstdint>
+#include <string>
+
+TEST_CASE("SlotMap reuses slots without resolving stale ids")
+{
+  yasr::SlotMap<std::string> map;
+  REQUIRE(map.get(0) == nullptr);
+
+  const std::uint64_t first = map.emplace("first");
+  const std::uint64_t second = map.emplace("second");
+  REQUIRE(first != 0);
+  REQUIRE(map.size() == 2);
+  REQUIRE(map[second] == "second");
+
+  REQUIRE(map.erase(first) == "first");
+  REQUIRE_FALSE(map.contains(first));
+  REQUIRE_FALSE(map.erase(first).has_value());
+
+  const std::uint64_t third = map.emplace("third");
+  REQUIRE(static_cast<std::uint32_t>(third) ==
+          static_cast<std::uint32_t>(first));
+  REQUIRE(third != first);
+  REQUIRE(map.get(first) == nullptr);
+  REQUIRE(map[third] == "third");
+  REQUIRE(map.size() == 2);
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include "texture.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+auto make_storage(std::uint32_t width, std::uint32_t height,
+                  const std::vector<std::uint8_t>& texels)
+{
+  return yasr::TextureStorage{yasr::TextureDesc{
+      .width = width,
+      .height = height,
+      .format = yasr::TextureFormat::rgba8_unorm,
+      .data = std::as_bytes(std::span(texels)),
+  }};
+}
+
+} // anonymous namespace
+
+TEST_CASE("Morton offsets form a permutation of a tile")
+{
+  std::vector<int> offsets;
+  for (int y = 0; y < yasr::texture_tile_size; ++y) {
+    for (int x = 0; x < yasr::texture_tile_size; ++x) {
+      offsets.push_back(yasr::morton_offset(x, y));
+    }
+  }
+  std::ranges::sort(offsets);
+  std::vector<int> expected(offsets.size());
+  std::iota(expected.begin(), expected.end(), 0);
+  REQUIRE(offsets == expected);
+}
+
+TEST_CASE("TextureStorage builds a full mip chain")
+{
+  const std::vector<std::uint8_t> texels(20 * 6 * 4, 128);
+  const auto storage = make_storage(20, 6, texels);
+
+  const auto view = storage.view(yasr::TextureFilter::trilinear);
+  REQUIRE(view.level_count == 5);
+  REQUIRE(view.levels[1].width == 10);
+  REQUIRE(view.levels[1].height == 3);
+  REQUIRE(view.levels[4].width == 1);
+  REQUIRE(view.levels[4].height == 1);
+}
+
+TEST_CASE("Nearest sampling returns the original texels")
+{
+  constexpr int size = 13;
+  std::vector<std::uint8_t> texels(size * size * 4);
+  for (std::size_t i = 0; i < texels.size(); ++i) {
+    texels[i] = static_cast<std::uint8_t>(i);
+  }
+  const auto storage = make_storage(size, size, texels);
+  const auto view = storage.view(yasr::TextureFilter::nearest);
+
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const float u = (static_cast<float>(x) + 0.5f) / size;
+      const float v = 1.f - (static_cast<float>(y) + 0.5f) / size;
+      const RGB color = yasr::sample(view, u, v, 0);
+      const auto* expected = &texels[static_cast<std::size_t>((y * size + x) * 4)];
+      REQUIRE(color.r == Approx(expected[0] / 255.f));
+      REQUIRE(color.g == Approx(expected[1] / 255.f));
+      REQUIRE(color.b == Approx(expected[2] / 255.f));
+    }
+  }
+}
+
+TEST_CASE("Filtering a constant texture is constant on every level")
+{
+  const std::vector<std::uint8_t> texels(32 * 32 * 4, 200);
+  const auto storage = make_storage(32, 32, texels);
+
+  const auto filter =
+      GENERATE(yasr::TextureFilter::bilinear, yasr::TextureFilter::trilinear);
+  const auto view = storage.view(filter);
+  for (const float lod : {-1.f, 0.f, 0.3f, 2.5f, 4.9f, 10.f}) {
+    const RGB color = yasr::sample(view, 0.37f, 0.81f, lod);
+    REQUIRE(color.r == Approx(200 / 255.f));
+  }
+}
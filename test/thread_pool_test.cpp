@@ -0,0 +1,55 @@
+#include <catch2/catch.hpp>
+
+#include "render_test_util.hpp"
+#include "thread_pool.hpp"
+#include "yasr.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+/// Several tiles in each direction
+constexpr std::uint32_t frame_size = 200;
+
+/// Two views of a textured quad, the second drawn over the first, so the
+/// depth test decides between triangles that cross the same tiles
+auto render(std::uint32_t thread_count, std::uint32_t sample_count) -> Image
+{
+  const auto device = yasr::Device::create({.thread_count = thread_count});
+  auto scene = yasr::test::make_quad_scene(*device, frame_size,
+                                           {.sample_count = sample_count});
+  scene.bind(*device);
+  device->set_cull_mode(yasr::CullMode::none);
+  device->clear(yasr::ClearValue{});
+  device->draw_indexed();
+  device->set_camera(yasr::Camera{.eye = {-1.f, -0.5f, 2.f}});
+  device->draw_indexed();
+  REQUIRE(device->pipeline_stats().fragments_passed > 0);
+  return device->framebuffer_image(scene.framebuffer);
+}
+
+} // anonymous namespace
+
+TEST_CASE("ThreadPool::parallel_for runs every task exactly once")
+{
+  const auto thread_count = GENERATE(1u, 2u, 8u);
+  yasr::ThreadPool pool{thread_count};
+  REQUIRE(pool.thread_count() == thread_count);
+
+  for (int round = 0; round < 3; ++round) {
+    std::vector<std::atomic<int>> counters(1000);
+    pool.parallel_for(counters.size(),
+                      [&](std::size_t i) { counters[i].fetch_add(1); });
+    for (const auto& counter : counters) { REQUIRE(counter == 1); }
+  }
+}
+
+TEST_CASE("Devices render the same pixels with any number of threads")
+{
+  const auto sample_count = GENERATE(1u, 4u);
+  const Image expected = render(1, sample_count);
+  REQUIRE(yasr::test::same_pixels(render(4, sample_count), expected));
+  REQUIRE(yasr::test::same_pixels(render(8, sample_count), expected));
+}
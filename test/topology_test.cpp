@@ -0,0 +1,157 @@
+#include <catch2/catch.hpp>
+
+#include "render_test_util.hpp"
+#include "vertex_processing.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr std::uint32_t frame_size = 64;
+
+constexpr auto quad_indices = yasr::test::QuadScene::indices;
+constexpr std::array<std::uint32_t, 2> line_indices{0, 1};
+// A line behind the quad along the x axis
+const std::array line_vertices{
+    Vertex{.pos = {-3, 0, -0.5f}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+    Vertex{.pos = {3, 0, -0.5f}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+};
+
+constexpr RGB red{1, 0, 0};
+
+auto is_red(const RGB& color) -> bool
+{
+  return color.r == 1.f && color.g == 0.f && color.b == 0.f;
+}
+
+/// A gray quad facing the camera at z = 0 and a line behind it, drawn into a
+/// single-sampled framebuffer looking at the origin down the z axis
+class Scene {
+public:
+  Scene()
+      : quad_{yasr::test::make_quad_scene(
+            *device_, frame_size, {.texel = {128, 128, 128, 255}})},
+        line_buffer_{yasr::create_unique_buffer(
+            *device_, {.data = std::as_bytes(std::span{line_vertices})})}
+  {
+    quad_.bind(*device_);
+    device_->set_camera(yasr::Camera{.eye = {0, 0, 3}});
+    device_->set_line_style({.color = red});
+    device_->clear(yasr::ClearValue{});
+  }
+
+  [[nodiscard]] auto device() -> yasr::Device&
+  {
+    return *device_;
+  }
+
+  /// Draws `indices` of the quad vertices with `topology`
+  void draw_quad(std::span<const std::uint32_t> indices,
+                 yasr::Topology topology)
+  {
+    device_->bind_vertex_buffer(quad_.vertex_buffer);
+    draw(indices, topology);
+  }
+  /// Draws the line, in the current line style
+  void draw_line()
+  {
+    device_->bind_vertex_buffer(line_buffer_);
+    draw(line_indices, yasr::Topology::lines);
+  }
+
+  auto image() -> const Image&
+  {
+    return device_->framebuffer_image(quad_.framebuffer);
+  }
+
+private:
+  std::unique_ptr<yasr::Device> device_ =
+      yasr::Device::create({.thread_count = 2});
+  yasr::test::QuadScene quad_;
+  yasr::UniqueBuffer line_buffer_;
+
+  void draw(std::span<const std::uint32_t> indices, yasr::Topology topology)
+  {
+    auto index_buffer = yasr::create_unique_buffer(
+        *device_, {.data = std::as_bytes(indices)});
+    device_->bind_index_buffer(index_buffer);
+    device_->set_topology(topology);
+    device_->draw_indexed();
+  }
+};
+
+} // anonymous namespace
+
+TEST_CASE("Lines cover one pixel per step and are clipped to the frame")
+{
+  Scene scene;
+  scene.device().set_line_style({.color = red, .depth_test = false});
+  scene.draw_line();
+
+  // The ends lie outside the frame, the line crosses it at its middle row
+  const Image& image = scene.image();
+  for (int x = 0; x < image.width(); ++x) {
+    REQUIRE(is_red(image.unsafe_at(x, 32)));
+    REQUIRE(image.unsafe_at(x, 31).r == 0.f);
+    REQUIRE(image.unsafe_at(x, 33).r == 0.f);
+  }
+}
+
+TEST_CASE("Lines are depth tested against earlier draws")
+{
+  Scene scene;
+  scene.draw_quad(quad_indices, yasr::Topology::triangles);
+
+  SECTION("With the depth test")
+  {
+    scene.draw_line();
+    const Image& image = scene.image();
+    REQUIRE(is_red(image.unsafe_at(2, 32)));
+    const RGB& covered = image.unsafe_at(32, 32);
+    REQUIRE(covered.g > 0.f);
+    REQUIRE(covered.r == covered.g);
+  }
+
+  SECTION("Without the depth test")
+  {
+    scene.device().set_line_style({.color = red, .depth_test = false});
+    scene.draw_line();
+    REQUIRE(is_red(scene.image().unsafe_at(32, 32)));
+  }
+}
+
+TEST_CASE("A wireframe of a draw shows over it")
+{
+  Scene scene;
+  scene.draw_quad(quad_indices, yasr::Topology::triangles);
+  scene.device().begin_frame();
+  const std::vector<std::uint32_t> edges =
+      yasr::wireframe_indices(quad_indices);
+  scene.draw_quad(edges, yasr::Topology::lines);
+
+  const yasr::PipelineStats stats = scene.device().pipeline_stats();
+  REQUIRE(stats.fragments_tested > 0);
+  REQUIRE(stats.fragments_passed == stats.fragments_tested);
+  // Across the diagonal, through the middle of the frame
+  REQUIRE(is_red(scene.image().unsafe_at(32, 31)));
+}
+
+TEST_CASE("Points cover the pixel they project into")
+{
+  Scene scene;
+  // Looking straight at the first corner of the quad
+  constexpr std::array<std::uint32_t, 1> corner{0};
+  scene.device().set_camera(yasr::Camera{.eye = {-1, -1, 3},
+                                         .target = {-1, -1, 0}});
+  scene.draw_quad(corner, yasr::Topology::points);
+
+  const Image& image = scene.image();
+  REQUIRE(is_red(image.unsafe_at(32, 32)));
+  REQUIRE(image.unsafe_at(31, 32).r == 0.f);
+  REQUIRE(image.unsafe_at(32, 31).r == 0.f);
+}
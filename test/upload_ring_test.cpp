@@ -0,0 +1,211 @@
+#include <catch2/catch.hpp>
+
+#include "upload_ring.hpp"
+#include "yasr.hpp"
+#include "yasr_raii.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Allocations of the test program so far, counted by the replacements of
+/// the global allocation functions below
+std::atomic<std::size_t> allocation_count{0};
+
+auto counted_malloc(std::size_t size) -> void*
+{
+  ++allocation_count;
+  void* const memory = std::malloc(std::max<std::size_t>(size, 1));
+  if (memory == nullptr) { throw std::bad_alloc{}; }
+  return memory;
+}
+
+auto counted_aligned_malloc(std::size_t size, std::size_t alignment) -> void*
+{
+  ++allocation_count;
+  // aligned_alloc() takes a positive multiple of the alignment
+  size = std::max((size + alignment - 1) / alignment * alignment, alignment);
+#ifdef _WIN32
+  void* const memory = _aligned_malloc(size, alignment);
+#else
+  void* const memory = std::aligned_alloc(alignment, size);
+#endif
+  if (memory == nullptr) { throw std::bad_alloc{}; }
+  return memory;
+}
+
+const std::array triangle{
+    Vertex{.pos = {-1, -1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+    Vertex{.pos = {1, -1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+    Vertex{.pos = {0, 1, 0}, .normal = {0, 0, 1}, .texcoord = {}},
+};
+constexpr std::array<std::uint32_t, 3> triangle_indices{0, 1, 2};
+constexpr std::array<std::uint8_t, 4> white_texel{255, 255, 255, 255};
+
+auto byte_values(std::span<const std::byte> bytes) -> std::vector<int>
+{
+  std::vector<int> values;
+  for (const std::byte byte : bytes) {
+    values.push_back(std::to_integer<int>(byte));
+  }
+  return values;
+}
+
+} // anonymous namespace
+
+// The array forms call these
+auto operator new(std::size_t size) -> void* { return counted_malloc(size); }
+auto operator new(std::size_t size, std::align_val_t alignment) -> void*
+{
+  return counted_aligned_malloc(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t /*size*/) noexcept
+{
+  std::free(memory);
+}
+void operator delete(void* memory, std::align_val_t /*alignment*/) noexcept
+{
+#ifdef _WIN32
+  _aligned_free(memory);
+#else
+  std::free(memory);
+#endif
+}
+void operator delete(void* memory, std::size_t /*size*/,
+                     std::align_val_t alignment) noexcept
+{
+  operator delete(memory, alignment);
+}
+
+TEST_CASE("Buffer updates copy their range in submission order")
+{
+  const auto device = yasr::Device::create({.thread_count = 1});
+  constexpr std::array<std::uint8_t, 4> initial{1, 2, 3, 4};
+  auto buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{initial}), .size = 8});
+  const std::span<const std::byte> memory = device->map_buffer(buffer);
+  REQUIRE(byte_values(memory) == std::vector{1, 2, 3, 4, 0, 0, 0, 0});
+
+  std::array<std::uint8_t, 2> update{9, 9};
+  device->update_buffer(buffer, 1, std::as_bytes(std::span{update}));
+  REQUIRE(byte_values(memory) == std::vector{1, 9, 9, 4, 0, 0, 0, 0});
+
+  // The command buffer keeps a copy of the bytes
+  yasr::CommandBuffer commands = device->acquire_command_buffer();
+  update = {7, 8};
+  commands.update_buffer(buffer, 6, std::as_bytes(std::span{update}));
+  update = {0, 0};
+  device->wait(device->submit(std::move(commands)));
+  REQUIRE(byte_values(memory) == std::vector{1, 9, 9, 4, 0, 0, 7, 8});
+}
+
+TEST_CASE("Upload rings stream draws and reuse the regions of old frames")
+{
+  const auto device = yasr::Device::create({.thread_count = 1});
+  auto texture = yasr::create_unique_texture(
+      *device, {.width = 1,
+                .height = 1,
+                .data = std::as_bytes(std::span{white_texel})});
+  auto framebuffer =
+      yasr::create_unique_framebuffer(*device, {.width = 8, .height = 8});
+
+  constexpr std::size_t frame_size = 1024;
+  yasr::UploadRing ring{*device, {.frame_size = frame_size, .frame_count = 2}};
+  std::array<const Vertex*, 2> first_vertices{};
+  yasr::Fence fence;
+  device->begin_frame();
+  for (std::size_t frame = 0; frame < 4; ++frame) {
+    ring.begin_frame();
+    REQUIRE(ring.remaining() == frame_size);
+    const yasr::Upload<Vertex> vertices = ring.allocate<Vertex>(3);
+    std::ranges::copy(triangle, vertices.data.begin());
+    const yasr::Upload<std::uint32_t> upload =
+        ring.allocate<std::uint32_t>(3);
+    std::ranges::copy(triangle_indices, upload.data.begin());
+    REQUIRE(ring.remaining() < frame_size);
+    // Both live in the buffer of the ring, apart and aligned
+    REQUIRE(upload.buffer == vertices.buffer);
+    REQUIRE(upload.offset >= vertices.offset + vertices.data.size_bytes());
+    REQUIRE(upload.offset % yasr::UploadRing::alignment == 0);
+
+    // Every other frame writes over the memory of two frames earlier
+    if (frame < 2) {
+      first_vertices[frame] = vertices.data.data();
+    } else {
+      REQUIRE(vertices.data.data() == first_vertices[frame % 2]);
+    }
+
+    yasr::CommandBuffer commands = device->acquire_command_buffer();
+    commands.bind_framebuffer(framebuffer);
+    commands.bind_texture(texture);
+    commands.set_cull_mode(yasr::CullMode::none);
+    commands.bind_vertex_buffer(vertices.buffer, vertices.offset,
+                                vertices.data.size_bytes());
+    commands.bind_index_buffer(upload.buffer, upload.offset,
+                               upload.data.size_bytes());
+    commands.draw_indexed();
+    fence = device->submit(std::move(commands));
+    ring.end_frame(fence);
+  }
+  device->wait(fence);
+
+  const yasr::PipelineStats stats = device->pipeline_stats();
+  REQUIRE(stats.triangles_submitted == 4);
+  REQUIRE(stats.fragments_passed > 0);
+}
+
+TEST_CASE("Streaming frames allocates no memory once warmed up")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  auto texture = yasr::create_unique_texture(
+      *device, {.width = 1,
+                .height = 1,
+                .data = std::as_bytes(std::span{white_texel})});
+  auto framebuffer =
+      yasr::create_unique_framebuffer(*device, {.width = 32, .height = 32});
+  yasr::UploadRing ring{*device, {.frame_size = 1024, .frame_count = 2}};
+
+  yasr::Fence fence;
+  const auto stream_frames = [&](int frame_count) {
+    for (int frame = 0; frame < frame_count; ++frame) {
+      ring.begin_frame();
+      const yasr::Upload<Vertex> vertices = ring.allocate<Vertex>(3);
+      std::ranges::copy(triangle, vertices.data.begin());
+      const yasr::Upload<std::uint32_t> indices =
+          ring.allocate<std::uint32_t>(3);
+      std::ranges::copy(triangle_indices, indices.data.begin());
+
+      yasr::CommandBuffer commands = device->acquire_command_buffer();
+      commands.bind_framebuffer(framebuffer);
+      commands.bind_texture(texture);
+      commands.set_cull_mode(yasr::CullMode::none);
+      commands.bind_vertex_buffer(vertices.buffer, vertices.offset,
+                                  vertices.data.size_bytes());
+      commands.bind_index_buffer(indices.buffer, indices.offset,
+                                 indices.data.size_bytes());
+      commands.clear(yasr::ClearValue{});
+      commands.draw_indexed();
+      fence = device->submit(std::move(commands));
+      ring.end_frame(fence);
+    }
+    device->wait(fence);
+  };
+
+  // The first frames grow the storage of the command buffers, the queue and
+  // the draws
+  stream_frames(8);
+  const std::size_t warm_allocations = allocation_count;
+  stream_frames(32);
+  REQUIRE(allocation_count == warm_allocations);
+  REQUIRE(device->framebuffer_image(framebuffer).unsafe_at(16, 20).r > 0.f);
+}
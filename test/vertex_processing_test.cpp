@@ -0,0 +1,98 @@
+#include <catch2/catch.hpp>
+
+#include "thread_pool.hpp"
+#include "vertex_processing.hpp"
+
+#include <vector>
+
+TEST_CASE("VertexCache assigns one slot per referenced vertex")
+{
+  const std::vector<std::uint32_t> indices{4, 1, 2, 2, 1, 0, 4, 2, 0};
+  yasr::VertexCache cache;
+  cache.build(indices, 6);
+
+  REQUIRE(cache.unique_vertices().size() == 4);
+  REQUIRE(cache.slot(4) == 0);
+  REQUIRE(cache.slot(1) == 1);
+  REQUIRE(cache.slot(2) == 2);
+  REQUIRE(cache.slot(0) == 3);
+  REQUIRE(cache.slot(3) == yasr::VertexCache::invalid_slot);
+}
+
+TEST_CASE("transform_vertices maps normalized coordinates to the viewport")
+{
+  // More vertices than one batch, so a partial batch is transformed as well
+  std::vector<Vertex> vertices;
+  std::vector<std::uint32_t> unique;
+  for (int i = 0; i < 11; ++i) {
+    const float t = static_cast<float>(i) / 10.f;
+    vertices.push_back(Vertex{.pos = {2 * t - 1, 1 - 2 * t, t},
+                              .normal = {},
+                              .texcoord = {}});
+    unique.push_back(static_cast<std::uint32_t>(10 - i));
+  }
+
+  yasr::ThreadPool thread_pool{1};
+  yasr::PostTransformVertices out;
+  const yasr::Rect viewport{{10, 20}, {110, 70}};
+  yasr::transform_vertices(beyond::Mat4::identity(), vertices, unique,
+                           viewport, out, thread_pool);
+
+  REQUIRE(out.x.size() == unique.size());
+  for (std::size_t slot = 0; slot < unique.size(); ++slot) {
+    const beyond::Point3& pos = vertices[unique[slot]].pos;
+    CAPTURE(slot);
+    REQUIRE(out.x[slot] == Approx(10 + (pos.x + 1) * 50));
+    REQUIRE(out.y[slot] == Approx(70 - (pos.y + 1) * 25));
+    REQUIRE(out.z[slot] == Approx(-pos.z));
+    REQUIRE(out.inv_w[slot] == 1.f);
+  }
+}
+
+TEST_CASE("transform_vertices gives every instance its own slots")
+{
+  const std::vector<Vertex> vertices{
+      Vertex{.pos = {0, 0, 0}, .normal = {}, .texcoord = {}},
+      Vertex{.pos = {0.5f, 0.5f, 0}, .normal = {}, .texcoord = {}},
+  };
+  const std::vector<std::uint32_t> unique{1, 0};
+  beyond::Mat4 shifted = beyond::Mat4::identity();
+  shifted(0, 3) = -0.5f;
+  const std::vector instance_mvps{beyond::Mat4::identity(), shifted};
+
+  yasr::ThreadPool thread_pool{2};
+  yasr::PostTransformVertices out;
+  out.resize(1 + instance_mvps.size() * unique.size());
+  const yasr::Rect viewport{{0, 0}, {100, 100}};
+  yasr::transform_vertices(instance_mvps, vertices, unique, viewport, out, 1,
+                           thread_pool);
+
+  REQUIRE(out.x[1] == Approx(75));
+  REQUIRE(out.x[2] == Approx(50));
+  REQUIRE(out.x[3] == Approx(50));
+  REQUIRE(out.x[4] == Approx(25));
+  REQUIRE(out.y[3] == Approx(25));
+}
+
+TEST_CASE("bounding_sphere encloses the referenced vertices")
+{
+  const std::vector<Vertex> vertices{
+      Vertex{.pos = {-1, 0, 0}, .normal = {}, .texcoord = {}},
+      Vertex{.pos = {100, 100, 100}, .normal = {}, .texcoord = {}},
+      Vertex{.pos = {3, 0, 0}, .normal = {}, .texcoord = {}},
+  };
+  const std::vector<std::uint32_t> unique{2, 0};
+  const yasr::BoundingSphere sphere = yasr::bounding_sphere(vertices, unique);
+  REQUIRE(sphere.center.x == 1.f);
+  REQUIRE(sphere.center.y == 0.f);
+  REQUIRE(sphere.radius == 2.f);
+}
+
+TEST_CASE("wireframe_indices lists every shared edge once")
+{
+  // Two triangles of a quad, sharing the diagonal from 0 to 2
+  const std::vector<std::uint32_t> indices{0, 1, 2, 2, 3, 0};
+  const std::vector<std::uint32_t> lines = yasr::wireframe_indices(indices);
+  const std::vector<std::uint32_t> expected{0, 1, 0, 2, 0, 3, 1, 2, 2, 3};
+  REQUIRE(lines == expected);
+}
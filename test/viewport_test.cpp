@@ -0,0 +1,179 @@
+#include <catch2/catch.hpp>
+
+#include "pipeline.hpp"
+#include "render_test_util.hpp"
+#include "yasr_raii.hpp"
+
+#include <cstdint>
+#include <span>
+
+namespace {
+
+// Spans two tiles, so regions cross a tile boundary
+constexpr int frame_size = 96;
+
+struct Uniforms {
+  RGB color;
+};
+
+struct Varyings {
+  float u = 0;
+};
+
+/// A quad over the whole viewport, flat shaded with the uniform color
+class FlatQuadScene {
+public:
+  FlatQuadScene()
+      : quad_{yasr::test::make_quad_scene(*device_, frame_size)},
+        constant_buffer_{yasr::create_unique_buffer(
+            *device_, {.data = std::as_bytes(std::span{&uniforms, 1})})},
+        pipeline_{yasr::create_unique_pipeline(
+            *device_, yasr::make_pipeline<Uniforms, Varyings>(
+                          [](const Vertex& vertex, const Uniforms&) {
+                            return yasr::ShadedVertex<Varyings>{
+                                .position = {vertex.pos.x, vertex.pos.y, 0, 1},
+                                .varyings = {vertex.texcoord.x}};
+                          },
+                          [](const Varyings&, const Uniforms& constants,
+                             const yasr::TextureView&) {
+                            return constants.color;
+                          }))}
+  {
+    quad_.bind(*device_);
+    device_->bind_constant_buffer(constant_buffer_);
+    device_->bind_pipeline(pipeline_);
+  }
+
+  [[nodiscard]] auto device() -> yasr::Device&
+  {
+    return *device_;
+  }
+
+  /// Draws the quad on a cleared framebuffer and reads it back
+  auto draw() -> const Image&
+  {
+    device_->clear(yasr::ClearValue{});
+    device_->draw_indexed();
+    return device_->framebuffer_image(quad_.framebuffer);
+  }
+
+private:
+  static constexpr Uniforms uniforms{.color = {1, 1, 1}};
+
+  std::unique_ptr<yasr::Device> device_ =
+      yasr::Device::create({.thread_count = 2});
+  yasr::test::QuadScene quad_;
+  yasr::UniqueBuffer constant_buffer_;
+  yasr::UniquePipeline pipeline_;
+};
+
+auto contains(const yasr::Region& region, int x, int y) -> bool
+{
+  return x >= region.x && x < region.x + static_cast<int>(region.width) &&
+         y >= region.y && y < region.y + static_cast<int>(region.height);
+}
+
+/// Whether exactly the pixels of `region` are lit
+auto lit_exactly(const Image& image, const yasr::Region& region) -> bool
+{
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      if ((image.unsafe_at(x, y).r == 1.f) != contains(region, x, y)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/// Whether exactly the pixels of `region` differ from the black clear color
+auto drawn_exactly(const Image& image, const yasr::Region& region) -> bool
+{
+  for (int y = 0; y < image.height(); ++y) {
+    for (int x = 0; x < image.width(); ++x) {
+      if ((image.unsafe_at(x, y).r > 0.f) != contains(region, x, y)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+TEST_CASE("Viewports map normalized coordinates to a part of the framebuffer")
+{
+  FlatQuadScene scene;
+  REQUIRE(lit_exactly(scene.draw(), yasr::Region{.x = 0,
+                                                 .y = 0,
+                                                 .width = frame_size,
+                                                 .height = frame_size}));
+
+  const yasr::Region viewport{.x = 16, .y = 8, .width = 64, .height = 32};
+  scene.device().set_viewport(viewport);
+  REQUIRE(lit_exactly(scene.draw(), viewport));
+}
+
+TEST_CASE("Scissors limit the pixels drawn inside the viewport")
+{
+  FlatQuadScene scene;
+  scene.device().set_scissor(
+      yasr::Region{.x = 60, .y = 0, .width = 10, .height = frame_size});
+  REQUIRE(lit_exactly(scene.draw(), yasr::Region{.x = 60,
+                                                 .y = 0,
+                                                 .width = 10,
+                                                 .height = frame_size}));
+
+  // Only the overlap of the viewport and the scissor is drawn
+  scene.device().set_viewport(
+      yasr::Region{.x = 0, .y = 0, .width = 64, .height = frame_size});
+  scene.device().set_scissor(
+      yasr::Region{.x = 40, .y = 30, .width = 40, .height = 40});
+  REQUIRE(lit_exactly(scene.draw(), yasr::Region{.x = 40,
+                                                 .y = 30,
+                                                 .width = 24,
+                                                 .height = 40}));
+}
+
+TEST_CASE("Built-in shading stays inside unaligned viewports and scissors")
+{
+  // A quad far larger than the view, so its triangles cover every pixel and
+  // cross the guard band
+  const auto device = yasr::Device::create({.thread_count = 2});
+  auto scene = yasr::test::make_quad_scene(*device, frame_size,
+                                           {.min = -10, .max = 10});
+  scene.bind(*device);
+  device->set_camera(yasr::Camera{.eye = {0, 0, 3}});
+  device->set_cull_mode(yasr::CullMode::none);
+  const auto draw = [&]() -> const Image& {
+    device->clear(yasr::ClearValue{});
+    device->draw_indexed();
+    return device->framebuffer_image(scene.framebuffer);
+  };
+
+  SECTION("With a scissor")
+  {
+    const yasr::Region scissor{.x = 5, .y = 3, .width = 13, .height = 20};
+    device->set_scissor(scissor);
+    REQUIRE(drawn_exactly(draw(), scissor));
+  }
+
+  SECTION("With a viewport")
+  {
+    const yasr::Region viewport{.x = 5, .y = 3, .width = 37, .height = 29};
+    device->set_viewport(viewport);
+    REQUIRE(drawn_exactly(draw(), viewport));
+  }
+
+  SECTION("With both")
+  {
+    device->set_viewport(
+        yasr::Region{.x = 3, .y = 0, .width = 61, .height = frame_size});
+    device->set_scissor(
+        yasr::Region{.x = 41, .y = 30, .width = 40, .height = 40});
+    REQUIRE(drawn_exactly(draw(), yasr::Region{.x = 41,
+                                               .y = 30,
+                                               .width = 23,
+                                               .height = 40}));
+  }
+}
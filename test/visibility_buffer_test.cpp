@@ -0,0 +1,138 @@
+#include <catch2/catch.hpp>
+
+#include "pipeline.hpp"
+#include "render_test_util.hpp"
+#include "yasr_raii.hpp"
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace {
+
+using yasr::test::same_pixels;
+
+// Spans several tiles in both directions
+constexpr std::uint32_t frame_size = 160;
+
+// No texel is black, so covered pixels differ from the clear color
+constexpr std::array<std::uint8_t, 16> checker_texels{
+    255, 255, 255, 255, 64,  64,  64,  255,
+    64,  64,  64,  255, 255, 255, 255, 255,
+};
+// A far quad drawn before a nearer one that hides most of it
+constexpr std::array<std::uint32_t, 12> indices{0, 1, 2, 0, 2, 3,
+                                                4, 5, 6, 4, 6, 7};
+const std::array vertices{
+    Vertex{.pos = {-1, -1, -1}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+    Vertex{.pos = {1, -1, -1}, .normal = {0, 0, 1}, .texcoord = {1, 0}},
+    Vertex{.pos = {1, 1, -1}, .normal = {0, 0, 1}, .texcoord = {1, 1}},
+    Vertex{.pos = {-1, 1, -1}, .normal = {0, 0, 1}, .texcoord = {0, 1}},
+    Vertex{.pos = {-0.8f, -0.7f, 0}, .normal = {0, 0, 1}, .texcoord = {0, 0}},
+    Vertex{.pos = {0.6f, -0.9f, 0}, .normal = {0, 0, 1}, .texcoord = {1, 0}},
+    Vertex{.pos = {0.7f, 0.8f, 0}, .normal = {0, 0, 1}, .texcoord = {1, 1}},
+    Vertex{.pos = {-0.9f, 0.6f, 0}, .normal = {0, 0, 1}, .texcoord = {0, 1}},
+};
+
+struct Uniforms {
+  beyond::Mat4 mvp;
+};
+
+struct Varyings {
+  float u = 0;
+  float v = 0;
+};
+
+/// Draws the quads with `mode` and returns the image
+auto draw(yasr::Device& device, yasr::Framebuffer framebuffer,
+          yasr::ShadingMode mode) -> Image
+{
+  device.set_shading_mode(mode);
+  device.clear(yasr::ClearValue{});
+  device.begin_frame();
+  device.draw_indexed();
+  return device.framebuffer_image(framebuffer);
+}
+
+} // anonymous namespace
+
+TEST_CASE("Visibility buffers shade each pixel once with the same result")
+{
+  const auto device = yasr::Device::create({.thread_count = 2});
+  auto vertex_buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{vertices})});
+  auto index_buffer = yasr::create_unique_buffer(
+      *device, {.data = std::as_bytes(std::span{indices})});
+  auto texture = yasr::create_unique_texture(
+      *device, {.width = 2,
+                .height = 2,
+                .data = std::as_bytes(std::span{checker_texels})});
+  auto framebuffer = yasr::create_unique_framebuffer(
+      *device, {.width = frame_size, .height = frame_size});
+  device->bind_framebuffer(framebuffer);
+  device->bind_vertex_buffer(vertex_buffer);
+  device->bind_index_buffer(index_buffer);
+  device->bind_texture(texture);
+  device->set_cull_mode(yasr::CullMode::none);
+  device->set_camera(yasr::Camera{.eye = {0.3f, 0.2f, 3}});
+
+  SECTION("With the built-in shading")
+  {
+    const Image immediate =
+        draw(*device, framebuffer, yasr::ShadingMode::immediate);
+    const yasr::PipelineStats immediate_stats = device->pipeline_stats();
+    const Image deferred =
+        draw(*device, framebuffer, yasr::ShadingMode::visibility_buffer);
+    const yasr::PipelineStats stats = device->pipeline_stats();
+
+    REQUIRE(same_pixels(immediate, deferred));
+    REQUIRE(immediate_stats.fragments_shaded ==
+            immediate_stats.fragments_passed);
+    REQUIRE(stats.fragments_passed == immediate_stats.fragments_passed);
+
+    // The near quad was drawn over the far one, but each pixel was shaded
+    // once
+    std::uint64_t covered = 0;
+    for (int y = 0; y < deferred.height(); ++y) {
+      for (int x = 0; x < deferred.width(); ++x) {
+        const RGB& pixel = deferred.unsafe_at(x, y);
+        if (pixel.r != 0 || pixel.g != 0 || pixel.b != 0) { ++covered; }
+      }
+    }
+    REQUIRE(stats.fragments_shaded < stats.fragments_passed);
+    REQUIRE(stats.fragments_shaded == covered);
+    REQUIRE(stats.texels_fetched < immediate_stats.texels_fetched);
+  }
+
+  SECTION("With a pipeline")
+  {
+    const Uniforms uniforms{.mvp = yasr::view_projection(
+                                yasr::Camera{.eye = {0.3f, 0.2f, 3}}, 1)};
+    auto constant_buffer = yasr::create_unique_buffer(
+        *device, {.data = std::as_bytes(std::span{&uniforms, 1})});
+    auto pipeline = yasr::create_unique_pipeline(
+        *device,
+        yasr::make_pipeline<Uniforms, Varyings>(
+            [](const Vertex& vertex, const Uniforms& constants) {
+              return yasr::ShadedVertex<Varyings>{
+                  .position = yasr::transform_to_clip(constants.mvp,
+                                                      vertex.pos),
+                  .varyings = {vertex.texcoord.x, vertex.texcoord.y}};
+            },
+            [](const Varyings& varyings, const Uniforms&,
+               const yasr::TextureView&) {
+              return RGB{varyings.u, varyings.v, 1};
+            }));
+    device->bind_constant_buffer(constant_buffer);
+    device->bind_pipeline(pipeline);
+
+    const Image immediate =
+        draw(*device, framebuffer, yasr::ShadingMode::immediate);
+    const yasr::PipelineStats immediate_stats = device->pipeline_stats();
+    const Image deferred =
+        draw(*device, framebuffer, yasr::ShadingMode::visibility_buffer);
+    REQUIRE(same_pixels(immediate, deferred));
+    REQUIRE(device->pipeline_stats().fragments_shaded <
+            immediate_stats.fragments_shaded);
+  }
+}